@@ -0,0 +1,60 @@
+#include "GeometryGenerator.h"
+#include "ParallelFor.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+namespace
+{
+    // Each subdivision level quadruples the triangle count, so the later levels show how
+    // the shared-midpoint Subdivide scales.
+    void BM_CreateGeosphere(benchmark::State& state)
+    {
+        GeometryGenerator geoGen;
+        const std::uint32_t subdivisions = (std::uint32_t)state.range(0);
+
+        std::size_t vertexCount = 0;
+        for (auto _ : state)
+        {
+            GeometryGenerator::MeshData mesh = geoGen.CreateGeosphere(1.0f, subdivisions);
+            vertexCount = mesh.Vertices.size();
+            benchmark::DoNotOptimize(mesh.Vertices.data());
+        }
+        state.SetItemsProcessed((std::int64_t)state.iterations() * (std::int64_t)vertexCount);
+        state.counters["Vertices"] = (double)vertexCount;
+    }
+    BENCHMARK(BM_CreateGeosphere)->DenseRange(0, 8)->Unit(benchmark::kMillisecond);
+
+    // ApplyHills on an n x n grid, split into row blocks by ParallelForRows.  Argument 1
+    // picks the default executor: 0 = SerialExecutor, 1 = the shared ThreadPool.
+    void BM_ApplyHills(benchmark::State& state)
+    {
+        const std::uint32_t n = (std::uint32_t)state.range(0);
+        const bool serial = state.range(1) == 0;
+
+        GeometryGenerator geoGen;
+        const GeometryGenerator::MeshData source = geoGen.CreateGrid(160.0f, 160.0f, n, n);
+        GeometryGenerator::MeshData grid = source;
+
+        SerialExecutor serialExecutor;
+        SetDefaultExecutor(serial ? &serialExecutor : nullptr);
+
+        for (auto _ : state)
+        {
+            GeometryGenerator::ApplyHills(grid, n);
+            benchmark::DoNotOptimize(grid.Vertices.data());
+            benchmark::ClobberMemory();
+        }
+
+        SetDefaultExecutor(nullptr);
+
+        state.SetItemsProcessed((std::int64_t)state.iterations() * (std::int64_t)grid.Vertices.size());
+        state.counters["Threads"] = (double)(serial ? 1 : GetDefaultExecutor().Concurrency());
+    }
+    BENCHMARK(BM_ApplyHills)
+        ->ArgsProduct({ { 128, 512, 2048 }, { 0, 1 } })
+        ->ArgNames({ "n", "pool" })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
+}
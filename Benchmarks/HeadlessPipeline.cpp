@@ -0,0 +1,313 @@
+// WEHeadlessBenchmark: the game's per-frame CPU stages (FrameStages.h) on a synthetic scene
+// of engine render items and materials, without D3D12.  The frame resources are system
+// memory with UploadBuffer's element layout and the FrameConstants.h structs, standing in
+// for FrameResource's upload heaps.  The camera is fixed, and the material animation and
+// pass constant stages of "WE.exe -benchmark" are left out.
+//
+//   WEHeadlessBenchmark [frames=N] [items=N] [instances=N] [materials=N] [waves=N]
+//                       [frameresources=N] [trace=file.json]
+//
+// Prints mean/p50/p99 milliseconds per stage, like "WE.exe -benchmark".
+
+#include "CommandLineOptions.h"
+#include "FrameStages.h"
+#include "HeadlessBenchmarkDesc.h"
+#include "Profiler.h"
+#include "StageTimer.h"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <vector>
+
+using namespace DirectX;
+
+// Owned by FrameResource.cpp in the game.
+int gNumFrameResources = NUM_FRAME_RESOURCES;
+
+namespace
+{
+    const float NearZ = 1.0f;
+    const float FarZ = 1000.0f;
+
+    // Geometries the render items are spread over, so the draw sort has state to group by.
+    const int GeometryCount = 8;
+
+    // System-memory buffer with UploadBuffer's interface and element layout: constant
+    // buffer elements are padded to 256 bytes, the others are packed.
+    template<typename T>
+    class SystemBuffer
+    {
+    public:
+        SystemBuffer(UINT elementCount, bool isConstantBuffer)
+            : mElementByteSize(isConstantBuffer ? ((UINT)sizeof(T) + 255) & ~255u : (UINT)sizeof(T))
+            , mData((size_t)mElementByteSize * elementCount)
+        {
+        }
+
+        void CopyData(int elementIndex, const T& data)
+        {
+            std::memcpy(&mData[(size_t)elementIndex * mElementByteSize], &data, sizeof(T));
+        }
+
+        T* MappedData() { return reinterpret_cast<T*>(mData.data()); }
+
+    private:
+        UINT mElementByteSize = 0;
+        std::vector<unsigned char> mData;
+    };
+
+    // The buffers of FrameResource that the stages write.
+    struct SystemFrameResource
+    {
+        SystemFrameResource(UINT objectCount, UINT materialCount, UINT waveVertCount, UINT instanceCount)
+            : ObjectCB(objectCount, true)
+            , MaterialCB(materialCount, true)
+            , WavesVB(waveVertCount, false)
+            , InstanceBuffer(instanceCount, false)
+        {
+        }
+
+        SystemBuffer<ObjectConstants> ObjectCB;
+        SystemBuffer<MaterialConstants> MaterialCB;
+        SystemBuffer<Vertex> WavesVB;
+        std::uint64_t WavesVersion = 0;
+        SystemBuffer<InstanceData> InstanceBuffer;
+    };
+
+    void PrintLine(const char* line)
+    {
+        fputs(line, stdout);
+    }
+
+    XMFLOAT4X4 RandomTranslation()
+    {
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, XMMatrixTranslation(
+            MathHelper::RandF(-100.0f, 100.0f), MathHelper::RandF(0.0f, 10.0f), MathHelper::RandF(-100.0f, 100.0f)));
+        return world;
+    }
+
+    int RunPipeline(const HeadlessBenchmarkDesc& desc)
+    {
+        gNumFrameResources = desc.FrameResourceCount;
+
+        //
+        // Synthetic scene: the same shape as D3D12::RunHeadlessBenchmark builds.
+        //
+
+        std::vector<std::unique_ptr<Material>> materials;
+        DirtyList<Material> dirtyMaterials;
+        for (int i = 0; i < desc.MaterialCount; ++i)
+        {
+            auto mat = std::make_unique<Material>();
+            mat->MatCBIndex = i;
+            mat->DiffuseSrvHeapIndex = i % 16;
+            mat->DiffuseAlbedo = XMFLOAT4(MathHelper::RandF(), MathHelper::RandF(), MathHelper::RandF(), 1.0f);
+            mat->Roughness = MathHelper::RandF();
+            dirtyMaterials.Mark(mat.get());
+            materials.push_back(std::move(mat));
+        }
+
+        std::vector<std::unique_ptr<MeshGeometry>> geometries;
+        for (int i = 0; i < GeometryCount; ++i)
+        {
+            auto geo = std::make_unique<MeshGeometry>();
+            geo->SortId = (UINT)i;
+            geometries.push_back(std::move(geo));
+        }
+
+        std::vector<std::unique_ptr<RenderItem>> items;
+        std::vector<RenderItem*> opaqueLayer;
+        DirtyList<RenderItem> dirtyItems;
+        for (int i = 0; i < desc.RenderItemCount; ++i)
+        {
+            auto item = std::make_unique<RenderItem>();
+            item->World = RandomTranslation();
+            item->ObjectCBIndex = (UINT)i;
+            item->Mat = materials[MathHelper::Rand(0, (int)materials.size() - 1)].get();
+            item->Geo = geometries[i % GeometryCount].get();
+            item->Bounds.Radius = MathHelper::RandF(0.5f, 4.0f);
+            dirtyItems.Mark(item.get());
+            opaqueLayer.push_back(item.get());
+            items.push_back(std::move(item));
+        }
+
+        // One instanced item spread over the same area.
+        std::vector<std::unique_ptr<InstancedRenderItem>> instancedItems;
+        if (desc.InstanceCount > 0)
+        {
+            auto instanced = std::make_unique<InstancedRenderItem>();
+            instanced->Mat = materials[0].get();
+            instanced->Geo = geometries[0].get();
+            instanced->Bounds.Radius = 2.0f;
+            instanced->Instances.resize(desc.InstanceCount);
+            for (RenderInstance& instance : instanced->Instances)
+            {
+                instance.World = RandomTranslation();
+                instance.Mat = materials[MathHelper::Rand(0, (int)materials.size() - 1)].get();
+            }
+            instancedItems.push_back(std::move(instanced));
+        }
+
+        Waves waves(desc.WaveRowCount, desc.WaveColumnCount, 1.0f, 0.03f, 4.0f, 0.2f);
+
+        std::vector<std::unique_ptr<SystemFrameResource>> frameResources;
+        for (int i = 0; i < gNumFrameResources; ++i)
+        {
+            frameResources.push_back(std::make_unique<SystemFrameResource>((UINT)items.size(), (UINT)materials.size(),
+                (UINT)waves.VertexCount(), (UINT)desc.InstanceCount));
+        }
+
+        SphereCullSet cullSet;
+        cullSet.Resize((std::uint32_t)items.size());
+        SphereCullSet instanceCullSet;
+        instanceCullSet.Resize((std::uint32_t)desc.InstanceCount);
+
+        // Looking at the middle of the scene from outside, so part of it is culled.
+        XMFLOAT4X4 view;
+        XMStoreFloat4x4(&view, XMMatrixLookAtLH(XMVectorSet(0.0f, 60.0f, -120.0f, 1.0f),
+            XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)));
+        const XMMATRIX viewProj = XMMatrixMultiply(XMLoadFloat4x4(&view),
+            XMMatrixPerspectiveFovLH(0.25f * XM_PI, 800.0f / 600.0f, NearZ, FarZ));
+        const FrustumPlanes frustum = FrustumPlanes::FromViewProj(viewProj);
+
+        std::vector<std::uint8_t> visible;
+        std::vector<std::uint8_t> instanceVisible;
+        std::vector<RenderItem*> visibleItems;
+        DrawSortScratch sortScratch;
+        std::vector<std::pair<int, int>> wavesDirtyRows;
+
+        //
+        // Frame loop: dirty a fixed share of items and materials, then run the stages.
+        //
+
+        StageSamples objectStage;       objectStage.Name = "UpdateObjectCBs";
+        StageSamples materialStage;     materialStage.Name = "UpdateMaterialCBs";
+        StageSamples wavesStage;        wavesStage.Name = "UpdateWaves";
+        StageSamples cullStage;         cullStage.Name = "CullRenderItems";
+        StageSamples sortStage;         sortStage.Name = "SortRenderItems";
+        StageSamples instanceStage;     instanceStage.Name = "UpdateInstanceBuffer";
+        StageSamples frameStage;        frameStage.Name = "Frame";
+
+        const int dirtyItemCount = (int)(desc.DirtyRenderItemFraction * (float)items.size());
+        const int dirtyMaterialCount = (int)(desc.DirtyMaterialFraction * (float)materials.size());
+        size_t nextDirtyItem = 0;
+        size_t nextDirtyMaterial = 0;
+        float totalTime = 0.0f;
+        float lastDisturbTime = 0.0f;
+
+        const int totalFrameCount = desc.WarmupFrameCount + desc.FrameCount;
+        for (int frame = 0; frame < totalFrameCount; ++frame)
+        {
+            const bool record = frame >= desc.WarmupFrameCount;
+
+            if (frame == desc.WarmupFrameCount && !desc.TraceFilename.empty())
+            {
+                Profiler::CaptureFrames(desc.FrameCount, desc.TraceFilename);
+            }
+
+            totalTime += desc.DeltaTime;
+
+            for (int i = 0; i < dirtyItemCount; ++i)
+            {
+                RenderItem* item = items[nextDirtyItem].get();
+                item->World(3, 1) += 0.01f;
+                dirtyItems.Mark(item);
+                nextDirtyItem = (nextDirtyItem + 1) % items.size();
+            }
+
+            for (int i = 0; i < dirtyMaterialCount; ++i)
+            {
+                Material* mat = materials[nextDirtyMaterial].get();
+                mat->Roughness = MathHelper::RandF();
+                dirtyMaterials.Mark(mat);
+                nextDirtyMaterial = (nextDirtyMaterial + 1) % materials.size();
+            }
+
+            SystemFrameResource& frameResource = *frameResources[frame % gNumFrameResources];
+
+            TimeStage(frameStage, record, [&]()
+            {
+                TimeStage(objectStage, record, [&]()
+                {
+                    PROFILE_ZONE("UpdateObjectCBs");
+                    WriteObjectConstants(dirtyItems, frameResource.ObjectCB, cullSet);
+                });
+
+                TimeStage(materialStage, record, [&]()
+                {
+                    PROFILE_ZONE("UpdateMaterialCBs");
+                    WriteMaterialConstants(dirtyMaterials, frameResource.MaterialCB);
+                });
+
+                TimeStage(wavesStage, record, [&]()
+                {
+                    PROFILE_ZONE("UpdateWaves");
+                    StepWaves(waves, totalTime, desc.DeltaTime, lastDisturbTime);
+                    WriteWaveVertices(waves, frameResource.WavesVersion, frameResource.WavesVB.MappedData(), wavesDirtyRows);
+                });
+
+                TimeStage(cullStage, record, [&]()
+                {
+                    PROFILE_ZONE("CullRenderItems");
+                    cullSet.Cull(frustum, visible);
+                    UpdateInstanceBounds(instancedItems, instanceCullSet);
+                    instanceCullSet.Cull(frustum, instanceVisible);
+                    GatherVisibleItems(opaqueLayer, visible, visibleItems);
+                });
+
+                TimeStage(sortStage, record, [&]()
+                {
+                    PROFILE_ZONE("SortRenderItems");
+                    SortLayer(visibleItems, (int)RenderLayer::Opaque, cullSet, view, NearZ, FarZ, sortScratch);
+                });
+
+                TimeStage(instanceStage, record, [&]()
+                {
+                    PROFILE_ZONE("UpdateInstanceBuffer");
+                    WriteVisibleInstances(instancedItems, instanceVisible, frameResource.InstanceBuffer.MappedData());
+                });
+            });
+
+            Profiler::EndFrame();
+        }
+
+        printf("Headless benchmark: %d frames (+%d warmup), %d render items, %d materials, %dx%d waves, %d frame resources\n",
+            desc.FrameCount, desc.WarmupFrameCount, (int)items.size(), (int)materials.size(),
+            desc.WaveRowCount, desc.WaveColumnCount, gNumFrameResources);
+        PrintStageHeader(PrintLine);
+
+        for (const StageSamples* stage : { &objectStage, &materialStage, &wavesStage, &cullStage, &sortStage, &instanceStage, &frameStage })
+        {
+            PrintStage(*stage, PrintLine);
+        }
+
+        UINT visibleInstanceCount = 0;
+        for (auto& item : instancedItems)
+        {
+            visibleInstanceCount += item->VisibleCount;
+        }
+        printf("Culling: %d of %d render items and %u of %d instances visible in the last frame\n",
+            (int)visibleItems.size(), (int)items.size(), visibleInstanceCount, desc.InstanceCount);
+        fflush(stdout);
+
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        HeadlessBenchmarkDesc desc;
+        desc.ReadOptions(CommandLineOptions(std::vector<std::string>(argv + 1, argv + argc)));
+        return RunPipeline(desc);
+    }
+    catch (std::exception& e)
+    {
+        fprintf(stderr, "WEHeadlessBenchmark: %s\n", e.what());
+        return 1;
+    }
+}
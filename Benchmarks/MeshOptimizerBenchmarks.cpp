@@ -0,0 +1,142 @@
+#include "MeshOptimizer.h"
+#include "MeshTextParser.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Triangles of a size x size vertex grid in random order: the load-time input the
+    // optimizer has most work on.
+    std::vector<std::uint32_t> ShuffledGridIndices(std::uint32_t size, std::size_t& vertexCount)
+    {
+        vertexCount = (std::size_t)size * size;
+
+        std::vector<std::array<std::uint32_t, 3>> triangles;
+        for (std::uint32_t i = 0; i + 1 < size; ++i)
+        {
+            for (std::uint32_t j = 0; j + 1 < size; ++j)
+            {
+                const std::uint32_t v = i * size + j;
+                triangles.push_back({ v, v + 1, v + size });
+                triangles.push_back({ v + size, v + 1, v + size + 1 });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(3));
+
+        std::vector<std::uint32_t> indices;
+        for (const auto& t : triangles)
+        {
+            indices.insert(indices.end(), t.begin(), t.end());
+        }
+        return indices;
+    }
+
+    void BM_MeshOptimizer_VertexCache(benchmark::State& state)
+    {
+        std::size_t vertexCount = 0;
+        const std::vector<std::uint32_t> source = ShuffledGridIndices((std::uint32_t)state.range(0), vertexCount);
+        std::vector<std::uint32_t> indices;
+
+        for (auto _ : state)
+        {
+            indices = source;
+            MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+            benchmark::DoNotOptimize(indices.data());
+        }
+        state.SetItemsProcessed((std::int64_t)state.iterations() * (std::int64_t)(source.size() / 3));
+        state.counters["ACMR"] = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount).ACMR;
+    }
+    BENCHMARK(BM_MeshOptimizer_VertexCache)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+    void BM_MeshOptimizer_VertexFetch(benchmark::State& state)
+    {
+        std::size_t vertexCount = 0;
+        const std::vector<std::uint32_t> source = ShuffledGridIndices((std::uint32_t)state.range(0), vertexCount);
+        std::vector<std::uint32_t> indices;
+        std::vector<std::uint32_t> remap;
+
+        for (auto _ : state)
+        {
+            indices = source;
+            benchmark::DoNotOptimize(MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(), vertexCount, remap));
+        }
+        state.SetItemsProcessed((std::int64_t)state.iterations() * (std::int64_t)(source.size() / 3));
+    }
+    BENCHMARK(BM_MeshOptimizer_VertexFetch)->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+    struct ModelVertex
+    {
+        float Pos[3];
+        float Normal[3];
+        float TexC[2];
+    };
+
+    bool LoadModel(const char* filename, std::vector<ModelVertex>& vertices, std::vector<std::uint32_t>& indices)
+    {
+        std::ifstream fin(filename, std::ios::binary);
+        const std::string text((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+
+        MeshTextParser parser(text.data(), text.data() + text.size());
+        if (!parser.ParseHeader())
+        {
+            return false;
+        }
+        vertices.resize(parser.VertexCount());
+        indices.resize(3 * (size_t)parser.TriangleCount());
+        return parser.ParseVertices(vertices.data(), sizeof(ModelVertex),
+            offsetof(ModelVertex, Pos), offsetof(ModelVertex, Normal), offsetof(ModelVertex, TexC)) &&
+            parser.ParseIndices(indices.data());
+    }
+
+    // The whole load-time pass MeshLoader::OptimizeMesh runs on a shipped model, with the
+    // cache statistics it logs reported as counters.
+    void OptimizeModel(benchmark::State& state, const char* filename)
+    {
+        std::vector<ModelVertex> sourceVertices;
+        std::vector<std::uint32_t> sourceIndices;
+        if (!LoadModel(filename, sourceVertices, sourceIndices))
+        {
+            state.SkipWithError("model not found; run from the repository root");
+            return;
+        }
+
+        MeshOptimizer::Report report;
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            std::vector<ModelVertex> vertices = sourceVertices;
+            std::vector<std::uint32_t> indices = sourceIndices;
+            state.ResumeTiming();
+
+            report = MeshOptimizer::Optimize(vertices, indices);
+            benchmark::DoNotOptimize(indices.data());
+        }
+        state.SetItemsProcessed((std::int64_t)state.iterations() * (std::int64_t)(sourceIndices.size() / 3));
+        state.counters["ACMRBefore"] = report.Before.ACMR;
+        state.counters["ACMRAfter"] = report.After.ACMR;
+        state.counters["ATVRBefore"] = report.Before.ATVR;
+        state.counters["ATVRAfter"] = report.After.ATVR;
+    }
+
+    void BM_MeshOptimizer_Skull(benchmark::State& state)
+    {
+        OptimizeModel(state, "Models/skull.txt");
+    }
+    BENCHMARK(BM_MeshOptimizer_Skull)->Unit(benchmark::kMillisecond);
+
+    void BM_MeshOptimizer_Car(benchmark::State& state)
+    {
+        OptimizeModel(state, "Models/car.txt");
+    }
+    BENCHMARK(BM_MeshOptimizer_Car)->Unit(benchmark::kMillisecond);
+}
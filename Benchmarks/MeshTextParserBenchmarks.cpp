@@ -0,0 +1,155 @@
+#include "MeshFile.h"
+#include "MeshTextParser.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct BenchVertex
+    {
+        float Pos[3];
+        float Normal[3];
+        float TexC[2];
+    };
+
+    const std::string& SkullText()
+    {
+        static const std::string text = []()
+        {
+            std::ifstream fin("Models/skull.txt", std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+        }();
+        return text;
+    }
+
+    void BM_MeshTextParser_Skull(benchmark::State& state)
+    {
+        const std::string& text = SkullText();
+        if (text.empty())
+        {
+            state.SkipWithError("Models/skull.txt not found; run from the repository root");
+            return;
+        }
+
+        std::vector<BenchVertex> vertices;
+        std::vector<std::uint32_t> indices;
+        for (auto _ : state)
+        {
+            MeshTextParser parser(text.data(), text.data() + text.size());
+            bool parsed = parser.ParseHeader();
+            vertices.resize(parser.VertexCount());
+            indices.resize(3 * (size_t)parser.TriangleCount());
+            parsed = parsed && parser.ParseVertices(vertices.data(), sizeof(BenchVertex),
+                offsetof(BenchVertex, Pos), offsetof(BenchVertex, Normal), offsetof(BenchVertex, TexC)) &&
+                parser.ParseIndices(indices.data());
+            benchmark::DoNotOptimize(parsed);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed((std::int64_t)state.iterations() * (std::int64_t)text.size());
+    }
+    BENCHMARK(BM_MeshTextParser_Skull)->Unit(benchmark::kMillisecond);
+
+    // The same mesh read back from its *.wem cache, which is what LoadCachedMesh does on
+    // every run after the first.  Both read from memory, so the difference is the parse.
+    void BM_MeshFile_Skull(benchmark::State& state)
+    {
+        const std::string& text = SkullText();
+        if (text.empty())
+        {
+            state.SkipWithError("Models/skull.txt not found; run from the repository root");
+            return;
+        }
+
+        std::vector<BenchVertex> vertices;
+        std::vector<std::uint32_t> indices;
+        MeshTextParser parser(text.data(), text.data() + text.size());
+        bool parsed = parser.ParseHeader();
+        vertices.resize(parser.VertexCount());
+        indices.resize(3 * (size_t)parser.TriangleCount());
+        parsed = parsed && parser.ParseVertices(vertices.data(), sizeof(BenchVertex),
+            offsetof(BenchVertex, Pos), offsetof(BenchVertex, Normal), offsetof(BenchVertex, TexC)) &&
+            parser.ParseIndices(indices.data());
+
+        std::vector<MeshFileSubmesh> submeshes(1);
+        MeshFile::SetName(submeshes[0], "skull");
+        submeshes[0].IndexCount = (std::uint32_t)indices.size();
+
+        std::ostringstream out(std::ios::binary);
+        if (!parsed || !MeshFile::WriteMesh(out, submeshes, vertices.data(), (std::uint32_t)vertices.size(),
+            sizeof(BenchVertex), indices))
+        {
+            state.SkipWithError("could not build the skull mesh file");
+            return;
+        }
+        std::istringstream in(out.str(), std::ios::binary);
+
+        std::vector<BenchVertex> loadedVertices;
+        std::vector<char> loadedIndices;
+        auto Allocate = [&](const MeshFileHeader& header, void*& vertexData, void*& indexData)
+        {
+            loadedVertices.resize(header.VertexCount);
+            loadedIndices.resize((size_t)MeshFile::IndexDataSize(header));
+            vertexData = loadedVertices.data();
+            indexData = loadedIndices.data();
+            return true;
+        };
+
+        for (auto _ : state)
+        {
+            in.clear();
+            in.seekg(0);
+            MeshFileHeader header;
+            benchmark::DoNotOptimize(MeshFile::Read(in, sizeof(BenchVertex), header, submeshes, Allocate));
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed((std::int64_t)state.iterations() * (std::int64_t)out.str().size());
+    }
+    BENCHMARK(BM_MeshFile_Skull)->Unit(benchmark::kMillisecond);
+
+    // The istream >> reader the parser replaced, for comparison.
+    void BM_StreamReader_Skull(benchmark::State& state)
+    {
+        const std::string& text = SkullText();
+        if (text.empty())
+        {
+            state.SkipWithError("Models/skull.txt not found; run from the repository root");
+            return;
+        }
+
+        std::vector<BenchVertex> vertices;
+        std::vector<std::uint32_t> indices;
+        for (auto _ : state)
+        {
+            std::istringstream in(text);
+            std::string ignore;
+            std::uint32_t vertexCount = 0;
+            std::uint32_t triangleCount = 0;
+            in >> ignore >> vertexCount >> ignore >> triangleCount;
+            in >> ignore >> ignore >> ignore >> ignore;
+
+            vertices.resize(vertexCount);
+            for (BenchVertex& v : vertices)
+            {
+                in >> v.Pos[0] >> v.Pos[1] >> v.Pos[2] >> v.Normal[0] >> v.Normal[1] >> v.Normal[2];
+            }
+            in >> ignore >> ignore >> ignore;
+
+            indices.resize(3 * (size_t)triangleCount);
+            for (std::uint32_t& index : indices)
+            {
+                in >> index;
+            }
+            benchmark::DoNotOptimize(in.fail());
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed((std::int64_t)state.iterations() * (std::int64_t)text.size());
+    }
+    BENCHMARK(BM_StreamReader_Skull)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,240 @@
+#include "Waves.h"
+#include "StreamCopy.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Same layout as the engine's Vertex.
+    struct BenchVertex
+    {
+        XMFLOAT3 Pos;
+        XMFLOAT3 Normal;
+        XMFLOAT2 TexC;
+    };
+
+    // Starts a few ripples, so heights and normals are not all equal.
+    void Ripple(Waves& waves)
+    {
+        const int size = waves.RowCount();
+        for (int k = 0; k < 16; ++k)
+        {
+            waves.Disturb(4 + (k * 37) % (size - 8), 4 + (k * 53) % (size - 8), 0.5f);
+        }
+        waves.Step(8);
+    }
+
+    // Stands in for a mapped upload heap: 64-byte aligned and only ever written.
+    struct UploadTarget
+    {
+        explicit UploadTarget(size_t byteSize) : Storage(byteSize + 64) {}
+
+        void* Data()
+        {
+            return (void*)(((std::uintptr_t)Storage.data() + 63) & ~(std::uintptr_t)63);
+        }
+
+        std::vector<unsigned char> Storage;
+    };
+
+    void BM_Waves_WriteVertices(benchmark::State& state)
+    {
+        const int size = (int)state.range(0);
+        Waves waves(size, size, 1.0f, 0.03f, 4.0f, 0.2f);
+        Ripple(waves);
+        UploadTarget target((size_t)waves.VertexCount() * sizeof(BenchVertex));
+        BenchVertex* dst = static_cast<BenchVertex*>(target.Data());
+
+        for (auto _ : state)
+        {
+            waves.WriteVertices(dst);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed((std::int64_t)state.iterations() * waves.VertexCount() * (std::int64_t)sizeof(BenchVertex));
+    }
+    BENCHMARK(BM_Waves_WriteVertices)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+    // What UpdateWaves did before WriteVertices: one temporary Vertex and one
+    // UploadBuffer::CopyData (a memcpy) per grid point.
+    void BM_Waves_CopyDataPerVertex(benchmark::State& state)
+    {
+        const int size = (int)state.range(0);
+        Waves waves(size, size, 1.0f, 0.03f, 4.0f, 0.2f);
+        Ripple(waves);
+        UploadTarget target((size_t)waves.VertexCount() * sizeof(BenchVertex));
+        unsigned char* mapped = static_cast<unsigned char*>(target.Data());
+
+        for (auto _ : state)
+        {
+            for (int i = 0; i < waves.VertexCount(); ++i)
+            {
+                BenchVertex v;
+                v.Pos = waves.Position(i);
+                v.Normal = waves.Normal(i);
+                v.TexC.x = 0.5f + v.Pos.x / waves.Width();
+                v.TexC.y = 0.5f + v.Pos.z / waves.Depth();
+                std::memcpy(&mapped[(size_t)i * sizeof(BenchVertex)], &v, sizeof(BenchVertex));
+            }
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed((std::int64_t)state.iterations() * waves.VertexCount() * (std::int64_t)sizeof(BenchVertex));
+    }
+    BENCHMARK(BM_Waves_CopyDataPerVertex)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+    void BM_StreamCopy(benchmark::State& state)
+    {
+        const size_t byteSize = (size_t)state.range(0);
+        std::vector<unsigned char> source(byteSize, 1);
+        UploadTarget target(byteSize);
+
+        for (auto _ : state)
+        {
+            StreamCopy(target.Data(), source.data(), byteSize);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed((std::int64_t)state.iterations() * (std::int64_t)byteSize);
+    }
+    BENCHMARK(BM_StreamCopy)->Arg(64 << 10)->Arg(32 << 20);
+
+    void BM_Memcpy(benchmark::State& state)
+    {
+        const size_t byteSize = (size_t)state.range(0);
+        std::vector<unsigned char> source(byteSize, 1);
+        UploadTarget target(byteSize);
+
+        for (auto _ : state)
+        {
+            std::memcpy(target.Data(), source.data(), byteSize);
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed((std::int64_t)state.iterations() * (std::int64_t)byteSize);
+    }
+    BENCHMARK(BM_Memcpy)->Arg(64 << 10)->Arg(32 << 20);
+
+    // Simulation state one step streams per grid point: previous and current heights,
+    // normal and tangent.
+    const std::int64_t WavesBytesPerPoint = 2 * sizeof(float) + 2 * sizeof(XMFLOAT3);
+
+    // One frame's simulation step, single and temporally blocked.
+    void BM_Waves_Step(benchmark::State& state)
+    {
+        const int size = (int)state.range(0);
+        const int substeps = (int)state.range(1);
+        Waves waves(size, size, 1.0f, 0.03f, 4.0f, 0.2f);
+        Ripple(waves);
+
+        for (auto _ : state)
+        {
+            waves.Step(substeps);
+            benchmark::DoNotOptimize(waves.Height(size + 1));
+        }
+        const std::int64_t points = (std::int64_t)state.iterations() * substeps * size * size;
+        state.SetItemsProcessed(points);
+        state.SetBytesProcessed(points * WavesBytesPerPoint);
+    }
+    BENCHMARK(BM_Waves_Step)->ArgsProduct({ { 256, 1024, 4096 }, { 1, 4 } })->Unit(benchmark::kMillisecond);
+
+    // The original simulation over an array of XMFLOAT3 positions: ReferenceWaves from
+    // Tests/WavesTests.cpp plus the tangents the original also computed.  Every step
+    // streams whole positions although only y changes.
+    struct Float3Waves
+    {
+        int M;
+        int N;
+        float Dx;
+        float K1;
+        float K2;
+        float K3;
+        std::vector<XMFLOAT3> Prev;
+        std::vector<XMFLOAT3> Curr;
+        std::vector<XMFLOAT3> Normals;
+        std::vector<XMFLOAT3> TangentX;
+
+        Float3Waves(int m, int n, float dx, float dt, float speed, float damping)
+            : M(m), N(n), Dx(dx)
+        {
+            float d = damping * dt + 2.f;
+            float e = (speed*speed)*(dt*dt) / (dx*dx);
+            K1 = (damping*dt - 2.0f) / d;
+            K2 = (4.0f - 8.0f*e) / d;
+            K3 = (2.0f*e) / d;
+
+            float halfWidth = (n - 1)*dx*0.5f;
+            float halfDepth = (m - 1)*dx*0.5f;
+            for (int i = 0; i < m; ++i)
+            {
+                for (int j = 0; j < n; ++j)
+                {
+                    Prev.emplace_back(-halfWidth + j*dx, 0.0f, halfDepth - i*dx);
+                }
+            }
+            Curr = Prev;
+            Normals.assign((size_t)m*n, XMFLOAT3(0.0f, 1.0f, 0.0f));
+            TangentX.assign((size_t)m*n, XMFLOAT3(1.0f, 0.0f, 0.0f));
+
+            for (int k = 0; k < 16; ++k)
+            {
+                Curr[(size_t)(4 + (k * 37) % (m - 8))*N + 4 + (k * 53) % (n - 8)].y += 0.5f;
+            }
+        }
+
+        void Step()
+        {
+            for (int i = 1; i < M-1; ++i)
+            {
+                for (int j = 1; j < N-1; ++j)
+                {
+                    Prev[i*N+j].y =
+                        K1*Prev[i*N+j].y +
+                        K2*Curr[i*N+j].y +
+                        K3*(Curr[(i+1)*N+j].y +
+                            Curr[(i-1)*N+j].y +
+                            Curr[i*N+j+1].y +
+                            Curr[i*N+j-1].y);
+                }
+            }
+            std::swap(Prev, Curr);
+
+            for (int i = 1; i < M-1; ++i)
+            {
+                for (int j = 1; j < N-1; ++j)
+                {
+                    float l = Curr[i*N+j-1].y;
+                    float r = Curr[i*N+j+1].y;
+                    float t = Curr[(i-1)*N+j].y;
+                    float b = Curr[(i+1)*N+j].y;
+                    XMFLOAT3 normal(-r+l, 2.0f*Dx, b-t);
+                    XMStoreFloat3(&Normals[i*N+j], XMVector3Normalize(XMLoadFloat3(&normal)));
+
+                    XMFLOAT3 tangent(2.0f*Dx, r-l, 0.0f);
+                    XMStoreFloat3(&TangentX[i*N+j], XMVector3Normalize(XMLoadFloat3(&tangent)));
+                }
+            }
+        }
+    };
+
+    // Baseline for BM_Waves_Step: one step of Float3Waves.  Bytes count its previous and
+    // current positions, normal and tangent.
+    void BM_Float3Waves_Step(benchmark::State& state)
+    {
+        const int size = (int)state.range(0);
+        Float3Waves waves(size, size, 1.0f, 0.03f, 4.0f, 0.2f);
+
+        for (auto _ : state)
+        {
+            waves.Step();
+            benchmark::DoNotOptimize(waves.Curr[size + 1].y);
+        }
+        const std::int64_t points = (std::int64_t)state.iterations() * size * size;
+        state.SetItemsProcessed(points);
+        state.SetBytesProcessed(points * (std::int64_t)(4 * sizeof(XMFLOAT3)));
+    }
+    BENCHMARK(BM_Float3Waves_Step)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,71 @@
+#include "CommandLineOptions.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <stdexcept>
+
+CommandLineOptions::CommandLineOptions(const std::vector<std::string>& args)
+{
+    for (const std::string& arg : args)
+    {
+        const size_t equals = arg.find('=');
+        if (equals == std::string::npos)
+        {
+            mFlags.insert(arg);
+        }
+        else if (equals == 0)
+        {
+            throw std::invalid_argument("option without a name: " + arg);
+        }
+        else
+        {
+            mOptions[arg.substr(0, equals)] = arg.substr(equals + 1);
+        }
+    }
+}
+
+void CommandLineOptions::Read(const std::string& key, int minValue, int& value) const
+{
+    auto it = mOptions.find(key);
+    if (it == mOptions.end())
+    {
+        return;
+    }
+
+    const std::string& text = it->second;
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    errno = 0;
+    const long parsed = std::strtol(begin, &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE || parsed < minValue || parsed > INT_MAX)
+    {
+        throw std::invalid_argument(key + "=" + text + ": expected a whole number of at least " + std::to_string(minValue));
+    }
+    value = (int)parsed;
+}
+
+void CommandLineOptions::Read(const std::string& key, std::string& value) const
+{
+    auto it = mOptions.find(key);
+    if (it != mOptions.end())
+    {
+        value = it->second;
+    }
+}
+
+void CommandLineOptions::CheckKeys(std::initializer_list<const char*> knownKeys) const
+{
+    for (const auto& option : mOptions)
+    {
+        bool known = false;
+        for (const char* key : knownKeys)
+        {
+            known = known || option.first == key;
+        }
+        if (!known)
+        {
+            throw std::invalid_argument("unknown option: " + option.first + "=" + option.second);
+        }
+    }
+}
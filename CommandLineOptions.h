@@ -0,0 +1,32 @@
+#pragma once
+
+#include <initializer_list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// Command-line tokens split into flags ("-benchmark") and key=value options
+// ("frames=500").  Malformed values and unknown keys throw std::invalid_argument with a
+// message naming the token, so a typo is reported instead of silently ignored.
+class CommandLineOptions
+{
+public:
+	CommandLineOptions() = default;
+	explicit CommandLineOptions(const std::vector<std::string>& args);
+
+	bool HasFlag(const std::string& flag) const { return mFlags.count(flag) != 0; }
+	bool HasOption(const std::string& key) const { return mOptions.count(key) != 0; }
+
+	// Leaves value unchanged if key is absent.  Integers must be whole decimal numbers no
+	// smaller than minValue.
+	void Read(const std::string& key, int minValue, int& value) const;
+	void Read(const std::string& key, std::string& value) const;
+
+	// Throws for the first option whose key is not listed.
+	void CheckKeys(std::initializer_list<const char*> knownKeys) const;
+
+private:
+	std::set<std::string> mFlags;
+	std::map<std::string, std::string> mOptions;
+};
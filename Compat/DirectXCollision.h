@@ -0,0 +1,42 @@
+#pragma once
+
+// Stand-in for the DirectXCollision bounding volumes (data members and the few methods the
+// portable units use); see DirectXMath.h in this directory.
+
+#include <DirectXMath.h>
+#include <cmath>
+
+namespace DirectX
+{
+	struct BoundingSphere
+	{
+		XMFLOAT3 Center;
+		float Radius;
+
+		BoundingSphere() : Center(0.0f, 0.0f, 0.0f), Radius(1.0f) {}
+		constexpr BoundingSphere(const XMFLOAT3& center, float radius) : Center(center), Radius(radius) {}
+
+		// Transforms the center and scales the radius by the largest axis scale of M.
+		void Transform(BoundingSphere& Out, const XMMATRIX& M) const
+		{
+			XMStoreFloat3(&Out.Center, XMVector3TransformCoord(XMLoadFloat3(&Center), M));
+
+			float ScaleSq = 0.0f;
+			for (int i = 0; i < 3; ++i)
+			{
+				const float LengthSq = XMVectorGetX(XMVector3LengthSq(M.r[i]));
+				ScaleSq = LengthSq > ScaleSq ? LengthSq : ScaleSq;
+			}
+			Out.Radius = Radius * std::sqrt(ScaleSq);
+		}
+	};
+
+	struct BoundingBox
+	{
+		XMFLOAT3 Center;
+		XMFLOAT3 Extents;
+
+		BoundingBox() : Center(0.0f, 0.0f, 0.0f), Extents(1.0f, 1.0f, 1.0f) {}
+		constexpr BoundingBox(const XMFLOAT3& center, const XMFLOAT3& extents) : Center(center), Extents(extents) {}
+	};
+}
@@ -0,0 +1,404 @@
+#pragma once
+
+// Stand-in for the parts of DirectXMath that the portable units (see CMakeLists.txt) use,
+// for hosts without the Windows SDK.  Declarations follow DirectXMath; the implementation
+// is plain scalar code.  XMVectorSinCos evaluates the SDK's polynomial so tests see its
+// approximation error; other results (XMVectorReciprocalSqrt) can differ from the SDK's
+// SIMD estimates in the last bits.  Windows builds never see this file.
+
+#include <cmath>
+#include <cstdint>
+
+namespace DirectX
+{
+	constexpr float XM_PI = 3.141592654f;
+	constexpr float XM_2PI = 6.283185307f;
+	constexpr float XM_1DIV2PI = 0.159154943f;
+	constexpr float XM_PIDIV2 = 1.570796327f;
+	constexpr float XM_PIDIV4 = 0.785398163f;
+
+	struct alignas(16) XMVECTOR
+	{
+		float f[4];
+	};
+
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct XMMATRIX
+	{
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR R0, FXMVECTOR R1, FXMVECTOR R2, CXMVECTOR R3) : r{ R0, R1, R2, R3 } {}
+		XMMATRIX(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: r{ { { m00, m01, m02, m03 } }, { { m10, m11, m12, m13 } }, { { m20, m21, m22, m23 } }, { { m30, m31, m32, m33 } } } {}
+	};
+
+	typedef const XMMATRIX FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMFLOAT2
+	{
+		float x;
+		float y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float _x, float _y) : x(_x), y(_y) {}
+	};
+
+	struct XMFLOAT3
+	{
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float _x, float _y, float _z) : x(_x), y(_y), z(_z) {}
+	};
+
+	struct XMFLOAT4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+	};
+
+	struct XMFLOAT4X4
+	{
+		float m[4][4];
+
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33)
+			: m{ { m00, m01, m02, m03 }, { m10, m11, m12, m13 }, { m20, m21, m22, m23 }, { m30, m31, m32, m33 } } {}
+
+		float operator()(std::size_t Row, std::size_t Column) const { return m[Row][Column]; }
+		float& operator()(std::size_t Row, std::size_t Column) { return m[Row][Column]; }
+	};
+
+	//
+	// Load and store.
+	//
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return { { x, y, z, w } }; }
+	inline XMVECTOR XMVectorReplicate(float Value) { return { { Value, Value, Value, Value } }; }
+	inline XMVECTOR XMVectorZero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+
+	inline float XMVectorGetX(FXMVECTOR V) { return V.f[0]; }
+	inline float XMVectorGetY(FXMVECTOR V) { return V.f[1]; }
+	inline float XMVectorGetZ(FXMVECTOR V) { return V.f[2]; }
+	inline float XMVectorGetW(FXMVECTOR V) { return V.f[3]; }
+
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* p) { return { { p->x, p->y, 0.0f, 0.0f } }; }
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* p) { return { { p->x, p->y, p->z, 0.0f } }; }
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* p) { return { { p->x, p->y, p->z, p->w } }; }
+
+	inline void XMStoreFloat2(XMFLOAT2* p, FXMVECTOR V) { p->x = V.f[0]; p->y = V.f[1]; }
+	inline void XMStoreFloat3(XMFLOAT3* p, FXMVECTOR V) { p->x = V.f[0]; p->y = V.f[1]; p->z = V.f[2]; }
+	inline void XMStoreFloat4(XMFLOAT4* p, FXMVECTOR V) { p->x = V.f[0]; p->y = V.f[1]; p->z = V.f[2]; p->w = V.f[3]; }
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* p)
+	{
+		XMMATRIX M;
+		for (int i = 0; i < 4; ++i)
+		{
+			M.r[i] = { { p->m[i][0], p->m[i][1], p->m[i][2], p->m[i][3] } };
+		}
+		return M;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* p, FXMMATRIX M)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				p->m[i][j] = M.r[i].f[j];
+			}
+		}
+	}
+
+	//
+	// Per-component arithmetic.
+	//
+
+	template<typename F>
+	inline XMVECTOR XMCompatMap(FXMVECTOR V1, FXMVECTOR V2, F Op)
+	{
+		return { { Op(V1.f[0], V2.f[0]), Op(V1.f[1], V2.f[1]), Op(V1.f[2], V2.f[2]), Op(V1.f[3], V2.f[3]) } };
+	}
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR V1, FXMVECTOR V2) { return XMCompatMap(V1, V2, [](float a, float b) { return a + b; }); }
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR V1, FXMVECTOR V2) { return XMCompatMap(V1, V2, [](float a, float b) { return a - b; }); }
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR V1, FXMVECTOR V2) { return XMCompatMap(V1, V2, [](float a, float b) { return a * b; }); }
+	inline XMVECTOR XMVectorDivide(FXMVECTOR V1, FXMVECTOR V2) { return XMCompatMap(V1, V2, [](float a, float b) { return a / b; }); }
+	inline XMVECTOR XMVectorMin(FXMVECTOR V1, FXMVECTOR V2) { return XMCompatMap(V1, V2, [](float a, float b) { return a < b ? a : b; }); }
+	inline XMVECTOR XMVectorMax(FXMVECTOR V1, FXMVECTOR V2) { return XMCompatMap(V1, V2, [](float a, float b) { return a > b ? a : b; }); }
+	inline XMVECTOR XMVectorClamp(FXMVECTOR V, FXMVECTOR Min, FXMVECTOR Max) { return XMVectorMin(XMVectorMax(V, Min), Max); }
+	inline XMVECTOR XMVectorScale(FXMVECTOR V, float Scale) { return XMVectorMultiply(V, XMVectorReplicate(Scale)); }
+	inline XMVECTOR XMVectorNegate(FXMVECTOR V) { return XMVectorSubtract(XMVectorZero(), V); }
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR V1, FXMVECTOR V2, FXMVECTOR V3) { return XMVectorAdd(XMVectorMultiply(V1, V2), V3); }
+
+	inline XMVECTOR XMVectorSqrt(FXMVECTOR V)
+	{
+		return { { std::sqrt(V.f[0]), std::sqrt(V.f[1]), std::sqrt(V.f[2]), std::sqrt(V.f[3]) } };
+	}
+
+	inline XMVECTOR XMVectorReciprocalSqrt(FXMVECTOR V)
+	{
+		return XMVectorDivide(XMVectorReplicate(1.0f), XMVectorSqrt(V));
+	}
+
+	// The SDK's no-intrinsics path: reduce to [-pi, pi] (XMVectorModAngles), reflect into
+	// [-pi/2, pi/2], then the 11-degree sine and 10-degree cosine minimax polynomials of
+	// g_XMSinCoefficients and g_XMCosCoefficients.
+	inline void XMVectorSinCos(XMVECTOR* pSin, XMVECTOR* pCos, FXMVECTOR V)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			float x = V.f[i] - XM_2PI * std::nearbyint(V.f[i] * XM_1DIV2PI);
+
+			float sign = 1.0f;
+			if (x > XM_PIDIV2)
+			{
+				x = XM_PI - x;
+				sign = -1.0f;
+			}
+			else if (x < -XM_PIDIV2)
+			{
+				x = -XM_PI - x;
+				sign = -1.0f;
+			}
+
+			const float x2 = x * x;
+			pSin->f[i] = (((((-2.3889859e-08f * x2 + 2.7525562e-06f) * x2 - 0.00019840874f) * x2 +
+				0.0083333310f) * x2 - 0.16666667f) * x2 + 1.0f) * x;
+			pCos->f[i] = (((((-2.6051615e-07f * x2 + 2.4760495e-05f) * x2 - 0.0013888378f) * x2 +
+				0.041666638f) * x2 - 0.5f) * x2 + 1.0f) * sign;
+		}
+	}
+
+	inline XMVECTOR operator+(FXMVECTOR V) { return V; }
+	inline XMVECTOR operator-(FXMVECTOR V) { return XMVectorNegate(V); }
+	inline XMVECTOR operator+(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorAdd(V1, V2); }
+	inline XMVECTOR operator-(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorSubtract(V1, V2); }
+	inline XMVECTOR operator*(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorMultiply(V1, V2); }
+	inline XMVECTOR operator/(FXMVECTOR V1, FXMVECTOR V2) { return XMVectorDivide(V1, V2); }
+	inline XMVECTOR operator*(FXMVECTOR V, float S) { return XMVectorScale(V, S); }
+	inline XMVECTOR operator*(float S, FXMVECTOR V) { return XMVectorScale(V, S); }
+	inline XMVECTOR operator/(FXMVECTOR V, float S) { return XMVectorScale(V, 1.0f / S); }
+	inline XMVECTOR& operator+=(XMVECTOR& V1, FXMVECTOR V2) { V1 = V1 + V2; return V1; }
+	inline XMVECTOR& operator-=(XMVECTOR& V1, FXMVECTOR V2) { V1 = V1 - V2; return V1; }
+	inline XMVECTOR& operator*=(XMVECTOR& V1, FXMVECTOR V2) { V1 = V1 * V2; return V1; }
+	inline XMVECTOR& operator*=(XMVECTOR& V, float S) { V = V * S; return V; }
+
+	//
+	// 3D vectors and planes.
+	//
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		return XMVectorReplicate(V1.f[0] * V2.f[0] + V1.f[1] * V2.f[1] + V1.f[2] * V2.f[2]);
+	}
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		return XMVectorSet(
+			V1.f[1] * V2.f[2] - V1.f[2] * V2.f[1],
+			V1.f[2] * V2.f[0] - V1.f[0] * V2.f[2],
+			V1.f[0] * V2.f[1] - V1.f[1] * V2.f[0],
+			0.0f);
+	}
+
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR V) { return XMVector3Dot(V, V); }
+
+	// Row vector times matrix with w = 1, divided by the resulting w.
+	inline XMVECTOR XMVector3TransformCoord(FXMVECTOR V, const XMMATRIX& M)
+	{
+		XMVECTOR Result;
+		for (int Column = 0; Column < 4; ++Column)
+		{
+			Result.f[Column] = V.f[0] * M.r[0].f[Column] + V.f[1] * M.r[1].f[Column] + V.f[2] * M.r[2].f[Column] + M.r[3].f[Column];
+		}
+		const float W = Result.f[3];
+		for (int i = 0; i < 4; ++i)
+		{
+			Result.f[i] /= W;
+		}
+		return Result;
+	}
+	inline XMVECTOR XMVector3Length(FXMVECTOR V) { return XMVectorSqrt(XMVector3Dot(V, V)); }
+
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR V)
+	{
+		const float Length = XMVectorGetX(XMVector3Length(V));
+		return Length > 0.0f ? V / Length : XMVectorZero();
+	}
+
+	inline bool XMVector3Less(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		return V1.f[0] < V2.f[0] && V1.f[1] < V2.f[1] && V1.f[2] < V2.f[2];
+	}
+
+	inline bool XMVector3Greater(FXMVECTOR V1, FXMVECTOR V2)
+	{
+		return V1.f[0] > V2.f[0] && V1.f[1] > V2.f[1] && V1.f[2] > V2.f[2];
+	}
+
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR P)
+	{
+		const float Length = XMVectorGetX(XMVector3Length(P));
+		return Length > 0.0f ? P / Length : XMVectorZero();
+	}
+
+	//
+	// Matrices (row vectors, as in DirectXMath).
+	//
+
+	inline XMMATRIX XMMatrixIdentity()
+	{
+		return XMMATRIX(
+			1.0f, 0.0f, 0.0f, 0.0f,
+			0.0f, 1.0f, 0.0f, 0.0f,
+			0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX M1, CXMMATRIX M2)
+	{
+		XMMATRIX Result;
+		for (int i = 0; i < 4; ++i)
+		{
+			XMVECTOR Row = XMVectorZero();
+			for (int k = 0; k < 4; ++k)
+			{
+				Row = XMVectorMultiplyAdd(XMVectorReplicate(M1.r[i].f[k]), M2.r[k], Row);
+			}
+			Result.r[i] = Row;
+		}
+		return Result;
+	}
+
+	inline XMMATRIX operator*(FXMMATRIX M1, CXMMATRIX M2) { return XMMatrixMultiply(M1, M2); }
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX M)
+	{
+		XMMATRIX Result;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				Result.r[i].f[j] = M.r[j].f[i];
+			}
+		}
+		return Result;
+	}
+
+	// Cofactor expansion; the SDK's SIMD version gives the same results up to rounding.
+	inline XMMATRIX XMMatrixInverse(XMVECTOR* pDeterminant, FXMMATRIX M)
+	{
+		float m[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			m[i] = M.r[i / 4].f[i % 4];
+		}
+
+		float c[16];
+		c[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+		c[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+		c[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+		c[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+		c[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+		c[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+		c[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+		c[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+		c[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+		c[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+		c[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+		c[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+		c[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+		c[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+		c[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+		c[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+		const float Determinant = m[0] * c[0] + m[1] * c[4] + m[2] * c[8] + m[3] * c[12];
+		if (pDeterminant)
+		{
+			*pDeterminant = XMVectorReplicate(Determinant);
+		}
+
+		XMMATRIX Result;
+		for (int i = 0; i < 16; ++i)
+		{
+			Result.r[i / 4].f[i % 4] = c[i] / Determinant;
+		}
+		return Result;
+	}
+
+	inline XMVECTOR XMMatrixDeterminant(FXMMATRIX M)
+	{
+		XMVECTOR Determinant;
+		XMMatrixInverse(&Determinant, M);
+		return Determinant;
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float OffsetX, float OffsetY, float OffsetZ)
+	{
+		XMMATRIX M = XMMatrixIdentity();
+		M.r[3] = XMVectorSet(OffsetX, OffsetY, OffsetZ, 1.0f);
+		return M;
+	}
+
+	inline XMMATRIX XMMatrixScaling(float ScaleX, float ScaleY, float ScaleZ)
+	{
+		XMMATRIX M = XMMatrixIdentity();
+		M.r[0].f[0] = ScaleX;
+		M.r[1].f[1] = ScaleY;
+		M.r[2].f[2] = ScaleZ;
+		return M;
+	}
+
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float FovAngleY, float AspectRatio, float NearZ, float FarZ)
+	{
+		const float Height = 1.0f / std::tan(0.5f * FovAngleY);
+		const float Width = Height / AspectRatio;
+		const float Range = FarZ / (FarZ - NearZ);
+		return XMMATRIX(
+			Width, 0.0f, 0.0f, 0.0f,
+			0.0f, Height, 0.0f, 0.0f,
+			0.0f, 0.0f, Range, 1.0f,
+			0.0f, 0.0f, -Range * NearZ, 0.0f);
+	}
+
+	inline XMMATRIX XMMatrixLookToLH(FXMVECTOR EyePosition, FXMVECTOR EyeDirection, FXMVECTOR UpDirection)
+	{
+		const XMVECTOR R2 = XMVector3Normalize(EyeDirection);
+		const XMVECTOR R0 = XMVector3Normalize(XMVector3Cross(UpDirection, R2));
+		const XMVECTOR R1 = XMVector3Cross(R2, R0);
+		const XMVECTOR NegEye = XMVectorNegate(EyePosition);
+
+		const XMMATRIX M(
+			XMVectorSet(R0.f[0], R0.f[1], R0.f[2], XMVectorGetX(XMVector3Dot(R0, NegEye))),
+			XMVectorSet(R1.f[0], R1.f[1], R1.f[2], XMVectorGetX(XMVector3Dot(R1, NegEye))),
+			XMVectorSet(R2.f[0], R2.f[1], R2.f[2], XMVectorGetX(XMVector3Dot(R2, NegEye))),
+			XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f));
+		return XMMatrixTranspose(M);
+	}
+
+	inline XMMATRIX XMMatrixLookAtLH(FXMVECTOR EyePosition, FXMVECTOR FocusPosition, FXMVECTOR UpDirection)
+	{
+		return XMMatrixLookToLH(EyePosition, FocusPosition - EyePosition, UpDirection);
+	}
+}
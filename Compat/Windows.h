@@ -0,0 +1,15 @@
+#pragma once
+
+// Stand-in for the handful of Windows SDK typedefs the portable units use; see
+// DirectXMath.h in this directory.
+
+#include <cstddef>
+#include <cstdint>
+
+typedef std::uint8_t BYTE;
+typedef std::int32_t INT;
+typedef std::uint32_t UINT;
+typedef std::uint32_t ULONG;
+typedef std::uint64_t UINT64;
+typedef std::size_t SIZE_T;
+typedef std::int32_t HRESULT;
@@ -0,0 +1,68 @@
+#pragma once
+
+// Stand-in for Microsoft::WRL::ComPtr (reference counting through AddRef/Release); see
+// DirectXMath.h in this directory.
+
+#include <cstddef>
+
+namespace Microsoft
+{
+	namespace WRL
+	{
+		template<typename T>
+		class ComPtr
+		{
+		public:
+			ComPtr() = default;
+			ComPtr(std::nullptr_t) {}
+			ComPtr(T* p) : mPtr(p) { AddRef(); }
+			ComPtr(const ComPtr& other) : mPtr(other.mPtr) { AddRef(); }
+			ComPtr(ComPtr&& other) noexcept : mPtr(other.mPtr) { other.mPtr = nullptr; }
+			~ComPtr() { Release(); }
+
+			ComPtr& operator=(ComPtr other) noexcept
+			{
+				T* p = other.mPtr;
+				other.mPtr = mPtr;
+				mPtr = p;
+				return *this;
+			}
+
+			T* Get() const { return mPtr; }
+			T* operator->() const { return mPtr; }
+			explicit operator bool() const { return mPtr != nullptr; }
+
+			T** ReleaseAndGetAddressOf()
+			{
+				Release();
+				return &mPtr;
+			}
+
+			void Reset() { Release(); }
+
+			friend bool operator==(const ComPtr& a, std::nullptr_t) { return a.mPtr == nullptr; }
+			friend bool operator!=(const ComPtr& a, std::nullptr_t) { return a.mPtr != nullptr; }
+
+		private:
+			void AddRef()
+			{
+				if (mPtr != nullptr)
+				{
+					mPtr->AddRef();
+				}
+			}
+
+			void Release()
+			{
+				if (mPtr != nullptr)
+				{
+					T* p = mPtr;
+					mPtr = nullptr;
+					p->Release();
+				}
+			}
+
+			T* mPtr = nullptr;
+		};
+	}
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Runtime CPU feature checks for the SIMD kernels.  SSE2 is the baseline on every
+// platform we build for (DirectXMath requires it), so only wider paths are checked.
+
+// Marks a function that uses AVX2 intrinsics.  MSVC accepts them anywhere; GCC and Clang
+// need the function compiled for the target.
+#if defined(_MSC_VER)
+#define WE_TARGET_AVX2
+#else
+#define WE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// True if the CPU and the OS both support AVX2 (the OS must save the YMM registers).
+bool CpuSupportsAVX2();
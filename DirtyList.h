@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "config.h"
+
+// Objects with constant-buffer updates still pending for some frame resource.
+//
+// T needs an int NumFramesDirty and a bool InDirtyList.  Mark() resets the counter to the
+// ring depth and queues the object once; ForEachDirty() visits only the queued objects,
+// counts one frame resource off each and drops those every frame resource has seen.  The
+// per-frame cost is proportional to what changed in the last gNumFrameResources frames,
+// not to the size of the scene.  Objects must stay alive while they are queued, and
+// NumFramesDirty should only be raised through Mark().
+template<typename T>
+class DirtyList
+{
+public:
+	void Mark(T* Object)
+	{
+		Object->NumFramesDirty = gNumFrameResources;
+		if (!Object->InDirtyList)
+		{
+			Object->InDirtyList = true;
+			mObjects.push_back(Object);
+		}
+	}
+
+	// Calls Update(T*) for every queued object, once per frame resource it is dirty for.
+	template<typename F>
+	void ForEachDirty(F&& Update)
+	{
+		for (size_t i = 0; i < mObjects.size();)
+		{
+			T* Object = mObjects[i];
+			if (Object->NumFramesDirty > 0)
+			{
+				Update(Object);
+				--Object->NumFramesDirty;
+			}
+
+			if (Object->NumFramesDirty <= 0)
+			{
+				Object->InDirtyList = false;
+				mObjects[i] = mObjects.back();
+				mObjects.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	size_t Size() const { return mObjects.size(); }
+
+private:
+	std::vector<T*> mObjects;
+};
@@ -0,0 +1,185 @@
+#include "DrawSort.h"
+
+#include <algorithm>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    const std::uint32_t LayerBits = 4;
+    const std::uint32_t PsoBits = 6;
+    const std::uint32_t TextureBits = 10;
+    const std::uint32_t MaterialBits = 10;
+    const std::uint32_t GeometryBits = 10;
+    const std::uint32_t StateBitCount = PsoBits + TextureBits + MaterialBits + GeometryBits;
+    static_assert(LayerBits + StateBitCount + DrawKey::DepthBits == 64, "Draw key fields must fill 64 bits");
+
+    // Opaque draws only need a coarse front-to-back order for early depth rejection, and
+    // every depth bit dropped is one less bit to sort.
+    const std::uint32_t OpaqueDepthBits = 10;
+
+    std::uint64_t Field(std::uint32_t value, std::uint32_t bits)
+    {
+        return (std::uint64_t)(value & ((1u << bits) - 1));
+    }
+
+    // pso | texture | material | geometry
+    std::uint64_t StateBits(const DrawKeyFields& fields)
+    {
+        std::uint64_t state = Field(fields.Pso, PsoBits);
+        state = (state << TextureBits) | Field(fields.Texture, TextureBits);
+        state = (state << MaterialBits) | Field(fields.Material, MaterialBits);
+        state = (state << GeometryBits) | Field(fields.Geometry, GeometryBits);
+        return state;
+    }
+
+    int LowestBit(std::uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long bit;
+        _BitScanForward64(&bit, value);
+        return (int)bit;
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    int HighestBit(std::uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long bit;
+        _BitScanReverse64(&bit, value);
+        return (int)bit;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    // 11-bit digits keep the histogram (8 KB) in L1 and the scatter spread over few enough
+    // destinations to stay in cache.  A 16-bit pass costs about 1.7 times as much on large
+    // lists and far more on small ones (clearing and scanning 64K buckets), so it is only
+    // used when it replaces two 11-bit passes with one.
+    const int SmallDigitBits = 11;
+    const int LargeDigitBits = 16;
+    const size_t LargeDigitMinCount = 1 << 15;
+
+    std::vector<std::uint32_t>& GetHistograms()
+    {
+        thread_local std::vector<std::uint32_t> histograms;
+        return histograms;
+    }
+}
+
+std::uint32_t DrawKey::QuantizeDepth(float viewDepth, float nearZ, float farZ)
+{
+    if (!(farZ > nearZ))
+    {
+        return 0;
+    }
+
+    const float t = (viewDepth - nearZ) / (farZ - nearZ);
+    const float clamped = !(t > 0.0f) ? 0.0f : (t > 1.0f ? 1.0f : t);
+    return (std::uint32_t)(clamped * (float)((1u << DepthBits) - 1));
+}
+
+std::uint64_t DrawKey::MakeOpaque(const DrawKeyFields& fields)
+{
+    const std::uint32_t coarseDepth = (std::uint32_t)Field(fields.Depth, DepthBits) >> (DepthBits - OpaqueDepthBits) << (DepthBits - OpaqueDepthBits);
+
+    std::uint64_t key = Field(fields.Layer, LayerBits);
+    key = (key << StateBitCount) | StateBits(fields);
+    key = (key << DepthBits) | coarseDepth;
+    return key;
+}
+
+std::uint64_t DrawKey::MakeTransparent(const DrawKeyFields& fields)
+{
+    // Inverted depth so the farthest draw sorts first.
+    std::uint64_t key = Field(fields.Layer, LayerBits);
+    key = (key << DepthBits) | Field(~fields.Depth, DepthBits);
+    key = (key << StateBitCount) | StateBits(fields);
+    return key;
+}
+
+void RadixSortDrawKeys(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch)
+{
+    const size_t count = entries.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    // Only the bits that differ between keys need sorting.  Fields hold small dense ids,
+    // so most of their bits are the same for every draw.
+    std::uint64_t varyingBits = 0;
+    const std::uint64_t firstKey = entries[0].Key;
+    for (const DrawSortEntry& entry : entries)
+    {
+        varyingBits |= entry.Key ^ firstKey;
+    }
+    if (varyingBits == 0)
+    {
+        return;
+    }
+
+    const int lowBit = LowestBit(varyingBits);
+    const int keyBits = HighestBit(varyingBits) - lowBit + 1;
+
+    int digitBits = SmallDigitBits;
+    if (count >= LargeDigitMinCount && keyBits > SmallDigitBits && keyBits <= LargeDigitBits)
+    {
+        digitBits = LargeDigitBits;
+    }
+    const int passCount = (keyBits + digitBits - 1) / digitBits;
+    const std::uint32_t radixSize = 1u << digitBits;
+    const std::uint64_t digitMask = radixSize - 1;
+
+    // One pass over the keys builds the histograms of every digit.
+    std::vector<std::uint32_t>& histograms = GetHistograms();
+    histograms.assign((size_t)passCount * radixSize, 0u);
+    for (const DrawSortEntry& entry : entries)
+    {
+        std::uint64_t key = entry.Key >> lowBit;
+        for (int pass = 0; pass < passCount; ++pass)
+        {
+            ++histograms[(size_t)pass * radixSize + (key & digitMask)];
+            key >>= digitBits;
+        }
+    }
+
+    scratch.resize(count);
+    DrawSortEntry* src = entries.data();
+    DrawSortEntry* dst = scratch.data();
+    for (int pass = 0; pass < passCount; ++pass)
+    {
+        std::uint32_t* histogram = histograms.data() + (size_t)pass * radixSize;
+        const int shift = lowBit + pass * digitBits;
+
+        // Every key has the same value in this digit: the pass would be a plain copy.
+        if (histogram[(src[0].Key >> shift) & digitMask] == count)
+        {
+            continue;
+        }
+
+        std::uint32_t offset = 0;
+        for (std::uint32_t bucket = 0; bucket < radixSize; ++bucket)
+        {
+            const std::uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            dst[histogram[(src[i].Key >> shift) & digitMask]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != entries.data())
+    {
+        entries.swap(scratch);
+    }
+}
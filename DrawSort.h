@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 64-bit draw sort keys.  Sorting a draw list by key in ascending order gives the
+// submission order: grouped by layer, then by state for opaque layers (nearest first
+// inside a group), or strictly back to front for transparent layers.
+//
+//   Opaque:       layer:4 | pso:6 | texture:10 | material:10 | geometry:10 | depth:24
+//   Transparent:  layer:4 | ~depth:24 | pso:6 | texture:10 | material:10 | geometry:10
+//
+// Opaque keys keep only the top 10 depth bits: a coarse front-to-back order is all early
+// depth rejection needs.  Fields wider than their slot are truncated, which only costs
+// sort quality.
+struct DrawKeyFields
+{
+	std::uint32_t Layer = 0;
+	std::uint32_t Pso = 0;
+	std::uint32_t Texture = 0;
+	std::uint32_t Material = 0;
+	std::uint32_t Geometry = 0;
+	std::uint32_t Depth = 0;	// From QuantizeDepth.
+};
+
+namespace DrawKey
+{
+	const std::uint32_t DepthBits = 24;
+
+	// Maps view-space depth in [nearZ, farZ] to 0..2^DepthBits-1, clamping outside.
+	std::uint32_t QuantizeDepth(float viewDepth, float nearZ, float farZ);
+
+	std::uint64_t MakeOpaque(const DrawKeyFields& fields);
+	std::uint64_t MakeTransparent(const DrawKeyFields& fields);
+}
+
+struct DrawSortEntry
+{
+	std::uint64_t Key;
+	std::uint32_t Index;	// Caller's index of the draw, carried along with the key.
+};
+
+// Stable LSD radix sort of the entries by key.  Only the span of key bits that differ
+// between entries is sorted, in 11-bit digits, or one 16-bit digit for large lists whose
+// keys differ in 12 to 16 bits; digits equal in every key are skipped.  scratch is resized as needed and can
+// be reused between frames.
+void RadixSortDrawKeys(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch);
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <d3d12.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Emitted and elided API calls, summed over the caches that recorded a frame.
+struct DrawStateStats
+{
+	std::uint32_t Emitted = 0;
+	std::uint32_t Elided = 0;
+	std::uint32_t Draws = 0;
+
+	void Clear() { *this = DrawStateStats(); }
+
+	DrawStateStats& operator+=(const DrawStateStats& Other)
+	{
+		Emitted += Other.Emitted;
+		Elided += Other.Elided;
+		Draws += Other.Draws;
+		return *this;
+	}
+};
+
+// Forwards input-assembler and root-argument binds to a command list, dropping the ones
+// that would set what is already bound.  Sorted draw lists share geometry and material
+// between neighbours, so most per-item binds are redundant.
+//
+// The cache only knows what went through it: construct one per command list after the
+// root signature is set, and call Invalidate() after binding anything behind its back.
+// CommandList is ID3D12GraphicsCommandList in the engine; any type with the same methods
+// works, which is how the filtering can be checked without a device.
+template<typename CommandList>
+class DrawStateCache
+{
+public:
+	static const UINT MaxRootParameters = 8;
+
+	explicit DrawStateCache(CommandList* CmdList) : mCmdList(CmdList) {}
+
+	void Invalidate()
+	{
+		mVertexBufferValid = false;
+		mIndexBufferValid = false;
+		mTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+		for (UINT i = 0; i < MaxRootParameters; ++i)
+		{
+			mRootValid[i] = false;
+		}
+	}
+
+	void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& View)
+	{
+		if (mVertexBufferValid && std::memcmp(&mVertexBuffer, &View, sizeof(View)) == 0)
+		{
+			++mStats.Elided;
+			return;
+		}
+		mVertexBuffer = View;
+		mVertexBufferValid = true;
+		mCmdList->IASetVertexBuffers(0, 1, &View);
+		++mStats.Emitted;
+	}
+
+	void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& View)
+	{
+		if (mIndexBufferValid && std::memcmp(&mIndexBuffer, &View, sizeof(View)) == 0)
+		{
+			++mStats.Elided;
+			return;
+		}
+		mIndexBuffer = View;
+		mIndexBufferValid = true;
+		mCmdList->IASetIndexBuffer(&View);
+		++mStats.Emitted;
+	}
+
+	void SetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY Topology)
+	{
+		if (Topology == mTopology)
+		{
+			++mStats.Elided;
+			return;
+		}
+		mTopology = Topology;
+		mCmdList->IASetPrimitiveTopology(Topology);
+		++mStats.Emitted;
+	}
+
+	void SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE Handle)
+	{
+		if (IsBound(RootParameterIndex, Handle.ptr))
+		{
+			++mStats.Elided;
+			return;
+		}
+		mCmdList->SetGraphicsRootDescriptorTable(RootParameterIndex, Handle);
+		++mStats.Emitted;
+	}
+
+	void SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS Address)
+	{
+		if (IsBound(RootParameterIndex, Address))
+		{
+			++mStats.Elided;
+			return;
+		}
+		mCmdList->SetGraphicsRootConstantBufferView(RootParameterIndex, Address);
+		++mStats.Emitted;
+	}
+
+	void SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS Address)
+	{
+		if (IsBound(RootParameterIndex, Address))
+		{
+			++mStats.Elided;
+			return;
+		}
+		mCmdList->SetGraphicsRootShaderResourceView(RootParameterIndex, Address);
+		++mStats.Emitted;
+	}
+
+	void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
+	{
+		mCmdList->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+		++mStats.Draws;
+	}
+
+	CommandList* GetCommandList() const { return mCmdList; }
+	const DrawStateStats& Stats() const { return mStats; }
+
+private:
+	// Records Value for the slot and returns whether it was already bound.  Slots past
+	// MaxRootParameters are never cached.
+	bool IsBound(UINT RootParameterIndex, std::uint64_t Value)
+	{
+		if (RootParameterIndex >= MaxRootParameters)
+		{
+			return false;
+		}
+		if (mRootValid[RootParameterIndex] && mRootValues[RootParameterIndex] == Value)
+		{
+			return true;
+		}
+		mRootValid[RootParameterIndex] = true;
+		mRootValues[RootParameterIndex] = Value;
+		return false;
+	}
+
+	CommandList* mCmdList;
+	DrawStateStats mStats;
+
+	D3D12_VERTEX_BUFFER_VIEW mVertexBuffer = {};
+	D3D12_INDEX_BUFFER_VIEW mIndexBuffer = {};
+	bool mVertexBufferValid = false;
+	bool mIndexBufferValid = false;
+	D3D12_PRIMITIVE_TOPOLOGY mTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+
+	std::uint64_t mRootValues[MaxRootParameters] = {};
+	bool mRootValid[MaxRootParameters] = {};
+};
+
+// A sorted draw list split into contiguous chunks, each recorded on its own command list.
+// Every list starts with nothing bound, so each chunk pays for binding the shared state
+// again; chunks under MinDrawsPerChunk draws are not worth a list of their own.
+inline int DrawChunkCount(size_t DrawCount, int WorkerCount, size_t MinDrawsPerChunk)
+{
+	const size_t Chunks = (std::min)(DrawCount / MinDrawsPerChunk, (size_t)(std::max)(1, WorkerCount));
+	return (std::max)(1, (int)Chunks);
+}
+
+// First draw of Chunk; chunk ChunkCount starts at DrawCount, so chunk c covers
+// [DrawChunkBegin(c), DrawChunkBegin(c + 1)).
+inline size_t DrawChunkBegin(size_t DrawCount, int Chunk, int ChunkCount)
+{
+	return DrawCount * (size_t)Chunk / (size_t)ChunkCount;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#if defined(_WIN32)
+#include "d3dUtil.h"
+#endif
+
+// Anything with a monotonically increasing completed value that the CPU can block on.
+// D3D12WaitableFence wraps an ID3D12Fence; tests can substitute a simulated fence.
+class WaitableFence
+{
+public:
+	virtual ~WaitableFence() = default;
+
+	virtual std::uint64_t GetCompletedValue() = 0;
+
+	// Returns once GetCompletedValue() >= value.
+	virtual void BlockUntil(std::uint64_t value) = 0;
+};
+
+#if defined(_WIN32)
+// ID3D12Fence with a single auto-reset event, created once and reused for every wait.
+class D3D12WaitableFence : public WaitableFence
+{
+public:
+	explicit D3D12WaitableFence(ID3D12Fence* fence);
+	~D3D12WaitableFence() override;
+
+	D3D12WaitableFence(const D3D12WaitableFence&) = delete;
+	D3D12WaitableFence& operator=(const D3D12WaitableFence&) = delete;
+
+	std::uint64_t GetCompletedValue() override;
+	void BlockUntil(std::uint64_t value) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	HANDLE mEvent = nullptr;
+};
+#endif
+
+// Waits for fence values on behalf of the frame loop.
+//
+// A wait first polls the fence for up to SpinMicroseconds, which avoids a kernel round
+// trip and the scheduler's wake-up latency when the GPU is only just behind, and then
+// blocks.  Every wait that found the fence incomplete is counted as a stall and timed.
+class FenceWaiter
+{
+public:
+	struct Stats
+	{
+		std::uint64_t WaitCount = 0;
+		std::uint64_t StallCount = 0;		// Fence was not yet reached.
+		std::uint64_t SpinCount = 0;		// ...but was reached while spinning.
+		double StallMilliseconds = 0.0;		// Total over all stalls.
+		double LastStallMilliseconds = 0.0;
+		double MaxStallMilliseconds = 0.0;
+	};
+
+	FenceWaiter() = default;
+	explicit FenceWaiter(std::unique_ptr<WaitableFence> fence);
+
+	void SetFence(std::unique_ptr<WaitableFence> fence);
+	WaitableFence* GetFence() const { return mFence.get(); }
+
+	void SetSpinMicroseconds(std::uint32_t microseconds) { mSpinMicroseconds = microseconds; }
+	std::uint32_t SpinMicroseconds() const { return mSpinMicroseconds; }
+
+	bool IsComplete(std::uint64_t value);
+
+	// Returns true if the wait stalled.
+	bool Wait(std::uint64_t value);
+
+	// Frame-latency limiter.  lastSignaled is the fence value of the latest submitted
+	// frame, one value per frame.  Waits until fewer than maxLatency frames are still on
+	// the GPU, so the next submission keeps at most maxLatency in flight.  0 disables it.
+	bool WaitForFrameLatency(std::uint64_t lastSignaled, std::uint32_t maxLatency);
+
+	// Submitted frames the GPU has not finished yet.
+	std::uint64_t FramesInFlight(std::uint64_t lastSignaled);
+
+	const Stats& GetStats() const { return mStats; }
+	void ResetStats() { mStats = Stats(); }
+
+private:
+	std::unique_ptr<WaitableFence> mFence;
+	std::uint32_t mSpinMicroseconds = 50;
+	Stats mStats;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Windows.h>
+#include <DirectXMath.h>
+#include "MathHelper.h"
+
+// CPU-side layouts of the per-frame buffers: the constant buffers and structured buffers
+// of Default.hlsl and the wave vertex buffer.  Kept free of D3D12 so the portable build
+// writes the same layouts as the game.
+
+struct Vertex
+{
+public:
+	Vertex() = default;
+	Vertex(float x, float y, float z, float nx, float ny, float nz, float u, float v)
+		: Pos(x, y, z), Normal(nx, ny, nz), TexC(u, v) {}
+
+	DirectX::XMFLOAT3 Pos;
+	DirectX::XMFLOAT3 Normal;
+	DirectX::XMFLOAT2 TexC;
+};
+
+struct ObjectConstants
+{
+public:
+	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+};
+
+struct MaterialConstants
+{
+	DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
+	DirectX::XMFLOAT3 FresnelR0 = { 0.01f, 0.01f, 0.01f };
+	float Roughness = 0.25f;
+	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
+};
+
+// InstancedPS reads MaterialCB as a structured buffer with a 256-byte stride.
+static_assert(sizeof(MaterialConstants) <= 256, "MaterialData in Default.hlsl assumes one 256-byte constant buffer slot per material");
+
+// Per-instance data of instanced render items; InstanceData in Default.hlsl.
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+	UINT MaterialIndex = 0;
+	UINT InstancePad0 = 0;
+	UINT InstancePad1 = 0;
+	UINT InstancePad2 = 0;
+};
+
+// Structured buffers are tightly packed: two float4x4 and four uints, 144 bytes per
+// instance on both sides.
+static_assert(sizeof(InstanceData) == 144, "InstanceData must match the stride of InstanceData in Default.hlsl");
@@ -2,12 +2,33 @@
 
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount)
+int gNumFrameResources = NUM_FRAME_RESOURCES;
+
+FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount, UINT instanceCount, UINT recordWorkerCount)
 {
 	ThrowIfFailed(device->CreateCommandAllocator(
 		D3D12_COMMAND_LIST_TYPE_DIRECT,
 		IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
 
+	WorkerCmdListAllocs.resize(recordWorkerCount);
+	WorkerCmdLists.resize(recordWorkerCount);
+	for (UINT i = 0; i < recordWorkerCount; ++i)
+	{
+		ThrowIfFailed(device->CreateCommandAllocator(
+			D3D12_COMMAND_LIST_TYPE_DIRECT,
+			IID_PPV_ARGS(WorkerCmdListAllocs[i].GetAddressOf())));
+
+		ThrowIfFailed(device->CreateCommandList(
+			0,
+			D3D12_COMMAND_LIST_TYPE_DIRECT,
+			WorkerCmdListAllocs[i].Get(),
+			nullptr,
+			IID_PPV_ARGS(WorkerCmdLists[i].GetAddressOf())));
+
+		// Draw resets the list before recording, which requires it to be closed.
+		ThrowIfFailed(WorkerCmdLists[i]->Close());
+	}
+
 	//FrameCB = std::make_unique<UploadBuffer<FrameConstants>>(device, 1, true);
 	PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
 
@@ -19,7 +40,30 @@ FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCo
 	{
 		WavesVB = std::make_unique<UploadBuffer<Vertex>>(device, waveVertCount, false);
 	}
-	
+
+	if (instanceCount != 0)
+	{
+		InstanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(device, instanceCount, false);
+	}
+}
+
+FrameResource::FrameResource(UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount, UINT instanceCount)
+{
+	PassCB = std::make_unique<UploadBuffer<PassConstants>>(passCount, true);
+
+	MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(materialCount, true);
+
+	ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(objectCount, true);
+
+	if (waveVertCount != 0)
+	{
+		WavesVB = std::make_unique<UploadBuffer<Vertex>>(waveVertCount, false);
+	}
+
+	if (instanceCount != 0)
+	{
+		InstanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(instanceCount, false);
+	}
 }
 
 
@@ -4,25 +4,7 @@
 #include "config.h"
 #include "Light.h"
 #include "UploadBuffer.h"
-
-struct Vertex
-{
-public:
-	Vertex() = default;
-	Vertex(float x, float y, float z, float nx, float ny, float nz, float u, float v)
-		: Pos(x, y, z), Normal(nx, ny, nz), TexC(u, v) {}
-
-	DirectX::XMFLOAT3 Pos;
-	DirectX::XMFLOAT3 Normal;
-	DirectX::XMFLOAT2 TexC;
-};
-
-struct ObjectConstants
-{
-public:
-	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
-	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
-};
+#include "FrameConstants.h"
 
 struct PassConstants
 {
@@ -58,18 +40,14 @@ public:
 	Light Lights[MaxLights];
 };
 
-struct MaterialConstants
-{
-	DirectX::XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
-	DirectX::XMFLOAT3 FresnelR0 = { 0.01f, 0.01f, 0.01f };
-	float Roughness = 0.25f;
-	DirectX::XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
-};
-
 struct FrameResource
 {
 public:
-	FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount);
+	FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount, UINT instanceCount = 0, UINT recordWorkerCount = 0);
+
+	// Device-less frame resource for headless runs: the buffers live in system memory
+	// and there is no command allocator.
+	FrameResource(UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount, UINT instanceCount = 0);
 	FrameResource(const FrameResource& rhs) = delete;
 	FrameResource& operator=(const FrameResource& rhs) = delete;
 	~FrameResource() {};
@@ -78,6 +56,11 @@ public:
 	// So each frame needs their own allocator.
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
+	// One allocator and command list per recording worker.  Draw records its chunks of the
+	// draw list on these in parallel; the lists are created closed.
+	std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> WorkerCmdListAllocs;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> WorkerCmdLists;
+
 	// We cannot update a cbuffer until the GPU is done processing the commands
 	// that reference it.  So each frame needs their own cbuffers.
 	// std::unique_ptr<UploadBuffer<FrameConstants>> FrameCB = nullptr;
@@ -86,6 +69,14 @@ public:
 	std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
 	std::unique_ptr<UploadBuffer<Vertex>> WavesVB = nullptr;
 
+	// Visible instances of all instanced render items, rewritten every frame.
+	std::unique_ptr<UploadBuffer<InstanceData>> InstanceBuffer = nullptr;
+
+	// Waves::Version() that WavesVB was last brought up to date with.  Each frame resource
+	// has its own copy of the wave vertices, so each one catches up on the rows that
+	// changed since it was last used.
+	std::uint64_t WavesVersion = 0;
+
 	// Fence value to mark commands up to this fence point.  This lets us
 	// check if these frame resources are still in use by the GPU.
 	UINT64 Fence = 0;
@@ -0,0 +1,134 @@
+#include "FrameStages.h"
+#include "MathHelper.h"
+
+using namespace DirectX;
+
+void StepWaves(Waves& waves, float totalTime, float deltaTime, float& lastDisturbTime)
+{
+    // Every quarter second, generate random wave.
+    if ((totalTime - lastDisturbTime) >= 0.25f)
+    {
+        lastDisturbTime += 0.25f;
+
+        int i = MathHelper::Rand(4, waves.RowCount() - 5);
+        int j = MathHelper::Rand(4, waves.ColumnCount() - 5);
+
+        float r = MathHelper::RandF(0.2f, 0.5f);
+
+        waves.Disturb(i, j, r);
+    }
+
+    waves.Update(deltaTime);
+}
+
+void WriteWaveVertices(const Waves& waves, std::uint64_t& version, Vertex* dst, std::vector<std::pair<int, int>>& dirtyRows)
+{
+    // Rows are streamed straight into the mapped vertices, in parallel, instead of one
+    // CopyData per vertex.
+    dirtyRows.clear();
+    waves.GetDirtyRows(version, dirtyRows);
+
+    for (const auto& rows : dirtyRows)
+    {
+        waves.WriteVertices(dst, rows.first, rows.second);
+    }
+    version = waves.Version();
+}
+
+void UpdateInstanceBounds(std::vector<std::unique_ptr<InstancedRenderItem>>& items, SphereCullSet& instanceCullSet)
+{
+    for (auto& item : items)
+    {
+        if (!item->BoundsDirty)
+        {
+            continue;
+        }
+        for (size_t i = 0; i < item->Instances.size(); ++i)
+        {
+            BoundingSphere worldBounds;
+            item->Bounds.Transform(worldBounds, XMLoadFloat4x4(&item->Instances[i].World));
+            instanceCullSet.SetSphere(item->CullBase + (UINT)i, worldBounds);
+        }
+        item->BoundsDirty = false;
+    }
+}
+
+void GatherVisibleItems(const std::vector<RenderItem*>& layer, const std::vector<std::uint8_t>& visible, std::vector<RenderItem*>& visibleItems)
+{
+    visibleItems.clear();
+    for (RenderItem* item : layer)
+    {
+        if (item->ObjectCBIndex >= visible.size() || visible[item->ObjectCBIndex])
+        {
+            visibleItems.push_back(item);
+        }
+    }
+}
+
+void SortLayer(std::vector<RenderItem*>& items, int layer, const SphereCullSet& cullSet,
+    const XMFLOAT4X4& view, float nearZ, float farZ, DrawSortScratch& scratch)
+{
+    if (items.size() < 2)
+    {
+        return;
+    }
+
+    const bool backToFront = (layer == (int)RenderLayer::Transparent);
+
+    scratch.Entries.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const RenderItem* item = items[i];
+
+        float viewDepth = 0.0f;
+        if (item->ObjectCBIndex < cullSet.Size())
+        {
+            const XMFLOAT3 c = cullSet.Center(item->ObjectCBIndex);
+            viewDepth = c.x * view(0, 2) + c.y * view(1, 2) + c.z * view(2, 2) + view(3, 2);
+        }
+
+        DrawKeyFields fields;
+        fields.Layer = (std::uint32_t)layer;
+        fields.Pso = (std::uint32_t)layer;  // Each layer is drawn with its own PSO.
+        fields.Texture = item->Mat ? (std::uint32_t)(item->Mat->DiffuseSrvHeapIndex + 1) : 0;
+        fields.Material = item->Mat ? (std::uint32_t)item->Mat->MatCBIndex : 0;
+        fields.Geometry = item->Geo ? item->Geo->SortId : 0;
+        fields.Depth = DrawKey::QuantizeDepth(viewDepth, nearZ, farZ);
+
+        scratch.Entries[i].Key = backToFront ? DrawKey::MakeTransparent(fields) : DrawKey::MakeOpaque(fields);
+        scratch.Entries[i].Index = (std::uint32_t)i;
+    }
+
+    RadixSortDrawKeys(scratch.Entries, scratch.Scratch);
+
+    scratch.Sorted.resize(items.size());
+    for (size_t i = 0; i < scratch.Entries.size(); ++i)
+    {
+        scratch.Sorted[i] = items[scratch.Entries[i].Index];
+    }
+    items.swap(scratch.Sorted);
+}
+
+void WriteVisibleInstances(std::vector<std::unique_ptr<InstancedRenderItem>>& items, const std::vector<std::uint8_t>& instanceVisible, InstanceData* dst)
+{
+    UINT written = 0;
+    for (auto& item : items)
+    {
+        item->FirstVisible = written;
+        for (size_t i = 0; i < item->Instances.size(); ++i)
+        {
+            if (!instanceVisible[item->CullBase + i])
+            {
+                continue;
+            }
+
+            const RenderInstance& instance = item->Instances[i];
+            InstanceData data;
+            XMStoreFloat4x4(&data.World, XMMatrixTranspose(XMLoadFloat4x4(&instance.World)));
+            XMStoreFloat4x4(&data.TexTransform, XMMatrixTranspose(XMLoadFloat4x4(&instance.TexTransform)));
+            data.MaterialIndex = instance.Mat ? (UINT)instance.Mat->MatCBIndex : 0;
+            dst[written++] = data;
+        }
+        item->VisibleCount = written - item->FirstVisible;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <DirectXMath.h>
+#include "DirtyList.h"
+#include "DrawSort.h"
+#include "FrameConstants.h"
+#include "FrustumCulling.h"
+#include "RenderItem.h"
+#include "Waves.h"
+
+// The per-frame CPU stages of D3D12::Update, on the scene data alone.  D3D12 runs them
+// against its frame resource's upload heaps; WEHeadlessBenchmark runs the same functions
+// against system memory.  Buffer arguments need UploadBuffer's CopyData(int, const T&).
+
+// Writes the constants of every dirty render item to objectCB and refreshes its world
+// sphere in cullSet; both are indexed by ObjectCBIndex.
+template<typename ObjectBuffer>
+void WriteObjectConstants(DirtyList<RenderItem>& dirtyItems, ObjectBuffer& objectCB, SphereCullSet& cullSet)
+{
+	dirtyItems.ForEachDirty([&](RenderItem* item)
+	{
+		DirectX::XMMATRIX world = DirectX::XMLoadFloat4x4(&item->World);
+		DirectX::XMMATRIX texTransform = DirectX::XMLoadFloat4x4(&item->TexTransform);
+
+		ObjectConstants constants;
+		DirectX::XMStoreFloat4x4(&constants.World, DirectX::XMMatrixTranspose(world));
+		DirectX::XMStoreFloat4x4(&constants.TexTransform, DirectX::XMMatrixTranspose(texTransform));
+
+		objectCB.CopyData(item->ObjectCBIndex, constants);
+
+		// Only items that moved get a new world sphere.
+		DirectX::BoundingSphere worldBounds;
+		item->Bounds.Transform(worldBounds, world);
+		cullSet.SetSphere(item->ObjectCBIndex, worldBounds);
+	});
+}
+
+// Writes the constants of every dirty material to materialCB, indexed by MatCBIndex.
+template<typename MaterialBuffer>
+void WriteMaterialConstants(DirtyList<Material>& dirtyMaterials, MaterialBuffer& materialCB)
+{
+	dirtyMaterials.ForEachDirty([&](Material* mat)
+	{
+		DirectX::XMMATRIX matTransform = DirectX::XMLoadFloat4x4(&mat->MatTransform);
+
+		MaterialConstants constants;
+		constants.DiffuseAlbedo = mat->DiffuseAlbedo;
+		constants.FresnelR0 = mat->FresnelR0;
+		constants.Roughness = mat->Roughness;
+		DirectX::XMStoreFloat4x4(&constants.MatTransform, DirectX::XMMatrixTranspose(matTransform));
+
+		materialCB.CopyData(mat->MatCBIndex, constants);
+	});
+}
+
+// Drops a random ripple for every quarter second between lastDisturbTime and totalTime,
+// then steps the simulation by deltaTime.
+void StepWaves(Waves& waves, float totalTime, float deltaTime, float& lastDisturbTime);
+
+// Rewrites the rows of dst that changed since version and brings version up to date.
+// dst holds one frame resource's copy of the wave vertices; dirtyRows is scratch.
+void WriteWaveVertices(const Waves& waves, std::uint64_t& version, Vertex* dst, std::vector<std::pair<int, int>>& dirtyRows);
+
+// Recomputes the world spheres of the instanced items whose BoundsDirty is set.
+void UpdateInstanceBounds(std::vector<std::unique_ptr<InstancedRenderItem>>& items, SphereCullSet& instanceCullSet);
+
+// Copies the items of layer that passed culling to visibleItems.  Items outside the cull
+// set have no bounds and are always kept.
+void GatherVisibleItems(const std::vector<RenderItem*>& layer, const std::vector<std::uint8_t>& visible, std::vector<RenderItem*>& visibleItems);
+
+// Per-frame scratch for SortLayer.
+struct DrawSortScratch
+{
+	std::vector<DrawSortEntry> Entries;
+	std::vector<DrawSortEntry> Scratch;
+	std::vector<RenderItem*> Sorted;
+};
+
+// Sorts the visible items of one layer by draw key: opaque layers by state (PSO, texture,
+// material, geometry) and then front to back, the transparent layer back to front.
+// Depths come from the world spheres in cullSet.
+void SortLayer(std::vector<RenderItem*>& items, int layer, const SphereCullSet& cullSet,
+	const DirectX::XMFLOAT4X4& view, float nearZ, float farZ, DrawSortScratch& scratch);
+
+// Writes the visible instances of every item to dst, front to back, and sets each item's
+// FirstVisible and VisibleCount.  dst is write-combined memory and is never read.
+void WriteVisibleInstances(std::vector<std::unique_ptr<InstancedRenderItem>>& items, const std::vector<std::uint8_t>& instanceVisible, InstanceData* dst);
@@ -0,0 +1,134 @@
+#include "FrameTimeHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // 2^SubBucketBits values are stored exactly; above that each power of two is split
+    // into 2^(SubBucketBits-1) buckets.
+    const std::uint32_t SubBucketBits = 6;
+    const std::uint32_t SubBucketCount = 1u << SubBucketBits;
+    const std::uint32_t SubBucketHalf = SubBucketCount / 2;
+
+    // Samples are clamped to 2^27 us (about 134 s).
+    const std::uint32_t MaxValueBits = 27;
+    const std::uint64_t MaxValue = (1ull << MaxValueBits) - 1;
+    const std::uint32_t BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketHalf + SubBucketHalf;
+
+    std::uint32_t HighestBit(std::uint64_t value)
+    {
+        std::uint32_t bit = 0;
+        while (value >>= 1)
+        {
+            ++bit;
+        }
+        return bit;
+    }
+}
+
+FrameTimeHistogram::FrameTimeHistogram(std::uint32_t windowSize)
+    : mBuckets(BucketCount, 0), mSamples(std::max(1u, windowSize), 0)
+{
+}
+
+void FrameTimeHistogram::AddSample(double seconds)
+{
+    const std::uint64_t microseconds = std::min<std::uint64_t>(MaxValue, (std::uint64_t)std::max(0.0, seconds * 1e6 + 0.5));
+
+    if (mCount == mSamples.size())
+    {
+        const std::uint32_t evicted = mSamples[mNext];
+        --mBuckets[BucketIndex(evicted)];
+        mSum -= (double)evicted;
+        mSumSquares -= (double)evicted * (double)evicted;
+    }
+    else
+    {
+        ++mCount;
+    }
+
+    mSamples[mNext] = (std::uint32_t)microseconds;
+    mNext = (mNext + 1) % (std::uint32_t)mSamples.size();
+
+    ++mBuckets[BucketIndex(microseconds)];
+    mSum += (double)microseconds;
+    mSumSquares += (double)microseconds * (double)microseconds;
+}
+
+void FrameTimeHistogram::Clear()
+{
+    std::fill(mBuckets.begin(), mBuckets.end(), 0);
+    mNext = 0;
+    mCount = 0;
+    mSum = 0.0;
+    mSumSquares = 0.0;
+}
+
+double FrameTimeHistogram::Mean() const
+{
+    return mCount ? (mSum / mCount) * 1e-3 : 0.0;
+}
+
+double FrameTimeHistogram::StandardDeviation() const
+{
+    if (mCount == 0)
+    {
+        return 0.0;
+    }
+
+    const double mean = mSum / mCount;
+    const double variance = std::max(0.0, mSumSquares / mCount - mean * mean);
+    return std::sqrt(variance) * 1e-3;
+}
+
+double FrameTimeHistogram::Percentile(double fraction) const
+{
+    if (mCount == 0)
+    {
+        return 0.0;
+    }
+
+    // Smallest bucket whose cumulative count reaches the requested rank.
+    const std::uint64_t rank = std::max<std::uint64_t>(1, (std::uint64_t)std::ceil(std::min(1.0, std::max(0.0, fraction)) * mCount));
+    std::uint64_t cumulative = 0;
+    for (std::uint32_t i = 0; i < BucketCount; ++i)
+    {
+        cumulative += mBuckets[i];
+        if (cumulative >= rank)
+        {
+            return BucketValue(i) * 1e-3;
+        }
+    }
+
+    return BucketValue(BucketCount - 1) * 1e-3;
+}
+
+double FrameTimeHistogram::Max() const
+{
+    return Percentile(1.0);
+}
+
+std::uint32_t FrameTimeHistogram::BucketIndex(std::uint64_t microseconds)
+{
+    if (microseconds < SubBucketCount)
+    {
+        return (std::uint32_t)microseconds;
+    }
+
+    const std::uint32_t shift = HighestBit(microseconds) - (SubBucketBits - 1);
+    return shift * SubBucketHalf + (std::uint32_t)(microseconds >> shift);
+}
+
+double FrameTimeHistogram::BucketValue(std::uint32_t index)
+{
+    if (index < SubBucketCount)
+    {
+        return (double)index;
+    }
+
+    // Midpoint of the bucket's value range.
+    const std::uint32_t shift = index / SubBucketHalf - 1;
+    const std::uint64_t low = (std::uint64_t)(index - shift * SubBucketHalf) << shift;
+    return (double)low + 0.5 * (double)((1ull << shift) - 1);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Rolling histogram of the last WindowSize frame times.
+//
+// Samples are bucketed HDR-style: exact up to 64 us, then 32 buckets per power of two, so
+// every percentile is within about 3% of the true value from 1 us up to two minutes, in a
+// few KB and with O(1) insertion.  The oldest sample is removed from its bucket when a new
+// one arrives, so percentiles and jitter always describe the recent window rather than the
+// whole run.
+class FrameTimeHistogram
+{
+public:
+	explicit FrameTimeHistogram(std::uint32_t windowSize = 1000);
+
+	void AddSample(double seconds);
+	void Clear();
+
+	std::uint32_t SampleCount() const { return mCount; }
+
+	// All results are in milliseconds; 0 when there are no samples.
+	double Mean() const;
+	double StandardDeviation() const;
+	double Percentile(double fraction) const;
+	double Max() const;
+
+private:
+	static std::uint32_t BucketIndex(std::uint64_t microseconds);
+	static double BucketValue(std::uint32_t index);
+
+	std::vector<std::uint32_t> mBuckets;
+
+	// Ring of the samples in the window, in microseconds.
+	std::vector<std::uint32_t> mSamples;
+	std::uint32_t mNext = 0;
+	std::uint32_t mCount = 0;
+
+	double mSum = 0.0;
+	double mSumSquares = 0.0;
+};
@@ -0,0 +1,176 @@
+#include "FrustumCulling.h"
+#include "CpuFeatures.h"
+
+#include <cfloat>
+#include <cstring>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+    // The arrays are padded to this many lanes.  std::vector only guarantees 16-byte
+    // alignment, so the kernels use unaligned loads.
+    const std::uint32_t MaxLaneCount = 8;
+
+    // An empty slot: no distance is ever >= FLT_MAX, so it is always culled.
+    const float EmptyRadius = -FLT_MAX;
+
+    // Stored for spheres without bounds: every finite distance is >= -FLT_MAX, so it is
+    // never culled.
+    const float UnboundedRadius = FLT_MAX;
+
+    // MaskBytes[m] holds bit i of the 4-bit lane mask m in byte i.
+    struct MaskByteTable
+    {
+        std::uint32_t Bytes[16];
+
+        MaskByteTable()
+        {
+            for (std::uint32_t m = 0; m < 16; ++m)
+            {
+                Bytes[m] = (m & 1) | ((m >> 1) & 1) << 8 | ((m >> 2) & 1) << 16 | ((m >> 3) & 1) << 24;
+            }
+        }
+
+        const std::uint32_t& operator[](int m) const { return Bytes[m]; }
+    };
+
+    const MaskByteTable MaskBytes;
+
+    typedef void (*CullSpheresFn)(const FrustumPlanes& frustum, const float* centerX, const float* centerY,
+        const float* centerZ, const float* radius, std::uint32_t count, std::uint8_t* visible);
+
+    void CullSpheresSSE2(const FrustumPlanes& frustum, const float* centerX, const float* centerY,
+        const float* centerZ, const float* radius, std::uint32_t count, std::uint8_t* visible)
+    {
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            planeX[p] = _mm_set1_ps(frustum.Planes[p].x);
+            planeY[p] = _mm_set1_ps(frustum.Planes[p].y);
+            planeZ[p] = _mm_set1_ps(frustum.Planes[p].z);
+            planeW[p] = _mm_set1_ps(frustum.Planes[p].w);
+        }
+
+        for (std::uint32_t i = 0; i < count; i += 4)
+        {
+            const __m128 x = _mm_loadu_ps(centerX + i);
+            const __m128 y = _mm_loadu_ps(centerY + i);
+            const __m128 z = _mm_loadu_ps(centerZ + i);
+            const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(x, planeX[p]), planeW[p]);
+                distance = _mm_add_ps(distance, _mm_mul_ps(y, planeY[p]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(z, planeZ[p]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+            }
+
+            std::memcpy(visible + i, &MaskBytes[_mm_movemask_ps(inside)], 4);
+        }
+    }
+
+    WE_TARGET_AVX2 void CullSpheresAVX2(const FrustumPlanes& frustum, const float* centerX, const float* centerY,
+        const float* centerZ, const float* radius, std::uint32_t count, std::uint8_t* visible)
+    {
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            planeX[p] = _mm256_set1_ps(frustum.Planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.Planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.Planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.Planes[p].w);
+        }
+
+        for (std::uint32_t i = 0; i < count; i += 8)
+        {
+            const __m256 x = _mm256_loadu_ps(centerX + i);
+            const __m256 y = _mm256_loadu_ps(centerY + i);
+            const __m256 z = _mm256_loadu_ps(centerZ + i);
+            const __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(x, planeX[p]), planeW[p]);
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(y, planeY[p]));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(z, planeZ[p]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+            }
+
+            const int mask = _mm256_movemask_ps(inside);
+            std::memcpy(visible + i, &MaskBytes[mask & 0xF], 4);
+            std::memcpy(visible + i + 4, &MaskBytes[mask >> 4], 4);
+        }
+
+        _mm256_zeroupper();
+    }
+
+    CullSpheresFn SelectCullSpheres()
+    {
+        return CpuSupportsAVX2() ? CullSpheresAVX2 : CullSpheresSSE2;
+    }
+
+    const CullSpheresFn CullSpheres = SelectCullSpheres();
+}
+
+FrustumPlanes FrustumPlanes::FromViewProj(FXMMATRIX viewProj)
+{
+    // Clip coordinates are v * M, so each plane is a combination of the matrix columns.
+    XMMATRIX M = XMMatrixTranspose(viewProj);
+
+    XMVECTOR planes[6] =
+    {
+        M.r[3] + M.r[0],   // Left
+        M.r[3] - M.r[0],   // Right
+        M.r[3] + M.r[1],   // Bottom
+        M.r[3] - M.r[1],   // Top
+        M.r[2],            // Near
+        M.r[3] - M.r[2],   // Far
+    };
+
+    FrustumPlanes result;
+    for (int p = 0; p < 6; ++p)
+    {
+        XMStoreFloat4(&result.Planes[p], XMPlaneNormalize(planes[p]));
+    }
+    return result;
+}
+
+void SphereCullSet::Resize(std::uint32_t count)
+{
+    mCount = count;
+
+    const size_t padded = ((size_t)count + MaxLaneCount - 1) / MaxLaneCount * MaxLaneCount;
+    mCenterX.resize(padded, 0.0f);
+    mCenterY.resize(padded, 0.0f);
+    mCenterZ.resize(padded, 0.0f);
+    mRadius.resize(padded, EmptyRadius);
+
+    for (size_t i = count; i < padded; ++i)
+    {
+        mRadius[i] = EmptyRadius;
+    }
+}
+
+void SphereCullSet::SetSphere(std::uint32_t index, const BoundingSphere& sphere)
+{
+    mCenterX[index] = sphere.Center.x;
+    mCenterY[index] = sphere.Center.y;
+    mCenterZ[index] = sphere.Center.z;
+    mRadius[index] = sphere.Radius < 0.0f ? UnboundedRadius : sphere.Radius;
+}
+
+void SphereCullSet::Cull(const FrustumPlanes& frustum, std::vector<std::uint8_t>& visible) const
+{
+    visible.resize(mRadius.size());
+    if (!mRadius.empty())
+    {
+        CullSpheres(frustum, mCenterX.data(), mCenterY.data(), mCenterZ.data(), mRadius.data(),
+            (std::uint32_t)mRadius.size(), visible.data());
+    }
+    visible.resize(mCount);
+}
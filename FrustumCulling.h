@@ -0,0 +1,54 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+// Frustum planes as (normal, d) with normals pointing inwards and normalized, so
+// dot(normal, p) + d is the signed distance of p from the plane.
+struct FrustumPlanes
+{
+	DirectX::XMFLOAT4 Planes[6];
+
+	// Extracts the planes of a row-vector view-projection matrix (D3D clip space, z in [0, w]).
+	static FrustumPlanes FromViewProj(DirectX::FXMMATRIX viewProj);
+};
+
+// Bounds of objects that are never culled, such as items without mesh bounds.  Any sphere
+// with a negative radius counts as always visible.
+constexpr DirectX::BoundingSphere AlwaysVisibleBounds(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), -1.0f);
+
+// World-space bounding spheres of a set of objects, stored structure-of-arrays so the
+// frustum test runs on 8 spheres at a time (AVX2) or 4 (SSE2).
+//
+// Slots are addressed by the caller's index (render items use their ObjectCBIndex).
+// Spheres are only rewritten when an object moves; Cull touches every slot but is a
+// handful of multiply-adds per sphere.
+class SphereCullSet
+{
+public:
+	// Slot count is rounded up to a multiple of the SIMD width; extra and new slots hold
+	// an empty sphere that is never visible.
+	void Resize(std::uint32_t count);
+	std::uint32_t Size() const { return mCount; }
+
+	// A negative radius (see AlwaysVisibleBounds) makes the slot visible from anywhere.
+	void SetSphere(std::uint32_t index, const DirectX::BoundingSphere& sphere);
+	DirectX::XMFLOAT3 Center(std::uint32_t index) const { return DirectX::XMFLOAT3(mCenterX[index], mCenterY[index], mCenterZ[index]); }
+
+	// Sets visible[i] to 1 for every sphere that intersects or is inside the frustum, 0 for
+	// the others.  Resizes visible to Size().
+	void Cull(const FrustumPlanes& frustum, std::vector<std::uint8_t>& visible) const;
+
+	// Number of slots after padding.
+	std::uint32_t Capacity() const { return (std::uint32_t)mRadius.size(); }
+
+private:
+	std::uint32_t mCount = 0;
+
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mRadius;
+};
@@ -1,12 +1,16 @@
-#include <windows.h>
 #include "GameTimer.h"
 
-GameTimer::GameTimer() : mSecondsPerCount(0.0), mDeltaTime(-1.0), mBaseTime(0),
-	mPausedTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
+#include <chrono>
+
+GameTimer::GameTimer() : mSecondsPerCount(1e-9), mDeltaTime(-1.0), mBaseTime(0),
+	mPausedTime(0), mStopTime(0), mPrevTime(0), mCurrTime(0), mStopped(false)
+{
+}
+
+std::int64_t GameTimer::Now()
 {
-	__int64 CountsPerSec;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&CountsPerSec);
-	mSecondsPerCount = 1.0 / (double)CountsPerSec;
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
 float GameTimer::TotalTime() const
@@ -28,19 +32,21 @@ float GameTimer::DeltaTime() const
 
 void GameTimer::Reset()
 {
-	__int64 currTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+	std::int64_t currTime = Now();
 
 	mBaseTime = currTime;
 	mPrevTime = currTime;
+	mCurrTime = currTime;
+	mPausedTime = 0;
 	mStopTime = 0;
 	mStopped = false;
+
+	mFrameTimes.Clear();
 }
 
 void GameTimer::Start()
 {
-	__int64 startTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+	std::int64_t startTime = Now();
 
 	if (mStopped)
 	{
@@ -57,10 +63,7 @@ void GameTimer::Stop()
 {
 	if (!mStopped)
 	{
-		__int64 currTime;
-		QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
-
-		mStopped = currTime;
+		mStopTime = Now();
 		mStopped = true;
 	}
 }
@@ -73,9 +76,7 @@ void GameTimer::Tick()
 		return;
 	}
 
-	__int64 CurTime;
-	QueryPerformanceCounter((LARGE_INTEGER*)&CurTime);
-	mCurrTime = CurTime;
+	mCurrTime = Now();
 
 	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
 
@@ -85,4 +86,23 @@ void GameTimer::Tick()
 	{
 		mDeltaTime = 0.0;
 	}
+
+	mFrameTimes.AddSample(mDeltaTime);
+}
+
+void GameTimer::Advance(float deltaTime)
+{
+	if (mStopped)
+	{
+		mDeltaTime = 0.0;
+		return;
+	}
+
+	mCurrTime = mPrevTime + (std::int64_t)(deltaTime / mSecondsPerCount);
+
+	mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
+
+	mPrevTime = mCurrTime;
+
+	mFrameTimes.AddSample(mDeltaTime);
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include "FrameTimeHistogram.h"
+
 class GameTimer
 {
 public:
@@ -13,16 +16,28 @@ public:
 	void Stop();
 	void Tick();
 
+	// Like Tick, but as if exactly deltaTime seconds had passed.  For headless runs
+	// that need a fixed, reproducible frame rate.
+	void Advance(float deltaTime);
+
+	// Deltas of the most recent frames, for percentile and jitter display.  Frames while
+	// the timer is stopped are not recorded.
+	const FrameTimeHistogram& FrameTimes() const { return mFrameTimes; }
+
 private:
+	// Ticks are nanoseconds on std::chrono::steady_clock.
+	static std::int64_t Now();
+
 	double mSecondsPerCount;
 	double mDeltaTime;
 
-	__int64 mBaseTime;
-	__int64 mPausedTime;
-	__int64 mStopTime;
-	__int64 mPrevTime;
-	__int64 mCurrTime;
+	std::int64_t mBaseTime;
+	std::int64_t mPausedTime;
+	std::int64_t mStopTime;
+	std::int64_t mPrevTime;
+	std::int64_t mCurrTime;
 
 	bool mStopped = false;
-};
 
+	FrameTimeHistogram mFrameTimes;
+};
@@ -1,8 +1,86 @@
 ﻿#include "GeometryGenerator.h"
 #include <algorithm>
+#include <cfloat>
+#include <cassert>
+#include "ParallelFor.h"
 
 using namespace DirectX;
 
+namespace
+{
+	template<typename IndexT>
+	void FitSubmeshBounds(SubmeshGeometry& subMesh, const void* vertexData, UINT vertexStride, const IndexT* indices)
+	{
+		const BYTE* vertices = (const BYTE*)vertexData;
+		auto LoadPosition = [&](UINT i)
+		{
+			const UINT index = (UINT)indices[subMesh.StartIndexLocation + i] + subMesh.BaseVertexLocation;
+			return XMLoadFloat3((const XMFLOAT3*)(vertices + (size_t)index * vertexStride));
+		};
+
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		for (UINT i = 0; i < subMesh.IndexCount; ++i)
+		{
+			XMVECTOR P = LoadPosition(i);
+			vMin = XMVectorMin(vMin, P);
+			vMax = XMVectorMax(vMax, P);
+		}
+
+		XMVECTOR vCenter = 0.5f * (vMin + vMax);
+		XMStoreFloat3(&subMesh.Bounds.Center, vCenter);
+		XMStoreFloat3(&subMesh.Bounds.Extents, 0.5f * (vMax - vMin));
+
+		// Centered on the box rather than the minimal sphere, but never larger than the
+		// box's circumscribed sphere.
+		XMVECTOR vRadiusSq = XMVectorZero();
+		for (UINT i = 0; i < subMesh.IndexCount; ++i)
+		{
+			vRadiusSq = XMVectorMax(vRadiusSq, XMVector3LengthSq(LoadPosition(i) - vCenter));
+		}
+
+		subMesh.SphereBounds.Center = subMesh.Bounds.Center;
+		subMesh.SphereBounds.Radius = XMVectorGetX(XMVectorSqrt(vRadiusSq));
+	}
+}
+
+void SubmeshGeometry::FitBounds(const void* vertices, UINT vertexStride, const std::uint16_t* indices)
+{
+	FitSubmeshBounds(*this, vertices, vertexStride, indices);
+}
+
+void SubmeshGeometry::FitBounds(const void* vertices, UINT vertexStride, const std::uint32_t* indices)
+{
+	FitSubmeshBounds(*this, vertices, vertexStride, indices);
+}
+
+void MeshGeometry::ComputeSubmeshBounds()
+{
+	if (VertexBufferCPU == nullptr || IndexBufferCPU == nullptr)
+	{
+		return;
+	}
+
+	const void* vertices = VertexBufferCPU->GetBufferPointer();
+	for (auto& e : DrawArgs)
+	{
+		SubmeshGeometry& subMesh = e.second;
+		if (subMesh.IndexCount == 0)
+		{
+			continue;
+		}
+
+		if (IndexFormat == DXGI_FORMAT_R16_UINT)
+		{
+			subMesh.FitBounds(vertices, VertexByteStride, (const std::uint16_t*)IndexBufferCPU->GetBufferPointer());
+		}
+		else
+		{
+			subMesh.FitBounds(vertices, VertexByteStride, (const std::uint32_t*)IndexBufferCPU->GetBufferPointer());
+		}
+	}
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateBox(float width, float height, float depth, uint32 numSubdivisions)
 {
 	MeshData meshData;
@@ -212,8 +290,8 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 
 	MeshData meshData;
 
-	// Put a cap on the number of subdivisions.
-	numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+	// Put a cap on the number of subdivisions.  Level 8 is about 655k shared vertices.
+	numSubdivisions = std::min<uint32>(numSubdivisions, 8u);
 
 	// Approximate a sphere by tessellating an icosahedron.
 
@@ -410,6 +488,232 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGrid(float width, float dep
 	return meshData;
 }
 
+GeometryGenerator::TerrainData GeometryGenerator::CreateTerrain(float width, float depth,
+	uint32 tileCountX, uint32 tileCountZ, uint32 tileQuads, uint32 lodCount)
+{
+	assert(tileQuads > 0 && tileQuads <= 128 && (tileQuads & (tileQuads - 1)) == 0);
+
+	TerrainData terrain;
+	terrain.TileCountX = tileCountX;
+	terrain.TileCountZ = tileCountZ;
+	terrain.TileQuads = tileQuads;
+
+	uint32 maxLodCount = 1;
+	while ((1u << maxLodCount) <= tileQuads)
+	{
+		++maxLodCount;
+	}
+	terrain.LodCount = std::max(1u, std::min(lodCount, maxLodCount));
+
+	const uint32 n = tileQuads + 1;
+	terrain.TileVertexCount = n * n;
+
+	//
+	// Create the vertices, tile after tile.
+	//
+
+	const uint32 totalQuadsX = tileCountX * tileQuads;
+	const uint32 totalQuadsZ = tileCountZ * tileQuads;
+
+	float halfWidth = 0.5f * width;
+	float halfDepth = 0.5f * depth;
+
+	float dx = width / totalQuadsX;
+	float dz = depth / totalQuadsZ;
+
+	float du = 1.0f / totalQuadsX;
+	float dv = 1.0f / totalQuadsZ;
+
+	terrain.Vertices.resize((size_t)tileCountX * tileCountZ * terrain.TileVertexCount);
+	for (uint32 tileZ = 0; tileZ < tileCountZ; ++tileZ)
+	{
+		for (uint32 tileX = 0; tileX < tileCountX; ++tileX)
+		{
+			Vertex* tile = &terrain.Vertices[((size_t)tileZ * tileCountX + tileX) * terrain.TileVertexCount];
+			for (uint32 i = 0; i < n; ++i)
+			{
+				// Global row/column, so border vertices of neighbouring tiles match exactly.
+				const uint32 row = tileZ * tileQuads + i;
+				float z = halfDepth - row * dz;
+				for (uint32 j = 0; j < n; ++j)
+				{
+					const uint32 column = tileX * tileQuads + j;
+					float x = -halfWidth + column * dx;
+
+					Vertex& v = tile[i * n + j];
+					v.Position = XMFLOAT3(x, 0.0f, z);
+					v.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+					v.TangentU = XMFLOAT3(1.0f, 0.0f, 0.0f);
+					v.TexC = XMFLOAT2(column * du, row * dv);
+				}
+			}
+		}
+	}
+
+	//
+	// Create one index set per (LOD, stitch mask), shared by every tile.
+	//
+
+	terrain.mIndexRanges.resize(terrain.LodCount * TerrainData::StitchMaskCount);
+
+	for (uint32 lod = 0; lod < terrain.LodCount; ++lod)
+	{
+		const uint32 step = 1u << lod;
+		const bool canStitch = lod + 1 < terrain.LodCount;
+
+		for (uint32 mask = 0; mask < TerrainData::StitchMaskCount; ++mask)
+		{
+			// The coarsest LOD never has a coarser neighbour; reuse its unstitched set.
+			if (!canStitch && mask != 0)
+			{
+				terrain.mIndexRanges[lod * TerrainData::StitchMaskCount + mask] = terrain.mIndexRanges[lod * TerrainData::StitchMaskCount];
+				continue;
+			}
+
+			// Stitching collapses every odd (at this LOD) vertex on a stitched edge onto an
+			// even neighbour, so the edge only uses vertices the coarser tile also has.
+			// Triangles that collapse to a line are dropped.  The collapse directions are
+			// chosen so no triangle flips with our diagonal, including at stitched corners.
+			auto Remap = [&](uint32 i, uint32 j) -> uint32
+			{
+				if ((mask & TerrainData::StitchNorth) && i == 0 && (j / step) % 2 == 1) j -= step;
+				if ((mask & TerrainData::StitchSouth) && i == tileQuads && (j / step) % 2 == 1) j += step;
+				if ((mask & TerrainData::StitchWest) && j == 0 && (i / step) % 2 == 1) i -= step;
+				if ((mask & TerrainData::StitchEast) && j == tileQuads && (i / step) % 2 == 1) i += step;
+				return i * n + j;
+			};
+
+			auto AddTriangle = [&terrain](uint32 a, uint32 b, uint32 c)
+			{
+				if (a == b || b == c || a == c)
+				{
+					return;
+				}
+				terrain.Indices16.push_back((uint16)a);
+				terrain.Indices16.push_back((uint16)b);
+				terrain.Indices16.push_back((uint16)c);
+			};
+
+			const uint32 start = (uint32)terrain.Indices16.size();
+
+			// Same triangulation as CreateGrid, at this LOD's spacing.
+			for (uint32 i = 0; i < tileQuads; i += step)
+			{
+				for (uint32 j = 0; j < tileQuads; j += step)
+				{
+					AddTriangle(Remap(i, j), Remap(i, j + step), Remap(i + step, j));
+					AddTriangle(Remap(i + step, j), Remap(i, j + step), Remap(i + step, j + step));
+				}
+			}
+
+			terrain.mIndexRanges[lod * TerrainData::StitchMaskCount + mask] =
+				std::make_pair(start, (uint32)terrain.Indices16.size() - start);
+		}
+	}
+
+	terrain.UpdateTileBounds();
+
+	return terrain;
+}
+
+SubmeshGeometry GeometryGenerator::TerrainData::GetTileSubmesh(uint32 tileX, uint32 tileZ, uint32 lod, uint32 stitchMask) const
+{
+	assert(tileX < TileCountX && tileZ < TileCountZ && lod < LodCount && stitchMask < StitchMaskCount);
+
+	const uint32 tile = tileZ * TileCountX + tileX;
+	const std::pair<uint32, uint32>& range = mIndexRanges[lod * StitchMaskCount + stitchMask];
+
+	SubmeshGeometry subMesh;
+	subMesh.StartIndexLocation = range.first;
+	subMesh.IndexCount = range.second;
+	subMesh.BaseVertexLocation = (INT)(tile * TileVertexCount);
+	subMesh.Bounds = TileBounds[tile];
+
+	return subMesh;
+}
+
+void GeometryGenerator::TerrainData::UpdateTileBounds()
+{
+	const uint32 tileCount = TileCountX * TileCountZ;
+	TileBounds.resize(tileCount);
+
+	for (uint32 tile = 0; tile < tileCount; ++tile)
+	{
+		const Vertex* vertices = &Vertices[(size_t)tile * TileVertexCount];
+
+		XMVECTOR vMin = XMLoadFloat3(&vertices[0].Position);
+		XMVECTOR vMax = vMin;
+		for (uint32 i = 1; i < TileVertexCount; ++i)
+		{
+			XMVECTOR P = XMLoadFloat3(&vertices[i].Position);
+			vMin = XMVectorMin(vMin, P);
+			vMax = XMVectorMax(vMax, P);
+		}
+
+		XMStoreFloat3(&TileBounds[tile].Center, 0.5f * (vMin + vMax));
+		XMStoreFloat3(&TileBounds[tile].Extents, 0.5f * (vMax - vMin));
+	}
+}
+
+void GeometryGenerator::TerrainData::SelectTileLods(const XMFLOAT3& eye, float lodDistance,
+	std::vector<uint32>& lods, std::vector<uint32>& stitchMasks) const
+{
+	assert(lodDistance > 0.0f);
+
+	const uint32 tileCount = TileCountX * TileCountZ;
+	lods.resize(tileCount);
+	stitchMasks.resize(tileCount);
+
+	XMVECTOR E = XMLoadFloat3(&eye);
+	for (uint32 tile = 0; tile < tileCount; ++tile)
+	{
+		// Distance to the closest point of the box; 0 inside it.
+		XMVECTOR C = XMLoadFloat3(&TileBounds[tile].Center);
+		XMVECTOR X = XMLoadFloat3(&TileBounds[tile].Extents);
+		XMVECTOR Closest = XMVectorClamp(E, C - X, C + X);
+		float distance = XMVectorGetX(XMVector3Length(E - Closest));
+
+		lods[tile] = (uint32)std::min(distance / lodDistance, (float)(LodCount - 1));
+	}
+
+	// lod = min(lod, neighbour lod + 1) over the 4-neighbourhood.  Two sweeps, the first
+	// pulling from the north and west neighbours and the second from the south and east,
+	// settle it for good, like a city-block distance transform.
+	for (uint32 z = 0; z < TileCountZ; ++z)
+	{
+		for (uint32 x = 0; x < TileCountX; ++x)
+		{
+			uint32& lod = lods[z * TileCountX + x];
+			if (z > 0) lod = std::min(lod, lods[(z - 1) * TileCountX + x] + 1);
+			if (x > 0) lod = std::min(lod, lods[z * TileCountX + x - 1] + 1);
+		}
+	}
+	for (uint32 z = TileCountZ; z-- > 0;)
+	{
+		for (uint32 x = TileCountX; x-- > 0;)
+		{
+			uint32& lod = lods[z * TileCountX + x];
+			if (z + 1 < TileCountZ) lod = std::min(lod, lods[(z + 1) * TileCountX + x] + 1);
+			if (x + 1 < TileCountX) lod = std::min(lod, lods[z * TileCountX + x + 1] + 1);
+		}
+	}
+
+	// Tile row 0 is the +z (north) edge, so the northern neighbour is at z - 1.
+	for (uint32 z = 0; z < TileCountZ; ++z)
+	{
+		for (uint32 x = 0; x < TileCountX; ++x)
+		{
+			const uint32 coarser = lods[z * TileCountX + x] + 1;
+			uint32 mask = 0;
+			if (z > 0 && lods[(z - 1) * TileCountX + x] == coarser) mask |= StitchNorth;
+			if (z + 1 < TileCountZ && lods[(z + 1) * TileCountX + x] == coarser) mask |= StitchSouth;
+			if (x > 0 && lods[z * TileCountX + x - 1] == coarser) mask |= StitchWest;
+			if (x + 1 < TileCountX && lods[z * TileCountX + x + 1] == coarser) mask |= StitchEast;
+			stitchMasks[z * TileCountX + x] = mask;
+		}
+	}
+}
+
 GeometryGenerator::MeshData GeometryGenerator::CreateQuad(float x, float y, float w, float h, float depth)
 {
 	MeshData meshData;
@@ -472,14 +776,84 @@ DirectX::XMFLOAT3 GeometryGenerator::GetHillsNormal(float x, float z)
 	return n;
 }
 
-void GeometryGenerator::Subdivide(MeshData& meshData)
+void GeometryGenerator::ApplyHills(Vertex* vertices, size_t count)
+{
+	const XMVECTOR scale = XMVectorReplicate(0.1f);
+	const XMVECTOR c003 = XMVectorReplicate(0.03f);
+	const XMVECTOR c03 = XMVectorReplicate(0.3f);
+	const XMVECTOR one = XMVectorReplicate(1.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		Vertex* v = vertices + i;
+		XMVECTOR x = XMVectorSet(v[0].Position.x, v[1].Position.x, v[2].Position.x, v[3].Position.x);
+		XMVECTOR z = XMVectorSet(v[0].Position.z, v[1].Position.z, v[2].Position.z, v[3].Position.z);
+
+		XMVECTOR sinX, cosX, sinZ, cosZ;
+		XMVectorSinCos(&sinX, &cosX, scale * x);
+		XMVectorSinCos(&sinZ, &cosZ, scale * z);
+
+		// h = 0.3 * z * sin(0.1x) + x * cos(0.1z)
+		XMVECTOR h = XMVectorMultiplyAdd(c03 * z, sinX, x * cosZ);
+
+		// n = (-df/dx, 1, -df/dz), normalized.
+		XMVECTOR nx = XMVectorNegate(XMVectorMultiplyAdd(c003 * z, cosX, c03 * cosZ));
+		XMVECTOR nz = XMVectorMultiplyAdd(c003 * x, sinZ, XMVectorNegate(c03 * sinX));
+		XMVECTOR invLength = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(nx, nx, XMVectorMultiplyAdd(nz, nz, one)));
+		nx *= invLength;
+		nz *= invLength;
+
+		XMFLOAT4 hs, nxs, nys, nzs;
+		XMStoreFloat4(&hs, h);
+		XMStoreFloat4(&nxs, nx);
+		XMStoreFloat4(&nys, invLength);
+		XMStoreFloat4(&nzs, nz);
+
+		v[0].Position.y = hs.x; v[0].Normal = XMFLOAT3(nxs.x, nys.x, nzs.x);
+		v[1].Position.y = hs.y; v[1].Normal = XMFLOAT3(nxs.y, nys.y, nzs.y);
+		v[2].Position.y = hs.z; v[2].Normal = XMFLOAT3(nxs.z, nys.z, nzs.z);
+		v[3].Position.y = hs.w; v[3].Normal = XMFLOAT3(nxs.w, nys.w, nzs.w);
+	}
+
+	for (; i < count; ++i)
+	{
+		Vertex& v = vertices[i];
+		v.Position.y = GetHillsHeight(v.Position.x, v.Position.z);
+		v.Normal = GetHillsNormal(v.Position.x, v.Position.z);
+	}
+}
+
+void GeometryGenerator::ApplyHills(MeshData& grid, uint32 rowLength)
 {
-	// Save a copy of the input geometry.
-	MeshData inputCopy = meshData;
+	assert(rowLength > 0 && grid.Vertices.size() % rowLength == 0);
 
-	meshData.Vertices.resize(0);
-	meshData.Indices32.resize(0);
+	const uint32 rowCount = (uint32)(grid.Vertices.size() / rowLength);
+	Vertex* vertices = grid.Vertices.data();
 
+	ParallelForRows(0, (int)rowCount, rowLength * sizeof(Vertex), [vertices, rowLength](int rowBegin, int rowEnd)
+	{
+		ApplyHills(vertices + (size_t)rowBegin * rowLength, (size_t)(rowEnd - rowBegin) * rowLength);
+	});
+}
+
+void GeometryGenerator::ApplyHills(TerrainData& terrain)
+{
+	const uint32 tileCount = terrain.TileCountX * terrain.TileCountZ;
+	Vertex* vertices = terrain.Vertices.data();
+	const uint32 tileVertexCount = terrain.TileVertexCount;
+
+	// One tile per task; a tile is already about as large as an L2-sized block.
+	ParallelFor(0, (int)tileCount, 1, [vertices, tileVertexCount](int tileBegin, int tileEnd)
+	{
+		ApplyHills(vertices + (size_t)tileBegin * tileVertexCount, (size_t)(tileEnd - tileBegin) * tileVertexCount);
+	});
+
+	terrain.UpdateTileBounds();
+}
+
+void GeometryGenerator::Subdivide(MeshData& meshData)
+{
 	//       v1
 	//       *
 	//      / \
@@ -490,47 +864,72 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	// *-----*-----*
 	// v0    m2     v2
 
-	uint32 numTris = (uint32)inputCopy.Indices32.size() / 3;
+	// Corner vertices keep their indices; each edge gets exactly one midpoint vertex
+	// that is shared by the two triangles on either side, so a closed mesh grows
+	// from V to V + E vertices instead of 6 per triangle.
+	std::vector<uint32> inputIndices;
+	inputIndices.swap(meshData.Indices32);
+
+	const uint32 numTris = (uint32)inputIndices.size() / 3;
+
+	// Euler: E = 3F/2 for a closed mesh; open meshes have a few more.
+	meshData.Vertices.reserve(meshData.Vertices.size() + numTris * 3 / 2 + 3);
+	meshData.Indices32.reserve(numTris * 12);
+
+	std::unordered_map<std::uint64_t, uint32> midPoints;
+	midPoints.reserve(numTris * 3 / 2 + 3);
+
+	auto GetMidPoint = [&meshData, &midPoints, this](uint32 i0, uint32 i1) -> uint32
+	{
+		const std::uint64_t key = i0 < i1
+			? ((std::uint64_t)i0 << 32) | i1
+			: ((std::uint64_t)i1 << 32) | i0;
+
+		auto found = midPoints.find(key);
+		if (found != midPoints.end())
+		{
+			return found->second;
+		}
+
+		const uint32 index = (uint32)meshData.Vertices.size();
+		meshData.Vertices.push_back(MidPoint(meshData.Vertices[i0], meshData.Vertices[i1]));
+		midPoints.emplace(key, index);
+		return index;
+	};
+
 	for (uint32 i = 0; i < numTris; ++i)
 	{
-		Vertex v0 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 0]];
-		Vertex v1 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 1]];
-		Vertex v2 = inputCopy.Vertices[inputCopy.Indices32[i * 3 + 2]];
+		const uint32 v0 = inputIndices[i * 3 + 0];
+		const uint32 v1 = inputIndices[i * 3 + 1];
+		const uint32 v2 = inputIndices[i * 3 + 2];
 
 		//
 		// Generate the midpoints.
 		//
 
-		Vertex m0 = MidPoint(v0, v1);
-		Vertex m1 = MidPoint(v1, v2);
-		Vertex m2 = MidPoint(v0, v2);
+		const uint32 m0 = GetMidPoint(v0, v1);
+		const uint32 m1 = GetMidPoint(v1, v2);
+		const uint32 m2 = GetMidPoint(v0, v2);
 
 		//
 		// Add new geometry.
 		//
 
-		meshData.Vertices.push_back(v0); // 0
-		meshData.Vertices.push_back(v1); // 1
-		meshData.Vertices.push_back(v2); // 2
-		meshData.Vertices.push_back(m0); // 3
-		meshData.Vertices.push_back(m1); // 4
-		meshData.Vertices.push_back(m2); // 5
-
-		meshData.Indices32.push_back(i * 6 + 0);
-		meshData.Indices32.push_back(i * 6 + 3);
-		meshData.Indices32.push_back(i * 6 + 5);
+		meshData.Indices32.push_back(v0);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m2);
 
-		meshData.Indices32.push_back(i * 6 + 3);
-		meshData.Indices32.push_back(i * 6 + 4);
-		meshData.Indices32.push_back(i * 6 + 5);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(m2);
 
-		meshData.Indices32.push_back(i * 6 + 5);
-		meshData.Indices32.push_back(i * 6 + 4);
-		meshData.Indices32.push_back(i * 6 + 2);
+		meshData.Indices32.push_back(m2);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(v2);
 
-		meshData.Indices32.push_back(i * 6 + 3);
-		meshData.Indices32.push_back(i * 6 + 1);
-		meshData.Indices32.push_back(i * 6 + 4);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(v1);
+		meshData.Indices32.push_back(m1);
 	}
 }
 
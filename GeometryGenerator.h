@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <memory>
 #include <unordered_map>
+#include <cassert>
 
 // Defines a subrange of geometry in a MeshGeometry.  
 // This is for when multiple geometries are stored in one vertex and index buffer.  
@@ -23,6 +24,15 @@ public:
 	// Bounding box of the geometry defined by this submesh. 
 	// This is used in later chapters of the book.
 	DirectX::BoundingBox Bounds;
+
+	// Sphere around Bounds.Center through the farthest vertex; used for culling.
+	DirectX::BoundingSphere SphereBounds;
+
+	// Fits Bounds and SphereBounds to the vertices this submesh indexes.  vertices is the
+	// start of the whole vertex buffer, vertexStride bytes per vertex with the position
+	// first; indices is the start of the whole index buffer.
+	void FitBounds(const void* vertices, UINT vertexStride, const std::uint16_t* indices);
+	void FitBounds(const void* vertices, UINT vertexStride, const std::uint32_t* indices);
 };
 
 struct MeshGeometry
@@ -31,6 +41,9 @@ public:
 	// Give it a name so we can look it up by name.
 	std::string Name;
 
+	// Small dense id used in draw sort keys; assigned by the app once all geometry is built.
+	UINT SortId = 0;
+
 	// System memory copies.  Use Blobs because the vertex/index format can be generic.
 	// It is up to the client to cast appropriately.  
 	Microsoft::WRL::ComPtr<ID3DBlob> VertexBufferCPU = nullptr;
@@ -72,12 +85,52 @@ public:
 		return ibv;
 	}
 
+	// VertexBufferView()/IndexBufferView() for the draw loop, rebuilt only when the buffer
+	// behind them changes (the waves point VertexBufferGPU at a new upload buffer each
+	// frame).  Call InvalidateBufferViews() after changing a size or format in place.
+	const D3D12_VERTEX_BUFFER_VIEW& CachedVertexBufferView()
+	{
+		if (mCachedVertexBuffer != VertexBufferGPU.Get())
+		{
+			mCachedVertexBufferView = VertexBufferView();
+			mCachedVertexBuffer = VertexBufferGPU.Get();
+		}
+		return mCachedVertexBufferView;
+	}
+
+	const D3D12_INDEX_BUFFER_VIEW& CachedIndexBufferView()
+	{
+		if (mCachedIndexBuffer != IndexBufferGPU.Get())
+		{
+			mCachedIndexBufferView = IndexBufferView();
+			mCachedIndexBuffer = IndexBufferGPU.Get();
+		}
+		return mCachedIndexBufferView;
+	}
+
+	void InvalidateBufferViews()
+	{
+		mCachedVertexBuffer = nullptr;
+		mCachedIndexBuffer = nullptr;
+	}
+
+	// Fits Bounds and SphereBounds of every submesh in DrawArgs to the vertices it indexes.
+	// Reads the CPU copies, so call it before they are released.  Assumes the position is
+	// the first member of each vertex.
+	void ComputeSubmeshBounds();
+
 	// We can free this memory after we finish upload to the GPU.
 	void DisposeUploaders()
 	{
 		VertexBufferUploader = nullptr;
 		IndexBufferUploader = nullptr;
 	}
+
+private:
+	ID3D12Resource* mCachedVertexBuffer = nullptr;
+	ID3D12Resource* mCachedIndexBuffer = nullptr;
+	D3D12_VERTEX_BUFFER_VIEW mCachedVertexBufferView = {};
+	D3D12_INDEX_BUFFER_VIEW mCachedIndexBufferView = {};
 };
 
 class GeometryGenerator
@@ -120,6 +173,9 @@ public:
 
 		std::vector<std::uint16_t>& GetIndices16()
 		{
+			// Larger meshes would silently wrap; split them first (see CreateTerrain).
+			assert(Vertices.size() <= 0x10000);
+
 			if (mIndices16.empty())
 			{
 				mIndices16.resize(Indices32.size());
@@ -141,10 +197,75 @@ public:
 	MeshData CreateGrid(float width, float depth, uint32 m, uint32 n);
 	MeshData CreateQuad(float x, float y, float w, float h, float depth);
 
+	// A width x depth grid split into tileCountX x tileCountZ square tiles of tileQuads x tileQuads
+	// quads each.  Every tile owns a copy of its border vertices (with exactly the same position as
+	// the neighbour's), so each tile is an independently culled, 16-bit addressable draw with its own
+	// BaseVertexLocation and bounds.  Since all tiles share one vertex layout, a single index set per
+	// (LOD, stitch mask) serves every tile.
+	struct TerrainData
+	{
+	public:
+		// Stitch mask bits: the neighbouring tile on that side is drawn one LOD coarser.
+		// Neighbouring tiles must not differ by more than one LOD.
+		enum StitchEdge : uint32
+		{
+			StitchNorth = 1, // row 0 (+z)
+			StitchSouth = 2, // last row (-z)
+			StitchWest = 4,  // column 0 (-x)
+			StitchEast = 8,  // last column (+x)
+			StitchMaskCount = 16,
+		};
+
+		std::vector<Vertex> Vertices;
+		std::vector<uint16> Indices16;
+
+		uint32 TileCountX = 0;
+		uint32 TileCountZ = 0;
+		uint32 TileQuads = 0;
+		uint32 TileVertexCount = 0;
+		uint32 LodCount = 0;
+
+		std::vector<DirectX::BoundingBox> TileBounds;
+
+		// Draw arguments for one tile at the given LOD (0 = full detail) with Bounds filled in.
+		SubmeshGeometry GetTileSubmesh(uint32 tileX, uint32 tileZ, uint32 lod, uint32 stitchMask) const;
+
+		// Recomputes TileBounds; call after displacing the vertices.
+		void UpdateTileBounds();
+
+		// Picks each tile's LOD from the distance between eye and its bounds, one LOD per
+		// lodDistance, then refines tiles until no two neighbours are more than one LOD apart
+		// and fills in the matching stitch masks.  Both arrays are indexed tileZ * TileCountX
+		// + tileX; pass the results to GetTileSubmesh.
+		void SelectTileLods(const DirectX::XMFLOAT3& eye, float lodDistance,
+			std::vector<uint32>& lods, std::vector<uint32>& stitchMasks) const;
+
+	private:
+		friend class GeometryGenerator;
+
+		// (StartIndexLocation, IndexCount) for index set lod * StitchMaskCount + stitchMask.
+		std::vector<std::pair<uint32, uint32>> mIndexRanges;
+	};
+
+	// tileQuads must be a power of two no larger than 128 so a tile fits 16-bit indices.
+	// LOD l uses every 2^l-th vertex; lodCount is clamped to log2(tileQuads) + 1.
+	TerrainData CreateTerrain(float width, float depth, uint32 tileCountX, uint32 tileCountZ, uint32 tileQuads, uint32 lodCount);
+
 public:
 	static float GetHillsHeight(float x, float z);
 	static DirectX::XMFLOAT3 GetHillsNormal(float x, float z);
 
+	// Batched GetHillsHeight/GetHillsNormal.  Replaces Position.y and Normal of count
+	// vertices, four at a time using DirectXMath's vectorized sin/cos approximations.
+	static void ApplyHills(Vertex* vertices, size_t count);
+
+	// Applies the hills surface to a grid from CreateGrid, spreading blocks of its rows
+	// of rowLength (= n) vertices across cores.
+	static void ApplyHills(MeshData& grid, uint32 rowLength);
+
+	// Applies the hills surface to every terrain tile in parallel and updates the tile bounds.
+	static void ApplyHills(TerrainData& terrain);
+
 private:
 	void Subdivide(MeshData& meshData);
 	Vertex MidPoint(const Vertex& v0, const Vertex& v1);
@@ -0,0 +1,207 @@
+#include "d3dApp.h"
+#include "UploadBuffer.h"
+#include "Profiler.h"
+#include "StageTimer.h"
+
+#include <cstdio>
+
+using namespace DirectX;
+
+namespace
+{
+    void PrintLine(const char* Line)
+    {
+        fputs(Line, stdout);
+        OutputDebugStringA(Line);
+    }
+}
+
+int D3D12::RunHeadlessBenchmark(const HeadlessBenchmarkDesc& Desc)
+{
+    SetFrameResourceCount(Desc.FrameResourceCount);
+
+    //
+    // Synthetic scene: materials, render items and waves, with frame resources in
+    // system memory instead of upload heaps.
+    //
+
+    for (int i = 0; i < Desc.MaterialCount; ++i)
+    {
+        auto Mat = std::make_unique<Material>();
+        Mat->Name = (i == 0) ? "Water" : "Bench" + std::to_string(i);
+        Mat->MatCBIndex = i;
+        Mat->DiffuseAlbedo = XMFLOAT4(MathHelper::RandF(), MathHelper::RandF(), MathHelper::RandF(), 1.0f);
+        Mat->Roughness = MathHelper::RandF();
+        mDirtyMaterials.Mark(Mat.get());
+        mMaterials[Mat->Name] = std::move(Mat);
+    }
+
+    mWaves = std::make_unique<Waves>(Desc.WaveRowCount, Desc.WaveColumnCount, 1.0f, 0.03f, 4.0f, 0.2f);
+
+    auto WaterMat = mMaterials.find("Water");
+    Material* DefaultMat = (WaterMat != mMaterials.end()) ? WaterMat->second.get() : nullptr;
+
+    std::vector<Material*> Materials;
+    for (auto& e : mMaterials)
+    {
+        Materials.push_back(e.second.get());
+    }
+
+    auto WaveGeo = std::make_unique<MeshGeometry>();
+    WaveGeo->Name = "WaterGeo";
+
+    for (int i = 0; i < Desc.RenderItemCount; ++i)
+    {
+        auto Ritem = std::make_unique<RenderItem>();
+        XMStoreFloat4x4(&Ritem->World, XMMatrixTranslation(
+            MathHelper::RandF(-100.0f, 100.0f), MathHelper::RandF(0.0f, 10.0f), MathHelper::RandF(-100.0f, 100.0f)));
+        Ritem->ObjectCBIndex = (UINT)i;
+        // Item 0 drives the waves; the rest spread over all materials so the draw sort has
+        // state to group by.
+        Ritem->Mat = (i == 0 || Materials.empty()) ? DefaultMat : Materials[MathHelper::Rand(0, (int)Materials.size() - 1)];
+        Ritem->Geo = WaveGeo.get();
+        Ritem->Bounds.Radius = MathHelper::RandF(0.5f, 4.0f);
+        mDirtyRitems.Mark(Ritem.get());
+        mRitemLayer[(int)RenderLayer::Opaque].push_back(Ritem.get());
+        mAllRitems.push_back(std::move(Ritem));
+    }
+    mCullSet.Resize((UINT)mAllRitems.size());
+    WavesRenderItem = mAllRitems.empty() ? nullptr : mAllRitems[0].get();
+
+    // One instanced item spread over the same area, drawn with a single call.
+    if (Desc.InstanceCount > 0)
+    {
+        auto Instanced = std::make_unique<InstancedRenderItem>();
+        Instanced->Mat = DefaultMat;
+        Instanced->Geo = WaveGeo.get();
+        Instanced->Bounds.Radius = 2.0f;
+        Instanced->Instances.resize(Desc.InstanceCount);
+        for (RenderInstance& Instance : Instanced->Instances)
+        {
+            XMStoreFloat4x4(&Instance.World, XMMatrixTranslation(
+                MathHelper::RandF(-100.0f, 100.0f), MathHelper::RandF(0.0f, 10.0f), MathHelper::RandF(-100.0f, 100.0f)));
+            Instance.Mat = Materials.empty() ? nullptr : Materials[MathHelper::Rand(0, (int)Materials.size() - 1)];
+        }
+        mInstancedRitems.push_back(std::move(Instanced));
+        mInstanceCullSet.Resize((UINT)Desc.InstanceCount);
+    }
+    mGeometries[WaveGeo->Name] = std::move(WaveGeo);
+
+    for (int i = 0; i < gNumFrameResources; ++i)
+    {
+        mFrameResources.push_back(std::make_unique<FrameResource>(2, (UINT)mAllRitems.size(), (UINT)mMaterials.size(),
+            WavesRenderItem ? (UINT)mWaves->VertexCount() : 0, mInstanceCullSet.Size()));
+    }
+
+    XMStoreFloat4x4(&mProj, XMMatrixPerspectiveFovLH(0.25f * MathHelper::Pi, AspectRatio(), 0.1f, 1000.0f));
+
+    //
+    // Frame loop.  Each frame dirties a fixed share of items and materials, then runs the
+    // same update stages as Update(), minus the fence wait.
+    //
+
+    StageSamples AnimateStage;      AnimateStage.Name = "AnimateMaterials";
+    StageSamples ObjectStage;       ObjectStage.Name = "UpdateObjectCBs";
+    StageSamples MaterialStage;     MaterialStage.Name = "UpdateMaterialCBs";
+    StageSamples PassStage;         PassStage.Name = "UpdateMainPassCBs";
+    StageSamples CullStage;         CullStage.Name = "CullRenderItems";
+    StageSamples SortStage;         SortStage.Name = "SortRenderItems";
+    StageSamples InstanceStage;     InstanceStage.Name = "UpdateInstanceBuffer";
+    StageSamples WavesStage;        WavesStage.Name = "UpdateWaves";
+    StageSamples FrameStage;        FrameStage.Name = "Frame";
+
+    const int DirtyItemCount = (int)(Desc.DirtyRenderItemFraction * (float)mAllRitems.size());
+    const int DirtyMaterialCount = (int)(Desc.DirtyMaterialFraction * (float)Materials.size());
+    size_t NextDirtyItem = 0;
+    size_t NextDirtyMaterial = 0;
+
+    mTimer.Reset();
+
+    const int TotalFrameCount = Desc.WarmupFrameCount + Desc.FrameCount;
+    for (int Frame = 0; Frame < TotalFrameCount; ++Frame)
+    {
+        const bool Record = Frame >= Desc.WarmupFrameCount;
+
+        if (Frame == Desc.WarmupFrameCount && !Desc.TraceFilename.empty())
+        {
+            Profiler::CaptureFrames(Desc.FrameCount, Desc.TraceFilename);
+        }
+
+        mTimer.Advance(Desc.DeltaTime);
+
+        for (int i = 0; i < DirtyItemCount; ++i)
+        {
+            RenderItem* Ritem = mAllRitems[NextDirtyItem].get();
+            Ritem->World(3, 1) += 0.01f;
+            mDirtyRitems.Mark(Ritem);
+            NextDirtyItem = (NextDirtyItem + 1) % mAllRitems.size();
+        }
+
+        for (int i = 0; i < DirtyMaterialCount; ++i)
+        {
+            Material* Mat = Materials[NextDirtyMaterial];
+            Mat->Roughness = MathHelper::RandF();
+            mDirtyMaterials.Mark(Mat);
+            NextDirtyMaterial = (NextDirtyMaterial + 1) % Materials.size();
+        }
+
+        TimeStage(FrameStage, Record, [&]()
+        {
+            UpdateCamera(mTimer);
+
+            mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % (int)mFrameResources.size();
+            mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
+
+            TimeStage(AnimateStage, Record, [&]() { AnimateMaterials(mTimer); });
+            TimeStage(ObjectStage, Record, [&]() { UpdateObjectCBs(mTimer); });
+            TimeStage(MaterialStage, Record, [&]() { UpdateMaterialCBs(mTimer); });
+            TimeStage(PassStage, Record, [&]() { UpdateMainPassCBs(mTimer); });
+            TimeStage(WavesStage, Record, [&]()
+            {
+                if (WavesRenderItem)
+                {
+                    UpdateWaves(mTimer);
+                }
+            });
+            TimeStage(CullStage, Record, [&]() { CullRenderItems(); });
+            TimeStage(SortStage, Record, [&]() { SortRenderItems(); });
+            TimeStage(InstanceStage, Record, [&]() { UpdateInstanceBuffer(); });
+        });
+
+        Profiler::EndFrame();
+    }
+
+    char Line[256];
+    snprintf(Line, sizeof(Line), "Headless benchmark: %d frames (+%d warmup), %d render items, %d materials, %dx%d waves\n",
+        Desc.FrameCount, Desc.WarmupFrameCount, (int)mAllRitems.size(), (int)mMaterials.size(),
+        Desc.WaveRowCount, Desc.WaveColumnCount);
+    PrintLine(Line);
+    PrintStageHeader(PrintLine);
+
+    for (const StageSamples* Stage : { &AnimateStage, &ObjectStage, &MaterialStage, &PassStage, &WavesStage, &CullStage, &SortStage, &InstanceStage, &FrameStage })
+    {
+        PrintStage(*Stage, PrintLine);
+    }
+
+    double CullMilliseconds = 0.0;
+    for (double Value : CullStage.Milliseconds)
+    {
+        CullMilliseconds += Value;
+    }
+    if (CullMilliseconds > 0.0)
+    {
+        snprintf(Line, sizeof(Line), "Culling: %.1f M items/s, %d of %d visible in the last frame\n",
+            (double)(mAllRitems.size() + mInstanceCullSet.Size()) * (double)CullStage.Milliseconds.size() / CullMilliseconds * 1e-3,
+            (int)mVisibleRitems[(int)RenderLayer::Opaque].size(), (int)mAllRitems.size());
+        PrintLine(Line);
+    }
+    for (auto& Item : mInstancedRitems)
+    {
+        snprintf(Line, sizeof(Line), "Instancing: %u of %d instances visible in the last frame, 1 draw\n",
+            Item->VisibleCount, (int)Item->Instances.size());
+        PrintLine(Line);
+    }
+    fflush(stdout);
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+#include "HeadlessBenchmarkDesc.h"
+#include "CommandLineOptions.h"
+
+void HeadlessBenchmarkDesc::ReadOptions(const CommandLineOptions& options)
+{
+    options.CheckKeys({ "frames", "items", "instances", "materials", "waves", "frameresources", "trace" });
+
+    options.Read("frames", 1, FrameCount);
+    options.Read("items", 0, RenderItemCount);
+    options.Read("instances", 0, InstanceCount);
+    options.Read("materials", 1, MaterialCount);
+    options.Read("frameresources", 1, FrameResourceCount);
+    options.Read("trace", TraceFilename);
+
+    // Smaller grids have no interior cells to disturb.
+    options.Read("waves", 16, WaveRowCount);
+    WaveColumnCount = WaveRowCount;
+}
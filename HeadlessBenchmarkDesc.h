@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include "config.h"
+
+class CommandLineOptions;
+
+// Synthetic scene for the headless CPU benchmarks: D3D12::RunHeadlessBenchmark in the
+// game ("-benchmark") and the portable WEHeadlessBenchmark tool.
+struct HeadlessBenchmarkDesc
+{
+	int WarmupFrameCount = 100;
+	int FrameCount = 1000;
+
+	int RenderItemCount = 5000;
+	int MaterialCount = 500;
+
+	// Share of render items / materials whose constants change every frame.
+	float DirtyRenderItemFraction = 0.1f;
+	float DirtyMaterialFraction = 0.1f;
+
+	// Instances of one instanced render item; 0 for none.
+	int InstanceCount = 10000;
+
+	int WaveRowCount = 128;
+	int WaveColumnCount = 128;
+
+	int FrameResourceCount = NUM_FRAME_RESOURCES;
+
+	float DeltaTime = 1.0f / 60.0f;
+
+	// If set, the measured frames are also written here as a Chrome trace.
+	std::string TraceFilename;
+
+	// Applies the options frames=N items=N instances=N materials=N waves=N
+	// frameresources=N trace=file.json.  Throws std::invalid_argument for bad values or
+	// any other key.
+	void ReadOptions(const CommandLineOptions& options);
+};
@@ -19,9 +19,11 @@ public:
 
     // Dirty flag indicating the material has changed and we need to update the constant buffer.
     // Because we have a material constant buffer for each FrameResource, we have to apply the
-    // update to each FrameResource.  Thus, when we modify a material we should set 
-    // NumFramesDirty = gNumFrameResources so that each frame resource gets the update.
-    int NumFramesDirty = NUM_FRAME_RESOURCES;
+    // update to each FrameResource.  Thus, when we modify a material we should mark it in the
+    // app's DirtyList, which sets NumFramesDirty = gNumFrameResources so that each frame
+    // resource gets the update.
+    int NumFramesDirty = gNumFrameResources;
+    bool InDirtyList = false;
     
 
     // Material constant buffer data used for shading.
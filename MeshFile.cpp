@@ -0,0 +1,204 @@
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+	template<typename IndexT>
+	bool IndicesInRange(const IndexT* indices, const MeshFileSubmesh& subMesh, std::uint64_t vertexCount)
+	{
+		// ReadTable guarantees 0 <= BaseVertexLocation <= VertexCount.
+		const std::uint64_t limit = vertexCount - (std::uint64_t)subMesh.BaseVertexLocation;
+		const IndexT* begin = indices + subMesh.StartIndexLocation;
+		const IndexT* end = begin + subMesh.IndexCount;
+		for (const IndexT* index = begin; index != end; ++index)
+		{
+			if (*index >= limit)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+std::uint64_t MeshFile::VertexDataSize(const MeshFileHeader& header)
+{
+	return (std::uint64_t)header.VertexCount * header.VertexByteStride;
+}
+
+std::uint64_t MeshFile::IndexDataSize(const MeshFileHeader& header)
+{
+	return (std::uint64_t)header.IndexCount * header.IndexByteStride;
+}
+
+bool MeshFile::Write(std::ostream& out, const MeshFileHeader& header, const std::vector<MeshFileSubmesh>& submeshes,
+	const void* vertices, const void* indices)
+{
+	MeshFileHeader fileHeader = header;
+	fileHeader.Magic = Magic;
+	fileHeader.Version = Version;
+	fileHeader.SubmeshCount = (std::uint32_t)submeshes.size();
+
+	out.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+	out.write(reinterpret_cast<const char*>(submeshes.data()), (std::streamsize)(submeshes.size() * sizeof(MeshFileSubmesh)));
+	out.write(static_cast<const char*>(vertices), (std::streamsize)VertexDataSize(fileHeader));
+	out.write(static_cast<const char*>(indices), (std::streamsize)IndexDataSize(fileHeader));
+
+	return out.good();
+}
+
+bool MeshFile::ReadTable(std::istream& in, std::uint64_t fileSize, std::uint32_t vertexByteStride,
+	MeshFileHeader& header, std::vector<MeshFileSubmesh>& submeshes)
+{
+	if (fileSize < sizeof(MeshFileHeader))
+	{
+		return false;
+	}
+
+	in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	// Treat any layout change as a cache miss so the caller rebuilds the file.
+	if (!in ||
+		header.Magic != Magic ||
+		header.Version != Version ||
+		header.VertexByteStride != vertexByteStride ||
+		(header.IndexByteStride != sizeof(std::uint16_t) && header.IndexByteStride != sizeof(std::uint32_t)))
+	{
+		return false;
+	}
+
+	const std::uint64_t tableSize = (std::uint64_t)header.SubmeshCount * sizeof(MeshFileSubmesh);
+	const std::uint64_t vertexDataSize = VertexDataSize(header);
+	const std::uint64_t indexDataSize = IndexDataSize(header);
+
+	// Each term is below 2^36, so the sum cannot wrap.
+	if (sizeof(MeshFileHeader) + tableSize + vertexDataSize + indexDataSize != fileSize ||
+		vertexDataSize > UINT32_MAX || indexDataSize > UINT32_MAX)
+	{
+		return false;
+	}
+
+	submeshes.resize(header.SubmeshCount);
+	in.read(reinterpret_cast<char*>(submeshes.data()), (std::streamsize)tableSize);
+	if (!in)
+	{
+		return false;
+	}
+
+	for (const MeshFileSubmesh& subMesh : submeshes)
+	{
+		if ((std::uint64_t)subMesh.StartIndexLocation + subMesh.IndexCount > header.IndexCount ||
+			subMesh.BaseVertexLocation < 0 ||
+			(std::uint32_t)subMesh.BaseVertexLocation > header.VertexCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MeshFile::ValidateIndices(const MeshFileHeader& header, const std::vector<MeshFileSubmesh>& submeshes,
+	const void* indices)
+{
+	for (const MeshFileSubmesh& subMesh : submeshes)
+	{
+		const bool inRange = header.IndexByteStride == sizeof(std::uint16_t) ?
+			IndicesInRange(static_cast<const std::uint16_t*>(indices), subMesh, header.VertexCount) :
+			IndicesInRange(static_cast<const std::uint32_t*>(indices), subMesh, header.VertexCount);
+		if (!inRange)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool MeshFile::WriteMesh(std::ostream& out, const std::vector<MeshFileSubmesh>& submeshes,
+	const void* vertices, std::uint32_t vertexCount, std::uint32_t vertexByteStride,
+	const std::vector<std::uint32_t>& indices32)
+{
+	MeshFileHeader header;
+	header.VertexCount = vertexCount;
+	header.VertexByteStride = vertexByteStride;
+	header.IndexCount = (std::uint32_t)indices32.size();
+
+	if (FitsIndices16(indices32))
+	{
+		header.IndexByteStride = sizeof(std::uint16_t);
+		const std::vector<std::uint16_t> indices16 = ToIndices16(indices32);
+		return Write(out, header, submeshes, vertices, indices16.data());
+	}
+
+	header.IndexByteStride = sizeof(std::uint32_t);
+	return Write(out, header, submeshes, vertices, indices32.data());
+}
+
+bool MeshFile::Read(std::istream& in, std::uint32_t vertexByteStride, MeshFileHeader& header,
+	std::vector<MeshFileSubmesh>& submeshes, const AllocateArrays& allocate)
+{
+	const std::streamoff start = in.tellg();
+	in.seekg(0, std::ios_base::end);
+	const std::streamoff end = in.tellg();
+	in.seekg(start, std::ios_base::beg);
+	if (!in || start < 0 || end < start)
+	{
+		return false;
+	}
+
+	if (!ReadTable(in, (std::uint64_t)(end - start), vertexByteStride, header, submeshes))
+	{
+		return false;
+	}
+
+	void* vertices = nullptr;
+	void* indices = nullptr;
+	if (!allocate(header, vertices, indices))
+	{
+		return false;
+	}
+
+	// ReadTable checked both sizes against the stream length.
+	in.read(static_cast<char*>(vertices), (std::streamsize)VertexDataSize(header));
+	in.read(static_cast<char*>(indices), (std::streamsize)IndexDataSize(header));
+
+	return in && ValidateIndices(header, submeshes, indices);
+}
+
+void MeshFile::SetName(MeshFileSubmesh& subMesh, const std::string& name)
+{
+	assert(name.size() < sizeof(subMesh.Name));
+	std::memset(subMesh.Name, 0, sizeof(subMesh.Name));
+	std::memcpy(subMesh.Name, name.c_str(), (std::min)(name.size(), sizeof(subMesh.Name) - 1));
+}
+
+std::string MeshFile::GetName(const MeshFileSubmesh& subMesh)
+{
+	const char* end = std::find(subMesh.Name, subMesh.Name + sizeof(subMesh.Name), '\0');
+	return std::string(subMesh.Name, end);
+}
+
+bool MeshFile::FitsIndices16(const std::vector<std::uint32_t>& indices32)
+{
+	for (std::uint32_t index : indices32)
+	{
+		if (index > 0xffff)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<std::uint16_t> MeshFile::ToIndices16(const std::vector<std::uint32_t>& indices32)
+{
+	std::vector<std::uint16_t> indices16(indices32.size());
+	for (size_t i = 0; i < indices32.size(); ++i)
+	{
+		indices16[i] = static_cast<std::uint16_t>(indices32[i]);
+	}
+	return indices16;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Binary mesh cache (*.wem) layout:
+//
+//   MeshFileHeader
+//   MeshFileSubmesh[SubmeshCount]
+//   Vertex[VertexCount]
+//   uint16 or uint32 index[IndexCount]
+//
+// The vertex and index arrays are stored exactly as they are uploaded to the GPU,
+// so they can be read straight into the MeshGeometry CPU blobs.
+struct MeshFileHeader
+{
+	std::uint32_t Magic = 0;
+	std::uint32_t Version = 0;
+	std::uint32_t VertexCount = 0;
+	std::uint32_t VertexByteStride = 0;
+	std::uint32_t IndexCount = 0;
+	std::uint32_t IndexByteStride = 0;
+	std::uint32_t SubmeshCount = 0;
+	std::uint32_t Reserved = 0;
+};
+
+// Draw arguments of one submesh.  The bounds are the SubmeshGeometry Bounds box and the
+// radius of SphereBounds, which is centered on the box.
+struct MeshFileSubmesh
+{
+	char Name[32] = {};
+	std::uint32_t IndexCount = 0;
+	std::uint32_t StartIndexLocation = 0;
+	std::int32_t BaseVertexLocation = 0;
+	DirectX::XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 BoundsExtents = { 0.0f, 0.0f, 0.0f };
+	float SphereRadius = 0.0f;
+};
+
+// Reading and writing of the *.wem container.  Knows nothing about the vertex format
+// beyond its stride, so it builds without D3D; MeshLoader turns the contents into a
+// MeshGeometry.
+class MeshFile
+{
+public:
+	static const std::uint32_t Magic = 0x534D4557; // "WEMS"
+	static const std::uint32_t Version = 4;
+
+	// Called by Read once the header and submesh table are checked.  Points vertices and
+	// indices at storage for VertexDataSize(header) and IndexDataSize(header) bytes, or
+	// returns false to abandon the read.
+	using AllocateArrays = std::function<bool(const MeshFileHeader& header, void*& vertices, void*& indices)>;
+
+	// Byte sizes of the vertex and index arrays header describes.
+	static std::uint64_t VertexDataSize(const MeshFileHeader& header);
+	static std::uint64_t IndexDataSize(const MeshFileHeader& header);
+
+	// Writes header (with Magic and Version filled in), the submesh table and the two
+	// arrays, whose sizes follow from the header.
+	static bool Write(std::ostream& out, const MeshFileHeader& header, const std::vector<MeshFileSubmesh>& submeshes,
+		const void* vertices, const void* indices);
+
+	// Reads the header and submesh table of a stream of fileSize bytes and checks them
+	// before anything is allocated: magic, version, vertex stride, an index stride of 2
+	// or 4, a total size (in 64 bits) equal to fileSize, arrays under 4 GB and submesh
+	// ranges inside the arrays.  Any mismatch returns false.  On success the stream is
+	// positioned at the vertex array.
+	static bool ReadTable(std::istream& in, std::uint64_t fileSize, std::uint32_t vertexByteStride,
+		MeshFileHeader& header, std::vector<MeshFileSubmesh>& submeshes);
+
+	// True if every index of every submesh, offset by its BaseVertexLocation, names one
+	// of the VertexCount vertices.  Assumes the table passed ReadTable.
+	static bool ValidateIndices(const MeshFileHeader& header, const std::vector<MeshFileSubmesh>& submeshes,
+		const void* indices);
+
+	// Writes a whole mesh of vertexCount vertices.  The indices are stored as 16-bit when
+	// they all fit, otherwise as 32-bit.
+	static bool WriteMesh(std::ostream& out, const std::vector<MeshFileSubmesh>& submeshes,
+		const void* vertices, std::uint32_t vertexCount, std::uint32_t vertexByteStride,
+		const std::vector<std::uint32_t>& indices32);
+
+	// Reads a whole mesh from the current position to the end of in: ReadTable, then the
+	// two arrays into the storage allocate provides, then ValidateIndices.
+	static bool Read(std::istream& in, std::uint32_t vertexByteStride, MeshFileHeader& header,
+		std::vector<MeshFileSubmesh>& submeshes, const AllocateArrays& allocate);
+
+	// Submesh names are stored NUL-terminated in MeshFileSubmesh::Name.
+	static void SetName(MeshFileSubmesh& subMesh, const std::string& name);
+	static std::string GetName(const MeshFileSubmesh& subMesh);
+
+	static bool FitsIndices16(const std::vector<std::uint32_t>& indices32);
+	static std::vector<std::uint16_t> ToIndices16(const std::vector<std::uint32_t>& indices32);
+};
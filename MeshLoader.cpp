@@ -0,0 +1,348 @@
+#include "MeshLoader.h"
+#include "MeshTextParser.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+namespace
+{
+    bool GetLastWriteTime(const std::wstring& filename, ULARGE_INTEGER& outTime)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+        if (!GetFileAttributesExW(filename.c_str(), GetFileExInfoStandard, &attributes))
+        {
+            return false;
+        }
+
+        outTime.LowPart = attributes.ftLastWriteTime.dwLowDateTime;
+        outTime.HighPart = attributes.ftLastWriteTime.dwHighDateTime;
+        return true;
+    }
+}
+
+bool MeshLoader::LoadTextMesh(const std::wstring& filename, const std::string& submeshName, MeshData& meshData)
+{
+    PROFILE_ZONE("MeshLoader::LoadTextMesh");
+
+    // Read the whole file with one buffered read and parse it in place.
+    std::ifstream fin(filename, std::ios::binary);
+
+    if (!fin)
+    {
+        return false;
+    }
+
+    fin.seekg(0, std::ios_base::end);
+    const std::streamoff fileSize = fin.tellg();
+    fin.seekg(0, std::ios_base::beg);
+
+    std::vector<char> text((size_t)fileSize);
+    fin.read(text.data(), fileSize);
+    fin.close();
+
+    MeshTextParser parser(text.data(), text.data() + text.size());
+
+    bool parsed = parser.ParseHeader();
+    if (parsed)
+    {
+        meshData.Vertices.resize(parser.VertexCount());
+        meshData.Indices32.resize(3 * (size_t)parser.TriangleCount());
+
+        parsed = parser.ParseVertices(meshData.Vertices.data(), sizeof(Vertex),
+            offsetof(Vertex, Pos), offsetof(Vertex, Normal), offsetof(Vertex, TexC)) &&
+            parser.ParseIndices(meshData.Indices32.data());
+    }
+
+    if (!parsed)
+    {
+        std::string message = "MeshLoader: " + parser.GetError() + "\n";
+        OutputDebugStringA(message.c_str());
+        return false;
+    }
+
+    Submesh subMesh;
+    subMesh.Name = submeshName;
+    subMesh.Geometry.IndexCount = (UINT)meshData.Indices32.size();
+    subMesh.Geometry.StartIndexLocation = 0;
+    subMesh.Geometry.BaseVertexLocation = 0;
+
+    meshData.Submeshes.clear();
+    meshData.Submeshes.push_back(subMesh);
+
+    ComputeSubmeshBounds(meshData);
+
+    return true;
+}
+
+bool MeshLoader::SaveBinaryMesh(const std::wstring& filename, const MeshData& meshData)
+{
+    std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+
+    if (!fout)
+    {
+        return false;
+    }
+
+    std::vector<MeshFileSubmesh> entries(meshData.Submeshes.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const Submesh& subMesh = meshData.Submeshes[i];
+        MeshFileSubmesh& entry = entries[i];
+        MeshFile::SetName(entry, subMesh.Name);
+        entry.IndexCount = subMesh.Geometry.IndexCount;
+        entry.StartIndexLocation = subMesh.Geometry.StartIndexLocation;
+        entry.BaseVertexLocation = subMesh.Geometry.BaseVertexLocation;
+        entry.BoundsCenter = subMesh.Geometry.Bounds.Center;
+        entry.BoundsExtents = subMesh.Geometry.Bounds.Extents;
+        entry.SphereRadius = subMesh.Geometry.SphereBounds.Radius;
+    }
+
+    return MeshFile::WriteMesh(fout, entries, meshData.Vertices.data(), (std::uint32_t)meshData.Vertices.size(),
+        sizeof(Vertex), meshData.Indices32);
+}
+
+bool MeshLoader::LoadBinaryMesh(const std::wstring& filename, MeshGeometry& geo)
+{
+    PROFILE_ZONE("MeshLoader::LoadBinaryMesh");
+
+    std::ifstream fin(filename, std::ios::binary);
+
+    if (!fin)
+    {
+        return false;
+    }
+
+    // Read the packed arrays directly into the blobs; no per-element parsing or copy.
+    Microsoft::WRL::ComPtr<ID3DBlob> vertexBlob;
+    Microsoft::WRL::ComPtr<ID3DBlob> indexBlob;
+    auto CreateBlobs = [&](const MeshFileHeader& header, void*& vertices, void*& indices)
+    {
+        // Read checked both sizes against the file length, so they fit in a UINT.
+        if (FAILED(D3DCreateBlob((UINT)MeshFile::VertexDataSize(header), vertexBlob.GetAddressOf())) ||
+            FAILED(D3DCreateBlob((UINT)MeshFile::IndexDataSize(header), indexBlob.GetAddressOf())))
+        {
+            return false;
+        }
+        vertices = vertexBlob->GetBufferPointer();
+        indices = indexBlob->GetBufferPointer();
+        return true;
+    };
+
+    MeshFileHeader header;
+    std::vector<MeshFileSubmesh> entries;
+    if (!MeshFile::Read(fin, sizeof(Vertex), header, entries, CreateBlobs))
+    {
+        return false;
+    }
+
+    geo.VertexBufferCPU = vertexBlob;
+    geo.IndexBufferCPU = indexBlob;
+    geo.VertexByteStride = header.VertexByteStride;
+    geo.VertexBufferByteSize = (UINT)MeshFile::VertexDataSize(header);
+    geo.IndexFormat = header.IndexByteStride == sizeof(std::uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    geo.IndexBufferByteSize = (UINT)MeshFile::IndexDataSize(header);
+
+    geo.DrawArgs.clear();
+    for (const MeshFileSubmesh& entry : entries)
+    {
+        SubmeshGeometry subMesh;
+        subMesh.IndexCount = entry.IndexCount;
+        subMesh.StartIndexLocation = entry.StartIndexLocation;
+        subMesh.BaseVertexLocation = entry.BaseVertexLocation;
+        subMesh.Bounds.Center = entry.BoundsCenter;
+        subMesh.Bounds.Extents = entry.BoundsExtents;
+        subMesh.SphereBounds.Center = entry.BoundsCenter;
+        subMesh.SphereBounds.Radius = entry.SphereRadius;
+
+        geo.DrawArgs[MeshFile::GetName(entry)] = subMesh;
+    }
+
+    return true;
+}
+
+bool MeshLoader::ConvertTextMesh(const std::wstring& textFilename, const std::wstring& binaryFilename, const std::string& submeshName)
+{
+    MeshData meshData;
+    if (!LoadTextMesh(textFilename, submeshName, meshData))
+    {
+        return false;
+    }
+
+    OptimizeMesh(meshData);
+
+    return SaveBinaryMesh(binaryFilename, meshData);
+}
+
+bool MeshLoader::LoadCachedMesh(const std::wstring& textFilename, const std::wstring& binaryFilename,
+    const std::string& submeshName, MeshGeometry& geo)
+{
+    PROFILE_ZONE("MeshLoader::LoadCachedMesh");
+
+    ULARGE_INTEGER textTime = {};
+    ULARGE_INTEGER binaryTime = {};
+    const bool hasText = GetLastWriteTime(textFilename, textTime);
+    const bool hasBinary = GetLastWriteTime(binaryFilename, binaryTime);
+
+    if (hasBinary && (!hasText || binaryTime.QuadPart >= textTime.QuadPart))
+    {
+        if (LoadBinaryMesh(binaryFilename, geo))
+        {
+            return true;
+        }
+    }
+
+    MeshData meshData;
+    if (!LoadTextMesh(textFilename, submeshName, meshData))
+    {
+        return false;
+    }
+
+    OptimizeMesh(meshData);
+
+    // Failing to write the cache is not fatal; we just parse the text again next run.
+    SaveBinaryMesh(binaryFilename, meshData);
+
+    FillMeshGeometry(meshData, geo);
+    return true;
+}
+
+void MeshLoader::FillMeshGeometry(const MeshData& meshData, MeshGeometry& geo)
+{
+    const bool use16BitIndices = FitsIndices16(meshData);
+    const UINT indexByteStride = use16BitIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t);
+
+    const UINT vbByteSize = (UINT)meshData.Vertices.size() * sizeof(Vertex);
+    const UINT ibByteSize = (UINT)meshData.Indices32.size() * indexByteStride;
+
+    ThrowIfFailed(D3DCreateBlob(vbByteSize, geo.VertexBufferCPU.ReleaseAndGetAddressOf()));
+    CopyMemory(geo.VertexBufferCPU->GetBufferPointer(), meshData.Vertices.data(), vbByteSize);
+
+    ThrowIfFailed(D3DCreateBlob(ibByteSize, geo.IndexBufferCPU.ReleaseAndGetAddressOf()));
+    if (use16BitIndices)
+    {
+        std::vector<std::uint16_t> indices16 = MeshFile::ToIndices16(meshData.Indices32);
+        CopyMemory(geo.IndexBufferCPU->GetBufferPointer(), indices16.data(), ibByteSize);
+    }
+    else
+    {
+        CopyMemory(geo.IndexBufferCPU->GetBufferPointer(), meshData.Indices32.data(), ibByteSize);
+    }
+
+    geo.VertexByteStride = sizeof(Vertex);
+    geo.VertexBufferByteSize = vbByteSize;
+    geo.IndexFormat = use16BitIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    geo.IndexBufferByteSize = ibByteSize;
+
+    geo.DrawArgs.clear();
+    for (const Submesh& subMesh : meshData.Submeshes)
+    {
+        geo.DrawArgs[subMesh.Name] = subMesh.Geometry;
+    }
+}
+
+void MeshLoader::OptimizeMesh(MeshData& meshData)
+{
+    PROFILE_ZONE("MeshLoader::OptimizeMesh");
+
+    // Optimize each submesh as its own vertex/index pair, then lay the results out one
+    // after another.  A vertex shared by two submeshes ends up in both.
+    std::vector<Vertex> vertices;
+    vertices.reserve(meshData.Vertices.size());
+
+    for (Submesh& subMesh : meshData.Submeshes)
+    {
+        SubmeshGeometry& geometry = subMesh.Geometry;
+        const auto first = meshData.Indices32.begin() + geometry.StartIndexLocation;
+        const auto last = first + geometry.IndexCount;
+        const INT base = geometry.BaseVertexLocation;
+        geometry.BaseVertexLocation = (INT)vertices.size();
+        if (geometry.IndexCount == 0)
+        {
+            continue;
+        }
+
+        std::vector<std::uint32_t> indices(first, last);
+        const auto vertexBegin = meshData.Vertices.begin() + base;
+        std::vector<Vertex> submeshVertices(vertexBegin, vertexBegin + *std::max_element(first, last) + 1);
+
+        LogCacheStats(subMesh.Name, MeshOptimizer::Optimize(submeshVertices, indices));
+
+        std::copy(indices.begin(), indices.end(), first);
+        vertices.insert(vertices.end(), submeshVertices.begin(), submeshVertices.end());
+    }
+
+    meshData.Vertices = std::move(vertices);
+
+    CompactIndices(meshData);
+}
+
+void MeshLoader::LogCacheStats(const std::string& name, const MeshOptimizer::Report& report)
+{
+    OutputDebugStringA(("MeshOptimizer: " + MeshOptimizer::FormatReport(name, report)).c_str());
+}
+
+void MeshLoader::CompactIndices(MeshData& meshData)
+{
+    std::vector<MeshOptimizer::IndexRange> ranges(meshData.Submeshes.size());
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        const SubmeshGeometry& geometry = meshData.Submeshes[i].Geometry;
+        ranges[i].IndexCount = geometry.IndexCount;
+        ranges[i].StartIndexLocation = geometry.StartIndexLocation;
+        ranges[i].BaseVertexLocation = geometry.BaseVertexLocation;
+    }
+
+    std::vector<std::uint32_t> vertexSources;
+    const std::vector<MeshOptimizer::IndexChunk> chunks = MeshOptimizer::CompactIndices(
+        meshData.Indices32.data(), ranges, meshData.Vertices.size(), vertexSources);
+    MeshOptimizer::GatherVertices(meshData.Vertices, vertexSources);
+
+    std::vector<Submesh> submeshes(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        const MeshOptimizer::IndexChunk& chunk = chunks[i];
+        submeshes[i].Name = ChunkName(meshData.Submeshes[chunk.Submesh].Name, chunk.Number);
+        submeshes[i].Geometry.IndexCount = chunk.IndexCount;
+        submeshes[i].Geometry.StartIndexLocation = chunk.StartIndexLocation;
+        submeshes[i].Geometry.BaseVertexLocation = chunk.BaseVertexLocation;
+    }
+    meshData.Submeshes = std::move(submeshes);
+
+    ComputeSubmeshBounds(meshData);
+}
+
+std::string MeshLoader::ChunkName(const std::string& submeshName, int chunk)
+{
+    return chunk == 0 ? submeshName : submeshName + "#" + std::to_string(chunk);
+}
+
+std::vector<SubmeshGeometry> MeshLoader::GetSubmeshChunks(const MeshGeometry& geo, const std::string& submeshName)
+{
+    std::vector<SubmeshGeometry> chunks;
+    for (int chunk = 0; ; ++chunk)
+    {
+        auto it = geo.DrawArgs.find(ChunkName(submeshName, chunk));
+        if (it == geo.DrawArgs.end())
+        {
+            break;
+        }
+        chunks.push_back(it->second);
+    }
+    return chunks;
+}
+
+bool MeshLoader::FitsIndices16(const MeshData& meshData)
+{
+    return MeshFile::FitsIndices16(meshData.Indices32);
+}
+
+void MeshLoader::ComputeSubmeshBounds(MeshData& meshData)
+{
+    for (Submesh& subMesh : meshData.Submeshes)
+    {
+        if (subMesh.Geometry.IndexCount != 0)
+        {
+            subMesh.Geometry.FitBounds(meshData.Vertices.data(), sizeof(Vertex), meshData.Indices32.data());
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "d3dUtil.h"
+#include "GeometryGenerator.h"
+#include "FrameResource.h"
+#include "MeshOptimizer.h"
+#include "MeshFile.h"
+
+class MeshLoader
+{
+public:
+	// Largest number of vertices a 16-bit index chunk may reference.
+	static const std::uint32_t MaxChunkVertexCount = MeshOptimizer::MaxChunkVertexCount;
+
+	struct Submesh
+	{
+		std::string Name;
+		SubmeshGeometry Geometry;
+	};
+
+	struct MeshData
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<std::uint32_t> Indices32;
+		std::vector<Submesh> Submeshes;
+	};
+
+	// Parses the VertexCount/TriangleCount/VertexList/TriangleList text format in Models/.
+	// The whole file becomes a single submesh called submeshName.
+	static bool LoadTextMesh(const std::wstring& filename, const std::string& submeshName, MeshData& meshData);
+
+	static bool SaveBinaryMesh(const std::wstring& filename, const MeshData& meshData);
+
+	// Reads a *.wem file straight into the CPU blobs, formats and DrawArgs of geo, bounds
+	// included.  Returns false for a stale or corrupt file.  GPU buffers are left for the
+	// caller to create.
+	static bool LoadBinaryMesh(const std::wstring& filename, MeshGeometry& geo);
+
+	// Offline conversion step: text model -> binary cache.
+	static bool ConvertTextMesh(const std::wstring& textFilename, const std::wstring& binaryFilename, const std::string& submeshName);
+
+	// Loads binaryFilename if it is valid and not older than textFilename, otherwise
+	// converts the text model first and writes the cache for the next run.  Either way
+	// every DrawArgs entry comes with Bounds and SphereBounds filled in.
+	static bool LoadCachedMesh(const std::wstring& textFilename, const std::wstring& binaryFilename,
+		const std::string& submeshName, MeshGeometry& geo);
+
+	// Copies meshData into the CPU blobs, formats and DrawArgs of geo.
+	static void FillMeshGeometry(const MeshData& meshData, MeshGeometry& geo);
+
+	// Mesh build pipeline run before a mesh is cached: MeshOptimizer::Optimize on each
+	// submesh (triangle order kept only if ACMR improves, vertices in first-use order,
+	// unreferenced vertices dropped), then CompactIndices.
+	static void OptimizeMesh(MeshData& meshData);
+
+	// Writes MeshOptimizer::FormatReport to the debugger output.
+	static void LogCacheStats(const std::string& name, const MeshOptimizer::Report& report);
+
+	// Index compaction stage: MeshOptimizer::CompactIndices over the submeshes, which lets
+	// the whole mesh use DXGI_FORMAT_R16_UINT.  A submesh that references more than
+	// MaxChunkVertexCount vertices is split into chunks named "name", "name#1", "name#2",
+	// ... that must all be drawn to draw the original submesh (see GetSubmeshChunks).
+	static void CompactIndices(MeshData& meshData);
+
+	// Name of chunk number chunk (0 = the first, which keeps the submesh name).
+	static std::string ChunkName(const std::string& submeshName, int chunk);
+
+	// Draw arguments of every chunk of submeshName in geo, in order.  Draw all of them to
+	// draw the submesh; empty if geo has no submesh of that name.
+	static std::vector<SubmeshGeometry> GetSubmeshChunks(const MeshGeometry& geo, const std::string& submeshName);
+
+	// True if every index fits in 16 bits (always the case after CompactIndices).
+	static bool FitsIndices16(const MeshData& meshData);
+
+	// Fills in the Bounds and SphereBounds of every submesh from the vertices it references.
+	static void ComputeSubmeshBounds(MeshData& meshData);
+};
@@ -0,0 +1,328 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+    // Size of the LRU cache the optimizer models.  Larger than real post-transform
+    // caches on purpose; the scoring falls off with position so this mostly affects
+    // how far back reuse is still rewarded.
+    const int MaxCacheSize = 32;
+
+    const float CacheDecayPower = 1.5f;
+    const float LastTriScore = 0.75f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+
+    float ScoreVertex(int cachePosition, std::uint32_t remainingTriangles)
+    {
+        // No triangles left means the vertex is never needed again.
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // Vertices of the triangle just emitted get a fixed score so the
+                // optimizer doesn't greedily fan around a single vertex.
+                score = LastTriScore;
+            }
+            else
+            {
+                const float scaler = 1.0f / (MaxCacheSize - 3);
+                score = 1.0f - (cachePosition - 3) * scaler;
+                score = std::pow(score, CacheDecayPower);
+            }
+        }
+
+        // Boost vertices with few triangles left so they get finished off.
+        score += ValenceBoostScale * std::pow((float)remainingTriangles, -ValenceBoostPower);
+        return score;
+    }
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::AnalyzeVertexCache(const std::uint32_t* indices, std::size_t indexCount,
+    std::size_t vertexCount, std::uint32_t cacheSize)
+{
+    CacheStats stats;
+    if (indexCount == 0 || vertexCount == 0 || cacheSize == 0)
+    {
+        return stats;
+    }
+
+    // FIFO cache: a vertex is a hit if it was inserted within the last cacheSize misses.
+    std::vector<std::size_t> insertedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    std::size_t misses = 0;
+    std::size_t uniqueVertices = 0;
+
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        const std::uint32_t v = indices[i];
+        if (!referenced[v])
+        {
+            referenced[v] = true;
+            ++uniqueVertices;
+        }
+
+        if (insertedAt[v] == 0 || misses - insertedAt[v] >= cacheSize)
+        {
+            ++misses;
+            insertedAt[v] = misses;
+        }
+    }
+
+    stats.ACMR = (float)misses / (float)(indexCount / 3);
+    stats.ATVR = (float)misses / (float)uniqueVertices;
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount)
+{
+    const std::size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // Vertex -> triangle adjacency in compressed form.
+    std::vector<std::uint32_t> remainingTriangles(vertexCount, 0);
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        ++remainingTriangles[indices[i]];
+    }
+
+    std::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+    }
+
+    std::vector<std::uint32_t> adjacency(indexCount);
+    std::vector<std::uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (std::size_t t = 0; t < triangleCount; ++t)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            const std::uint32_t v = indices[t * 3 + k];
+            adjacency[fill[v]++] = (std::uint32_t)t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScore[v] = ScoreVertex(-1, remainingTriangles[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (std::size_t t = 0; t < triangleCount; ++t)
+    {
+        triangleScore[t] = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<std::uint32_t> output(indexCount);
+    std::vector<std::uint32_t> cache;
+    std::vector<std::uint32_t> newCache;
+    cache.reserve(MaxCacheSize + 3);
+    newCache.reserve(MaxCacheSize + 3);
+
+    // Fallback cursor for when nothing in the cache has triangles left.
+    std::size_t nextUnemitted = 0;
+    std::size_t bestTriangle = (std::size_t)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+
+    for (std::size_t outTriangle = 0; outTriangle < triangleCount; ++outTriangle)
+    {
+        if (bestTriangle == SIZE_MAX)
+        {
+            while (emitted[nextUnemitted])
+            {
+                ++nextUnemitted;
+            }
+            bestTriangle = nextUnemitted;
+        }
+
+        emitted[bestTriangle] = true;
+
+        // Emit the triangle and detach it from its vertices.
+        const std::uint32_t* tri = &indices[bestTriangle * 3];
+        newCache.clear();
+        for (int k = 0; k < 3; ++k)
+        {
+            const std::uint32_t v = tri[k];
+            output[outTriangle * 3 + k] = v;
+            newCache.push_back(v);
+
+            std::uint32_t* first = &adjacency[adjacencyOffsets[v]];
+            std::uint32_t* last = first + remainingTriangles[v];
+            std::uint32_t* found = std::find(first, last, (std::uint32_t)bestTriangle);
+            std::swap(*found, *(last - 1));
+            --remainingTriangles[v];
+        }
+
+        // The new triangle's vertices move to the front of the LRU cache.
+        for (std::uint32_t v : cache)
+        {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+            {
+                newCache.push_back(v);
+            }
+        }
+
+        // Vertices pushed out of the cache lose their cache score.
+        for (std::size_t i = MaxCacheSize; i < newCache.size(); ++i)
+        {
+            cachePosition[newCache[i]] = -1;
+            vertexScore[newCache[i]] = ScoreVertex(-1, remainingTriangles[newCache[i]]);
+        }
+        if (newCache.size() > (std::size_t)MaxCacheSize)
+        {
+            newCache.resize(MaxCacheSize);
+        }
+
+        for (std::size_t i = 0; i < newCache.size(); ++i)
+        {
+            const std::uint32_t v = newCache[i];
+            cachePosition[v] = (int)i;
+            vertexScore[v] = ScoreVertex((int)i, remainingTriangles[v]);
+        }
+
+        // Rescore the triangles touching the cache and pick the best one.
+        bestTriangle = SIZE_MAX;
+        float bestScore = -1.0f;
+        for (std::uint32_t v : newCache)
+        {
+            const std::uint32_t* first = &adjacency[adjacencyOffsets[v]];
+            for (std::uint32_t j = 0; j < remainingTriangles[v]; ++j)
+            {
+                const std::uint32_t t = first[j];
+                const float score = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                triangleScore[t] = score;
+
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cache.swap(newCache);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+std::size_t MeshOptimizer::OptimizeVertexFetch(std::uint32_t* indices, std::size_t indexCount,
+    std::size_t vertexCount, std::vector<std::uint32_t>& remap)
+{
+    remap.assign(vertexCount, UINT32_MAX);
+
+    std::uint32_t nextVertex = 0;
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        std::uint32_t& index = indices[i];
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+
+    return nextVertex;
+}
+
+std::string MeshOptimizer::FormatReport(const std::string& name, const Report& report)
+{
+    char message[256];
+    snprintf(message, sizeof(message), "%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+        name.c_str(), report.Before.ACMR, report.After.ACMR, report.Before.ATVR, report.After.ATVR);
+    return message;
+}
+
+std::vector<MeshOptimizer::IndexChunk> MeshOptimizer::CompactIndices(std::uint32_t* indices,
+    const std::vector<IndexRange>& submeshes, std::size_t vertexCount, std::vector<std::uint32_t>& vertexSources)
+{
+    const std::uint32_t unmapped = UINT32_MAX;
+
+    std::vector<IndexChunk> chunks;
+    chunks.reserve(submeshes.size());
+
+    vertexSources.clear();
+    vertexSources.reserve(vertexCount);
+
+    // Old vertex index -> index within the current chunk.
+    std::vector<std::uint32_t> remap(vertexCount, unmapped);
+    std::vector<std::uint32_t> touched;
+
+    for (std::size_t s = 0; s < submeshes.size(); ++s)
+    {
+        const IndexRange& source = submeshes[s];
+        const std::uint32_t firstIndex = source.StartIndexLocation;
+        const std::uint32_t endIndex = firstIndex + source.IndexCount;
+
+        IndexChunk chunk;
+        chunk.Submesh = s;
+        chunk.StartIndexLocation = firstIndex;
+        chunk.BaseVertexLocation = (std::int32_t)vertexSources.size();
+
+        auto FinishChunk = [&](std::uint32_t chunkEnd)
+        {
+            chunk.IndexCount = chunkEnd - chunk.StartIndexLocation;
+            chunks.push_back(chunk);
+
+            for (std::uint32_t v : touched)
+            {
+                remap[v] = unmapped;
+            }
+            touched.clear();
+        };
+
+        for (std::uint32_t i = firstIndex; i < endIndex; i += 3)
+        {
+            // Count the vertices this triangle would add so a triangle never straddles chunks.
+            std::uint32_t newVertexCount = 0;
+            for (std::uint32_t k = 0; k < 3; ++k)
+            {
+                if (remap[indices[i + k] + source.BaseVertexLocation] == unmapped)
+                {
+                    ++newVertexCount;
+                }
+            }
+
+            const std::uint32_t chunkVertexCount = (std::uint32_t)vertexSources.size() - chunk.BaseVertexLocation;
+            if (chunkVertexCount + newVertexCount > MaxChunkVertexCount)
+            {
+                FinishChunk(i);
+
+                ++chunk.Number;
+                chunk.StartIndexLocation = i;
+                chunk.BaseVertexLocation = (std::int32_t)vertexSources.size();
+            }
+
+            for (std::uint32_t k = 0; k < 3; ++k)
+            {
+                const std::uint32_t v = indices[i + k] + source.BaseVertexLocation;
+                if (remap[v] == unmapped)
+                {
+                    remap[v] = (std::uint32_t)vertexSources.size() - chunk.BaseVertexLocation;
+                    touched.push_back(v);
+                    vertexSources.push_back(v);
+                }
+                indices[i + k] = remap[v];
+            }
+        }
+
+        FinishChunk(endIndex);
+    }
+
+    return chunks;
+}
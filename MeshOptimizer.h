@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Load-time index/vertex reordering for triangle lists.
+//
+// OptimizeVertexCache reorders triangles for post-transform vertex cache reuse
+// (Forsyth, "Linear-Speed Vertex Cache Optimisation"), then OptimizeVertexFetch
+// reorders vertices into first-use order so vertex fetches walk memory linearly.
+// AnalyzeVertexCache simulates a FIFO cache to report ACMR (transformed vertices
+// per triangle, 0.5 is ideal) and ATVR (transformed vertices per unique vertex,
+// 1.0 is ideal).  Everything here is CPU-only and has no Direct3D dependencies.
+class MeshOptimizer
+{
+public:
+	// Largest number of vertices a 16-bit index chunk may reference.  0xffff itself is
+	// left unused because it doubles as the strip-cut value.
+	static const std::uint32_t MaxChunkVertexCount = 0xffff;
+
+	struct CacheStats
+	{
+		float ACMR = 0.0f;
+		float ATVR = 0.0f;
+	};
+
+	static CacheStats AnalyzeVertexCache(const std::uint32_t* indices, std::size_t indexCount,
+		std::size_t vertexCount, std::uint32_t cacheSize = 16);
+
+	static void OptimizeVertexCache(std::uint32_t* indices, std::size_t indexCount, std::size_t vertexCount);
+
+	// Rewrites indices to first-use order and fills remap (old index -> new index,
+	// UINT32_MAX for unreferenced vertices).  Returns the number of referenced vertices.
+	static std::size_t OptimizeVertexFetch(std::uint32_t* indices, std::size_t indexCount,
+		std::size_t vertexCount, std::vector<std::uint32_t>& remap);
+
+	// Applies a remap produced by OptimizeVertexFetch, dropping unreferenced vertices.
+	template<typename T>
+	static void RemapVertices(std::vector<T>& vertices, const std::vector<std::uint32_t>& remap, std::size_t newVertexCount)
+	{
+		std::vector<T> result(newVertexCount);
+		for (std::size_t i = 0; i < vertices.size(); ++i)
+		{
+			if (remap[i] != UINT32_MAX)
+			{
+				result[remap[i]] = vertices[i];
+			}
+		}
+		vertices.swap(result);
+	}
+
+	struct Report
+	{
+		CacheStats Before;
+		CacheStats After;
+	};
+
+	// "name: ACMR a -> b, ATVR c -> d" with a trailing newline.
+	static std::string FormatReport(const std::string& name, const Report& report);
+
+	// Runs both passes over a whole vertex/index pair.  The triangle order is only
+	// replaced if it lowers ACMR, since some exported models are already well ordered.
+	template<typename T>
+	static Report Optimize(std::vector<T>& vertices, std::vector<std::uint32_t>& indices)
+	{
+		Report report;
+		report.Before = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+		std::vector<std::uint32_t> reordered = indices;
+		OptimizeVertexCache(reordered.data(), reordered.size(), vertices.size());
+		if (AnalyzeVertexCache(reordered.data(), reordered.size(), vertices.size()).ACMR < report.Before.ACMR)
+		{
+			indices.swap(reordered);
+		}
+
+		std::vector<std::uint32_t> remap;
+		const std::size_t newVertexCount = OptimizeVertexFetch(indices.data(), indices.size(), vertices.size(), remap);
+		RemapVertices(vertices, remap, newVertexCount);
+
+		report.After = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		return report;
+	}
+
+	// Draw arguments of one submesh, as in SubmeshGeometry.
+	struct IndexRange
+	{
+		std::uint32_t IndexCount = 0;
+		std::uint32_t StartIndexLocation = 0;
+		std::int32_t BaseVertexLocation = 0;
+	};
+
+	// One draw of a compacted submesh.  Submesh is its position in the ranges passed to
+	// CompactIndices and Number counts its chunks from 0.
+	struct IndexChunk : IndexRange
+	{
+		std::size_t Submesh = 0;
+		int Number = 0;
+	};
+
+	// Rewrites every submesh so that its indices are relative to its own
+	// BaseVertexLocation and reference at most MaxChunkVertexCount vertices, which lets
+	// the whole mesh use 16-bit indices.  A submesh that references more is split into
+	// consecutive chunks, never inside a triangle.  Vertices are laid out per chunk in
+	// first-use order; vertexSources receives the old vertex behind each new one (a
+	// vertex shared by two chunks appears twice).  Returns the chunks in order.
+	static std::vector<IndexChunk> CompactIndices(std::uint32_t* indices, const std::vector<IndexRange>& submeshes,
+		std::size_t vertexCount, std::vector<std::uint32_t>& vertexSources);
+
+	// Builds the vertex array CompactIndices described.
+	template<typename T>
+	static void GatherVertices(std::vector<T>& vertices, const std::vector<std::uint32_t>& vertexSources)
+	{
+		std::vector<T> result;
+		result.reserve(vertexSources.size());
+		for (std::uint32_t source : vertexSources)
+		{
+			result.push_back(vertices[source]);
+		}
+		vertices.swap(result);
+	}
+};
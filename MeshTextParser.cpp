@@ -0,0 +1,213 @@
+#include "MeshTextParser.h"
+
+#include <charconv>
+#include <cstring>
+
+MeshTextParser::MeshTextParser(const char* begin, const char* end)
+    : mCurr(begin), mEnd(end)
+{
+}
+
+bool MeshTextParser::ParseHeader()
+{
+    if (!ExpectToken("VertexCount:") || !ParseUInt(mVertexCount))
+    {
+        return false;
+    }
+    const int vertexCountLine = mLine;
+
+    if (!ExpectToken("TriangleCount:") || !ParseUInt(mTriangleCount))
+    {
+        return false;
+    }
+    const int triangleCountLine = mLine;
+
+    if (!ExpectToken("VertexList"))
+    {
+        return false;
+    }
+
+    // Optional attribute list, e.g. "(pos, normal)" or "(pos, normal, texC)".
+    SkipWhitespace();
+    mHasTexC = false;
+    if (mCurr < mEnd && *mCurr == '(')
+    {
+        const char* listBegin = mCurr;
+        while (mCurr < mEnd && *mCurr != ')' && *mCurr != '\n')
+        {
+            ++mCurr;
+        }
+
+        if (mCurr == mEnd || *mCurr != ')')
+        {
+            return Fail("unterminated VertexList attribute list");
+        }
+
+        for (const char* p = listBegin; p + 3 <= mCurr; ++p)
+        {
+            if ((p[0] == 't' || p[0] == 'T') && p[1] == 'e' && p[2] == 'x')
+            {
+                mHasTexC = true;
+                break;
+            }
+        }
+        ++mCurr;
+    }
+
+    if (!ExpectToken("{"))
+    {
+        return false;
+    }
+
+    // Callers size their arrays from the counts, so reject counts the rest of the file
+    // cannot hold before they allocate.  Each number takes at least one character and a
+    // separator: 12 bytes per vertex (16 with texC) and 6 per triangle.
+    const std::uint64_t remaining = (std::uint64_t)(mEnd - mCurr);
+    const std::uint64_t vertexBytes = (std::uint64_t)mVertexCount * (mHasTexC ? 16 : 12);
+    const std::uint64_t triangleBytes = (std::uint64_t)mTriangleCount * 6;
+    if (vertexBytes > remaining)
+    {
+        return Fail(vertexCountLine, "VertexCount is larger than the file can hold");
+    }
+    if (vertexBytes + triangleBytes > remaining)
+    {
+        return Fail(triangleCountLine, "TriangleCount is larger than the file can hold");
+    }
+
+    return true;
+}
+
+bool MeshTextParser::ParseVertices(void* vertices, std::size_t vertexByteStride,
+    std::size_t posOffset, std::size_t normalOffset, std::size_t texCOffset)
+{
+    char* dst = static_cast<char*>(vertices);
+
+    for (std::uint32_t i = 0; i < mVertexCount; ++i, dst += vertexByteStride)
+    {
+        float* pos = reinterpret_cast<float*>(dst + posOffset);
+        float* normal = reinterpret_cast<float*>(dst + normalOffset);
+        float* texC = reinterpret_cast<float*>(dst + texCOffset);
+
+        if (!ParseFloat(pos[0]) || !ParseFloat(pos[1]) || !ParseFloat(pos[2]) ||
+            !ParseFloat(normal[0]) || !ParseFloat(normal[1]) || !ParseFloat(normal[2]))
+        {
+            return false;
+        }
+
+        if (mHasTexC)
+        {
+            if (!ParseFloat(texC[0]) || !ParseFloat(texC[1]))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            texC[0] = 0.0f;
+            texC[1] = 0.0f;
+        }
+    }
+
+    return ExpectToken("}") && ExpectToken("TriangleList") && ExpectToken("{");
+}
+
+bool MeshTextParser::ParseIndices(std::uint32_t* indices)
+{
+    const std::uint32_t indexCount = 3 * mTriangleCount;
+    for (std::uint32_t i = 0; i < indexCount; ++i)
+    {
+        if (!ParseUInt(indices[i]))
+        {
+            return false;
+        }
+
+        if (indices[i] >= mVertexCount)
+        {
+            return Fail("index out of range");
+        }
+    }
+
+    return ExpectToken("}");
+}
+
+void MeshTextParser::SkipWhitespace()
+{
+    while (mCurr < mEnd)
+    {
+        const char c = *mCurr;
+        if (c == '\n')
+        {
+            ++mLine;
+        }
+        else if (c != ' ' && c != '\t' && c != '\r')
+        {
+            break;
+        }
+        ++mCurr;
+    }
+}
+
+bool MeshTextParser::ExpectToken(const char* token)
+{
+    SkipWhitespace();
+
+    const std::size_t length = std::strlen(token);
+    if ((std::size_t)(mEnd - mCurr) < length || std::memcmp(mCurr, token, length) != 0)
+    {
+        std::string message = "expected '";
+        message += token;
+        message += "'";
+        return Fail(message.c_str());
+    }
+
+    mCurr += length;
+    return true;
+}
+
+bool MeshTextParser::ParseFloat(float& value)
+{
+    SkipWhitespace();
+
+    // from_chars does not accept a leading '+'.
+    if (mCurr < mEnd && *mCurr == '+')
+    {
+        ++mCurr;
+    }
+
+    auto result = std::from_chars(mCurr, mEnd, value);
+    if (result.ec != std::errc())
+    {
+        return Fail("expected a number");
+    }
+
+    mCurr = result.ptr;
+    return true;
+}
+
+bool MeshTextParser::ParseUInt(std::uint32_t& value)
+{
+    SkipWhitespace();
+
+    auto result = std::from_chars(mCurr, mEnd, value);
+    if (result.ec != std::errc())
+    {
+        return Fail("expected an unsigned integer");
+    }
+
+    mCurr = result.ptr;
+    return true;
+}
+
+bool MeshTextParser::Fail(const char* message)
+{
+    return Fail(mLine, message);
+}
+
+bool MeshTextParser::Fail(int line, const char* message)
+{
+    if (mError.empty())
+    {
+        mError = "line " + std::to_string(line) + ": " + message;
+    }
+    return false;
+}
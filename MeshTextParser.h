@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Parser for the Models/*.txt format:
+//
+//   VertexCount: N
+//   TriangleCount: M
+//   VertexList (pos, normal[, texC])
+//   {
+//       px py pz nx ny nz [u v]
+//   }
+//   TriangleList
+//   {
+//       i0 i1 i2
+//   }
+//
+// Works in place on a buffer holding the whole file and writes straight into
+// caller-provided arrays, so parsing itself does not allocate.  Has no Windows
+// or Direct3D dependencies.
+class MeshTextParser
+{
+public:
+	MeshTextParser(const char* begin, const char* end);
+
+	// Reads the counts and the VertexList layout, leaving the parser at the first vertex.
+	// Fails if the counts need more vertices or triangles than the rest of the buffer
+	// could hold, so they are safe to size arrays with.
+	bool ParseHeader();
+
+	std::uint32_t VertexCount() const { return mVertexCount; }
+	std::uint32_t TriangleCount() const { return mTriangleCount; }
+	bool HasTexC() const { return mHasTexC; }
+
+	// Writes VertexCount() vertices, each vertexByteStride bytes apart, storing
+	// position/normal/texC as packed floats at the given byte offsets.
+	// Models without texture coordinates get (0, 0).
+	bool ParseVertices(void* vertices, std::size_t vertexByteStride,
+		std::size_t posOffset, std::size_t normalOffset, std::size_t texCOffset);
+
+	// Writes 3 * TriangleCount() indices.
+	bool ParseIndices(std::uint32_t* indices);
+
+	// "line N: message" for the first error encountered.
+	const std::string& GetError() const { return mError; }
+
+private:
+	void SkipWhitespace();
+	bool ExpectToken(const char* token);
+	bool ParseFloat(float& value);
+	bool ParseUInt(std::uint32_t& value);
+	bool Fail(const char* message);
+	bool Fail(int line, const char* message);
+
+private:
+	const char* mCurr = nullptr;
+	const char* mEnd = nullptr;
+	int mLine = 1;
+
+	std::uint32_t mVertexCount = 0;
+	std::uint32_t mTriangleCount = 0;
+	bool mHasTexC = false;
+
+	std::string mError;
+};
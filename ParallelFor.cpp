@@ -0,0 +1,210 @@
+#include "ParallelFor.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Conservative per-core L2 budget for one task's working set.
+    const std::size_t TileCacheBytes = 256 * 1024;
+
+    // Aim for at least this many tasks per thread so stealing can even out the load.
+    const int TasksPerThread = 4;
+
+    std::atomic<ParallelExecutor*> gDefaultExecutor{ nullptr };
+
+    ParallelExecutor& GetSharedThreadPool()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+}
+
+void SerialExecutor::For(int begin, int end, int /*grainSize*/, const RangeBody& body)
+{
+    if (begin < end)
+    {
+        body(begin, end);
+    }
+}
+
+ThreadPool::ThreadPool(int workerCount)
+{
+    if (workerCount < 0)
+    {
+        workerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    // Queue 0..workerCount-1 belong to the workers, the last one is shared by callers.
+    for (int i = 0; i <= workerCount; ++i)
+    {
+        mQueues.push_back(std::make_unique<TaskQueue>());
+    }
+
+    for (int i = 0; i < workerCount; ++i)
+    {
+        mWorkers.emplace_back(&ThreadPool::WorkerMain, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mStop = true;
+    }
+    mWakeCondition.notify_all();
+
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::For(int begin, int end, int grainSize, const RangeBody& body)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    grainSize = std::max(1, grainSize);
+    const int taskCount = (end - begin + grainSize - 1) / grainSize;
+
+    // Nothing to share: run inline and skip the queues entirely.
+    if (taskCount == 1 || mWorkers.empty())
+    {
+        body(begin, end);
+        return;
+    }
+
+    Job job;
+    job.Body = &body;
+    job.Remaining.store(taskCount, std::memory_order_relaxed);
+
+    // Deal the chunks out round-robin so every worker starts with local work.
+    const int queueCount = (int)mQueues.size();
+    const unsigned firstQueue = mNextQueue.fetch_add(1, std::memory_order_relaxed);
+    for (int t = 0; t < taskCount; ++t)
+    {
+        Task task;
+        task.Owner = &job;
+        task.Begin = begin + t * grainSize;
+        task.End = std::min(end, task.Begin + grainSize);
+
+        TaskQueue& queue = *mQueues[(firstQueue + t) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        queue.Tasks.push_back(task);
+    }
+
+    {
+        // Publish under the sleep mutex so a worker can't miss the wake-up.
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mPendingTasks.fetch_add(taskCount, std::memory_order_release);
+    }
+    mWakeCondition.notify_all();
+
+    // The caller helps until its own job is done.  It may run other jobs' tasks too,
+    // which is what keeps nested ParallelFor calls from deadlocking.
+    while (job.Remaining.load(std::memory_order_acquire) > 0)
+    {
+        Task task;
+        if (TryGetTask(queueCount - 1, task))
+        {
+            RunTask(task);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::WorkerMain(int index)
+{
+    for (;;)
+    {
+        Task task;
+        if (TryGetTask(index, task))
+        {
+            RunTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mWakeCondition.wait(lock, [this]
+        {
+            return mStop || mPendingTasks.load(std::memory_order_acquire) > 0;
+        });
+
+        if (mStop)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::TryGetTask(int preferred, Task& task)
+{
+    const int queueCount = (int)mQueues.size();
+    for (int i = 0; i < queueCount; ++i)
+    {
+        const int index = (preferred + i) % queueCount;
+        TaskQueue& queue = *mQueues[index];
+
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if (queue.Tasks.empty())
+        {
+            continue;
+        }
+
+        if (i == 0)
+        {
+            task = queue.Tasks.front();
+            queue.Tasks.pop_front();
+        }
+        else
+        {
+            task = queue.Tasks.back();
+            queue.Tasks.pop_back();
+        }
+
+        mPendingTasks.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::RunTask(const Task& task)
+{
+    (*task.Owner->Body)(task.Begin, task.End);
+
+    // The owner may return (and destroy the job) as soon as this reaches zero.
+    task.Owner->Remaining.fetch_sub(1, std::memory_order_release);
+}
+
+ParallelExecutor& GetDefaultExecutor()
+{
+    ParallelExecutor* executor = gDefaultExecutor.load(std::memory_order_acquire);
+    return executor ? *executor : GetSharedThreadPool();
+}
+
+void SetDefaultExecutor(ParallelExecutor* executor)
+{
+    gDefaultExecutor.store(executor, std::memory_order_release);
+}
+
+int RowsPerTile(int rowCount, std::size_t bytesPerRow)
+{
+    if (rowCount <= 0)
+    {
+        return 1;
+    }
+
+    const int cacheRows = (int)std::max<std::size_t>(1, TileCacheBytes / std::max<std::size_t>(1, bytesPerRow));
+
+    const int taskTarget = GetDefaultExecutor().Concurrency() * TasksPerThread;
+    const int balanceRows = std::max(1, (rowCount + taskTarget - 1) / taskTarget);
+
+    return std::min(cacheRows, balanceRows);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Parallel-for over an integer range, independent of any platform task library.
+//
+// Work is handed to a ParallelExecutor in [begin, end) chunks of grainSize items, and the
+// body is called once per chunk.  Two executors are provided: SerialExecutor runs everything
+// on the calling thread, and ThreadPool spreads the chunks over std::thread workers that
+// steal from each other when they run dry.  The calling thread always helps, so nested
+// ParallelFor calls from inside a body cannot deadlock.  Bodies must not throw.
+class ParallelExecutor
+{
+public:
+	typedef std::function<void(int begin, int end)> RangeBody;
+
+	virtual ~ParallelExecutor() = default;
+
+	virtual void For(int begin, int end, int grainSize, const RangeBody& body) = 0;
+
+	// Number of threads that may run chunks at the same time, including the caller.
+	virtual int Concurrency() const = 0;
+};
+
+class SerialExecutor : public ParallelExecutor
+{
+public:
+	void For(int begin, int end, int grainSize, const RangeBody& body) override;
+	int Concurrency() const override { return 1; }
+};
+
+class ThreadPool : public ParallelExecutor
+{
+public:
+	// workerCount < 0 picks hardware_concurrency() - 1, leaving a core for the caller.
+	explicit ThreadPool(int workerCount = -1);
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	void For(int begin, int end, int grainSize, const RangeBody& body) override;
+	int Concurrency() const override { return (int)mWorkers.size() + 1; }
+
+private:
+	struct Job
+	{
+		const RangeBody* Body = nullptr;
+		std::atomic<int> Remaining{ 0 };
+	};
+
+	struct Task
+	{
+		Job* Owner = nullptr;
+		int Begin = 0;
+		int End = 0;
+	};
+
+	// One deque per worker.  The owner pops from the front, thieves take from the back.
+	struct TaskQueue
+	{
+		std::mutex Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	void WorkerMain(int index);
+
+	// Takes a task from queue "preferred" first, then steals from the others.
+	bool TryGetTask(int preferred, Task& task);
+	void RunTask(const Task& task);
+
+	std::vector<std::thread> mWorkers;
+	std::vector<std::unique_ptr<TaskQueue>> mQueues;
+	std::atomic<unsigned> mNextQueue{ 0 };
+
+	// Tasks queued but not yet taken; workers sleep while it is zero.
+	std::atomic<int> mPendingTasks{ 0 };
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeCondition;
+	bool mStop = false;
+};
+
+// Executor used by ParallelFor.  Defaults to a process-wide ThreadPool created on first use.
+ParallelExecutor& GetDefaultExecutor();
+
+// Replaces the default executor, e.g. with a SerialExecutor for debugging or profiling.
+// Passing nullptr restores the shared ThreadPool.  The executor must outlive its use.
+void SetDefaultExecutor(ParallelExecutor* executor);
+
+// Rows per task so that the rows a task touches (bytesPerRow each, summed over every array
+// it reads or writes) stay within a typical per-core L2, while still leaving a few tasks per
+// thread for load balancing.
+int RowsPerTile(int rowCount, std::size_t bytesPerRow);
+
+template<typename RangeBody>
+void ParallelFor(int begin, int end, int grainSize, RangeBody&& body)
+{
+	GetDefaultExecutor().For(begin, end, grainSize, ParallelExecutor::RangeBody(std::forward<RangeBody>(body)));
+}
+
+// Row-tiled variant: body(begin, end) gets a block of rows sized by RowsPerTile.
+template<typename RangeBody>
+void ParallelForRows(int begin, int end, std::size_t bytesPerRow, RangeBody&& body)
+{
+	ParallelFor(begin, end, RowsPerTile(end - begin, bytesPerRow), std::forward<RangeBody>(body));
+}
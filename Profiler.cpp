@@ -0,0 +1,243 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    struct ZoneEvent
+    {
+        const char* Name;
+        std::int64_t Begin;
+        std::int64_t End;
+    };
+
+    // Per-thread event ring.  Only the owning thread writes Write and the slots; only
+    // EndFrame (under gConsumerMutex) writes Read.
+    struct ThreadRing
+    {
+        static const std::uint32_t Capacity = 1 << 14;
+
+        std::uint32_t ThreadIndex = 0;
+        std::atomic<std::uint32_t> Write{ 0 };
+        std::atomic<std::uint32_t> Read{ 0 };
+        ZoneEvent Events[Capacity];
+    };
+
+    struct CapturedEvent
+    {
+        ZoneEvent Event;
+        std::uint32_t ThreadIndex;
+    };
+
+    std::mutex gRingsMutex;
+    std::vector<std::unique_ptr<ThreadRing>> gRings;
+
+    std::atomic<std::uint64_t> gDroppedZones{ 0 };
+
+    // Consumer-side state, only touched by EndFrame and the capture functions.
+    std::mutex gConsumerMutex;
+    std::vector<Profiler::ZoneStats> gCurrentFrame;
+    std::vector<Profiler::ZoneStats> gLastFrame;
+    std::int64_t gFrameBegin = 0;
+
+    int gCaptureFramesLeft = 0;
+    std::string gCaptureFilename;
+    std::int64_t gCaptureBegin = 0;
+    std::vector<CapturedEvent> gCapturedEvents;
+
+    ThreadRing* RegisterThread()
+    {
+        auto Ring = std::make_unique<ThreadRing>();
+
+        std::lock_guard<std::mutex> lock(gRingsMutex);
+        Ring->ThreadIndex = (std::uint32_t)gRings.size();
+        gRings.push_back(std::move(Ring));
+        return gRings.back().get();
+    }
+
+    ThreadRing& GetThreadRing()
+    {
+        // Rings are never freed, so a zone recorded just before a thread exits is still drained.
+        thread_local ThreadRing* Ring = RegisterThread();
+        return *Ring;
+    }
+
+    void AddToFrame(const ZoneEvent& Event)
+    {
+        const double Milliseconds = (double)(Event.End - Event.Begin) * 1e-6;
+        for (Profiler::ZoneStats& Stats : gCurrentFrame)
+        {
+            if (Stats.Name == Event.Name || std::strcmp(Stats.Name, Event.Name) == 0)
+            {
+                Stats.TotalMilliseconds += Milliseconds;
+                ++Stats.Count;
+                return;
+            }
+        }
+
+        Profiler::ZoneStats Stats;
+        Stats.Name = Event.Name;
+        Stats.TotalMilliseconds = Milliseconds;
+        Stats.Count = 1;
+        gCurrentFrame.push_back(Stats);
+    }
+
+    void WriteJsonString(FILE* File, const char* Text)
+    {
+        fputc('"', File);
+        for (const char* c = Text; *c; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                fputc('\\', File);
+            }
+            fputc(*c, File);
+        }
+        fputc('"', File);
+    }
+
+    void WriteChromeTrace()
+    {
+        FILE* File = nullptr;
+#if defined(_MSC_VER)
+        fopen_s(&File, gCaptureFilename.c_str(), "w");
+#else
+        File = fopen(gCaptureFilename.c_str(), "w");
+#endif
+        if (!File)
+        {
+            return;
+        }
+
+        // Complete ("X") events with microsecond timestamps relative to the capture start.
+        fputs("{\"traceEvents\":[\n", File);
+        for (size_t i = 0; i < gCapturedEvents.size(); ++i)
+        {
+            const CapturedEvent& Captured = gCapturedEvents[i];
+            fputs("{\"name\":", File);
+            WriteJsonString(File, Captured.Event.Name);
+            fprintf(File, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                Captured.ThreadIndex,
+                (double)(Captured.Event.Begin - gCaptureBegin) * 1e-3,
+                (double)(Captured.Event.End - Captured.Event.Begin) * 1e-3,
+                (i + 1 < gCapturedEvents.size()) ? "," : "");
+        }
+        fputs("],\"displayTimeUnit\":\"ms\"}\n", File);
+        fclose(File);
+    }
+}
+
+std::int64_t Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::Record(const char* name, std::int64_t beginTicks, std::int64_t endTicks)
+{
+    ThreadRing& Ring = GetThreadRing();
+
+    const std::uint32_t Write = Ring.Write.load(std::memory_order_relaxed);
+    const std::uint32_t Read = Ring.Read.load(std::memory_order_acquire);
+    if (Write - Read >= ThreadRing::Capacity)
+    {
+        gDroppedZones.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ZoneEvent& Event = Ring.Events[Write & (ThreadRing::Capacity - 1)];
+    Event.Name = name;
+    Event.Begin = beginTicks;
+    Event.End = endTicks;
+    Ring.Write.store(Write + 1, std::memory_order_release);
+}
+
+void Profiler::EndFrame()
+{
+    const std::int64_t FrameEnd = Now();
+
+    std::lock_guard<std::mutex> consumerLock(gConsumerMutex);
+    gCurrentFrame.clear();
+
+    const bool Capturing = gCaptureFramesLeft > 0;
+
+    std::vector<ThreadRing*> Rings;
+    {
+        std::lock_guard<std::mutex> lock(gRingsMutex);
+        for (auto& Ring : gRings)
+        {
+            Rings.push_back(Ring.get());
+        }
+    }
+
+    for (ThreadRing* Ring : Rings)
+    {
+        std::uint32_t Read = Ring->Read.load(std::memory_order_relaxed);
+        const std::uint32_t Write = Ring->Write.load(std::memory_order_acquire);
+        for (; Read != Write; ++Read)
+        {
+            const ZoneEvent& Event = Ring->Events[Read & (ThreadRing::Capacity - 1)];
+            AddToFrame(Event);
+
+            if (Capturing && Event.End >= gCaptureBegin)
+            {
+                gCapturedEvents.push_back({ Event, Ring->ThreadIndex });
+            }
+        }
+        Ring->Read.store(Read, std::memory_order_release);
+    }
+
+    if (Capturing)
+    {
+        if (gFrameBegin != 0)
+        {
+            gCapturedEvents.push_back({ { "Frame", std::max(gFrameBegin, gCaptureBegin), FrameEnd }, GetThreadRing().ThreadIndex });
+        }
+
+        if (--gCaptureFramesLeft == 0)
+        {
+            WriteChromeTrace();
+            gCapturedEvents.clear();
+            gCapturedEvents.shrink_to_fit();
+        }
+    }
+
+    gLastFrame.swap(gCurrentFrame);
+    gFrameBegin = FrameEnd;
+}
+
+const std::vector<Profiler::ZoneStats>& Profiler::GetLastFrame()
+{
+    return gLastFrame;
+}
+
+void Profiler::CaptureFrames(int frameCount, const std::string& filename)
+{
+    std::lock_guard<std::mutex> consumerLock(gConsumerMutex);
+    if (gCaptureFramesLeft > 0 || frameCount <= 0)
+    {
+        return;
+    }
+
+    gCaptureFramesLeft = frameCount;
+    gCaptureFilename = filename;
+    gCaptureBegin = gFrameBegin != 0 ? gFrameBegin : Now();
+    gCapturedEvents.clear();
+}
+
+bool Profiler::IsCapturing()
+{
+    std::lock_guard<std::mutex> consumerLock(gConsumerMutex);
+    return gCaptureFramesLeft > 0;
+}
+
+std::uint64_t Profiler::GetDroppedZoneCount()
+{
+    return gDroppedZones.load(std::memory_order_relaxed);
+}
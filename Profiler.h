@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Set to 0 to compile PROFILE_ZONE out entirely.
+#ifndef WE_PROFILER_ENABLED
+#define WE_PROFILER_ENABLED 1
+#endif
+
+// Lightweight CPU zone profiler.
+//
+// PROFILE_ZONE("Name") times the rest of the enclosing scope.  Each thread appends its
+// zones to its own fixed-size ring (single producer, single consumer, no locks on the
+// hot path); Profiler::EndFrame, called once per frame from the main thread, drains all
+// rings into a per-frame summary and, while a capture is running, into a Chrome trace
+// (chrome://tracing, ui.perfetto.dev).  Zone names must be string literals or otherwise
+// outlive the profiler.  If a ring fills up between two EndFrame calls, further zones
+// from that thread are dropped and counted.
+class Profiler
+{
+public:
+	struct ZoneStats
+	{
+		const char* Name = nullptr;
+		double TotalMilliseconds = 0.0;
+		std::uint32_t Count = 0;
+	};
+
+	// Ticks are nanoseconds on a monotonic clock.
+	static std::int64_t Now();
+
+	static void Record(const char* name, std::int64_t beginTicks, std::int64_t endTicks);
+
+	// Closes the current frame.  Aggregates every zone recorded since the previous call.
+	static void EndFrame();
+
+	// Zones of the last finished frame, in the order they first finished.
+	static const std::vector<ZoneStats>& GetLastFrame();
+
+	// Records the next frameCount frames and writes them to filename as Chrome trace JSON.
+	static void CaptureFrames(int frameCount, const std::string& filename);
+	static bool IsCapturing();
+
+	static std::uint64_t GetDroppedZoneCount();
+};
+
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* name)
+		: mName(name), mBegin(Profiler::Now())
+	{
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+	~ProfileZone()
+	{
+		Profiler::Record(mName, mBegin, Profiler::Now());
+	}
+
+private:
+	const char* mName;
+	std::int64_t mBegin;
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+
+#if WE_PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(ProfileZone_, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <d3d12.h>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+#include <vector>
+#include "config.h"
+#include "MathHelper.h"
+#include "Material.h"
+#include "GeometryGenerator.h"
+#include "FrustumCulling.h"
+
+struct RenderItem
+{
+public:
+	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+
+	// Frame resources whose object constants are stale; raised through DirtyList::Mark.
+	int NumFramesDirty = gNumFrameResources;
+	bool InDirtyList = false;
+	
+	UINT ObjectCBIndex = -1;
+
+	Material* Mat = nullptr;
+	MeshGeometry* Geo = nullptr;
+
+	// Local-space bounds of the drawn submesh, for frustum culling.  Items left without
+	// bounds are never culled.
+	DirectX::BoundingSphere Bounds = AlwaysVisibleBounds;
+
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	UINT BaseVertexLocation = 0;
+};
+
+struct RenderInstance
+{
+	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+	Material* Mat = nullptr;
+};
+
+// One mesh drawn many times with a single DrawIndexedInstanced.  Each instance has its own
+// transforms and material; Mat only supplies the texture.  Instances are culled one by one
+// and the visible ones are written to the frame's InstanceBuffer, so the cost per copy is
+// one InstanceData rather than an ObjectConstants slot and a draw.
+struct InstancedRenderItem
+{
+public:
+	std::vector<RenderInstance> Instances;
+
+	Material* Mat = nullptr;
+	MeshGeometry* Geo = nullptr;
+
+	// Local-space bounds of the drawn submesh, shared by every instance.
+	DirectX::BoundingSphere Bounds = AlwaysVisibleBounds;
+
+	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+
+	UINT IndexCount = 0;
+	UINT StartIndexLocation = 0;
+	UINT BaseVertexLocation = 0;
+
+	// Instances occupy slots [CullBase, CullBase + Instances.size()) of the instance cull
+	// set.  Set BoundsDirty after moving instances so their world spheres are refreshed.
+	UINT CullBase = 0;
+	bool BoundsDirty = true;
+
+	// This frame's visible instances: [FirstVisible, FirstVisible + VisibleCount) of the
+	// current frame resource's InstanceBuffer.
+	UINT FirstVisible = 0;
+	UINT VisibleCount = 0;
+};
+
+enum class RenderLayer : int
+{
+	Opaque = 0,
+	Mirrors,
+	Reflected,
+	Transparent,
+	Shadow,
+	Count,
+};
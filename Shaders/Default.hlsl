@@ -65,6 +65,33 @@ cbuffer cbMaterial : register(b2)
 	float gRoughness;
 	float4x4 gMatTransform;
 };
+
+// Instanced render items: one element per visible instance, bound at the item's first
+// instance so SV_InstanceID indexes it directly.  The 144-byte stride must match the C++
+// InstanceData in FrameResource.h, which static_asserts it.
+struct InstanceData
+{
+	float4x4 World;
+	float4x4 TexTransform;
+	uint MaterialIndex;
+	uint InstPad0;
+	uint InstPad1;
+	uint InstPad2;
+};
+
+// The frame's material constant buffer read as a structured buffer.  Constant buffer
+// elements are 256 bytes apart, so the struct is padded to match.
+struct MaterialData
+{
+	float4 DiffuseAlbedo;
+	float3 FresnelR0;
+	float Roughness;
+	float4x4 MatTransform;
+	float4 MatPad[10];
+};
+
+StructuredBuffer<InstanceData> gInstanceData : register(t0, space1);
+StructuredBuffer<MaterialData> gMaterialData : register(t1, space1);
  
 struct VertexIn
 {
@@ -79,32 +106,50 @@ struct VertexOut
 	float3 PosW		: POSITION;
 	float3 NormalW	: NORMAL;
 	float2 TexC		: TEXCOORD;
+
+	// Only used by the instanced path.
+	nointerpolation uint MatIndex : MATINDEX;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut TransformVertex(VertexIn vin, float4x4 world, float4x4 texTransform, float4x4 matTransform)
 {
 	VertexOut vout = (VertexOut) 0.0f;
 	
     // Transform to world space.
-	float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+	float4 posW = mul(float4(vin.PosL, 1.0f), world);
 	vout.PosW = posW.xyz;
 
     //  Ŀ յ ʰ ٰ ϰ,  ȯѴ.
 	// յ ʰ ٸ ġ  .
-	vout.NormalW = mul(vin.NormalL, (float3x3) gWorld);
+	vout.NormalW = mul(vin.NormalL, (float3x3) world);
 
     // Transform to homogeneous clip space.
 	vout.PosH = mul(posW, gViewProj);
 	
-	float4 texC = mul(float4(vin.TexC, 0.f, 1.f), gTexTransform);
-	vout.TexC = mul(texC, gMatTransform).xy;
+	float4 texC = mul(float4(vin.TexC, 0.f, 1.f), texTransform);
+	vout.TexC = mul(texC, matTransform).xy;
 
 	return vout;
 }
 
-float4 PS(VertexOut pin) : SV_Target
+VertexOut VS(VertexIn vin)
+{
+	return TransformVertex(vin, gWorld, gTexTransform, gMatTransform);
+}
+
+VertexOut InstancedVS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
-	float4 diffuseAlbedo = gDiffuseMap.Sample(gSamLinearWrap, pin.TexC) * gDiffuseAlbedo;
+	InstanceData inst = gInstanceData[instanceID];
+	MaterialData mat = gMaterialData[inst.MaterialIndex];
+
+	VertexOut vout = TransformVertex(vin, inst.World, inst.TexTransform, mat.MatTransform);
+	vout.MatIndex = inst.MaterialIndex;
+	return vout;
+}
+
+float4 Shade(VertexOut pin, float4 matDiffuseAlbedo, float3 fresnelR0, float roughness)
+{
+	float4 diffuseAlbedo = gDiffuseMap.Sample(gSamLinearWrap, pin.TexC) * matDiffuseAlbedo;
 
 #ifdef ALPHA_TEST
 	// ؽó İ 0.1  ȼ .
@@ -123,8 +168,8 @@ float4 PS(VertexOut pin) : SV_Target
 	// Indirect lighting.
 	float4 ambient = gAmbientLight * diffuseAlbedo;
 
-	const float shininess = 1.0f - gRoughness;
-	Material mat = { diffuseAlbedo, gFresnelR0, shininess };
+	const float shininess = 1.0f - roughness;
+	Material mat = { diffuseAlbedo, fresnelR0, shininess };
 	float3 shadowFactor = 1.0f;
 	float4 directLight = ComputeLighting(gLights, mat, pin.PosW,
         pin.NormalW, toEyeW, shadowFactor);
@@ -140,4 +185,15 @@ float4 PS(VertexOut pin) : SV_Target
 	litColor.a = diffuseAlbedo.a;
 
 	return litColor;
+}
+
+float4 PS(VertexOut pin) : SV_Target
+{
+	return Shade(pin, gDiffuseAlbedo, gFresnelR0, gRoughness);
+}
+
+float4 InstancedPS(VertexOut pin) : SV_Target
+{
+	MaterialData mat = gMaterialData[pin.MatIndex];
+	return Shade(pin, mat.DiffuseAlbedo, mat.FresnelR0, mat.Roughness);
 }
\ No newline at end of file
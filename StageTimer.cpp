@@ -0,0 +1,40 @@
+#include "StageTimer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+double Percentile(const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    const size_t index = (size_t)(fraction * (double)(sorted.size() - 1) + 0.5);
+    return sorted[(std::min)(index, sorted.size() - 1)];
+}
+
+void PrintStageHeader(PrintLineFunction printLine)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "%-20s %10s %10s %10s\n", "Stage (ms)", "mean", "p50", "p99");
+    printLine(line);
+}
+
+void PrintStage(const StageSamples& stage, PrintLineFunction printLine)
+{
+    std::vector<double> sorted = stage.Milliseconds;
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (double value : sorted)
+    {
+        sum += value;
+    }
+    const double mean = sorted.empty() ? 0.0 : sum / (double)sorted.size();
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-20s %10.4f %10.4f %10.4f\n",
+        stage.Name, mean, Percentile(sorted, 0.5), Percentile(sorted, 0.99));
+    printLine(line);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// Per-stage timings of the headless benchmarks ("WE.exe -benchmark" and
+// WEHeadlessBenchmark), printed as mean/p50/p99 milliseconds.
+
+struct StageSamples
+{
+	const char* Name = nullptr;
+	std::vector<double> Milliseconds;
+};
+
+// Where PrintStage and PrintStageHeader send each finished line.
+using PrintLineFunction = void (*)(const char* line);
+
+// Value at fraction (0..1) of sorted, rounded to the nearest sample; 0 when empty.
+double Percentile(const std::vector<double>& sorted, double fraction);
+
+void PrintStageHeader(PrintLineFunction printLine);
+void PrintStage(const StageSamples& stage, PrintLineFunction printLine);
+
+// Times body and appends the result in milliseconds to stage when record is set.
+template<typename F>
+void TimeStage(StageSamples& stage, bool record, F&& body)
+{
+	const auto start = std::chrono::steady_clock::now();
+	body();
+	const auto end = std::chrono::steady_clock::now();
+
+	if (record)
+	{
+		stage.Milliseconds.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <emmintrin.h>
+
+// memcpy for destinations the CPU only writes and never reads back, such as mapped
+// upload heaps (write-combined memory) or large staging buffers.  The 16-byte aligned
+// middle is written with non-temporal stores, which fill whole write-combine lines in
+// order and don't evict useful data from the cache.  The fence makes the stores visible
+// before the caller hands the memory to another thread or the GPU.
+inline void StreamCopy(void* dst, const void* src, std::size_t byteSize)
+{
+	unsigned char* d = static_cast<unsigned char*>(dst);
+	const unsigned char* s = static_cast<const unsigned char*>(src);
+
+	const std::size_t head = (16 - ((std::uintptr_t)d & 15)) & 15;
+	if (byteSize < head + 64)
+	{
+		std::memcpy(d, s, byteSize);
+		return;
+	}
+
+	std::memcpy(d, s, head);
+	d += head;
+	s += head;
+	byteSize -= head;
+
+	for (; byteSize >= 64; byteSize -= 64, d += 64, s += 64)
+	{
+		const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+		const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 16));
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 32));
+		const __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 48));
+		_mm_stream_si128(reinterpret_cast<__m128i*>(d), a);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(d + 16), b);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(d + 32), c);
+		_mm_stream_si128(reinterpret_cast<__m128i*>(d + 48), e);
+	}
+
+	std::memcpy(d, s, byteSize);
+	_mm_sfence();
+}
@@ -0,0 +1,88 @@
+#include "CommandLineOptions.h"
+#include "HeadlessBenchmarkDesc.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+TEST(CommandLineOptions, SplitsFlagsAndOptions)
+{
+    const CommandLineOptions options({ "-benchmark", "frames=500", "trace=out.json", "empty=" });
+
+    EXPECT_TRUE(options.HasFlag("-benchmark"));
+    EXPECT_FALSE(options.HasFlag("frames"));
+    EXPECT_TRUE(options.HasOption("frames"));
+    EXPECT_FALSE(options.HasOption("-benchmark"));
+
+    int frames = 0;
+    options.Read("frames", 1, frames);
+    EXPECT_EQ(frames, 500);
+
+    std::string trace;
+    options.Read("trace", trace);
+    EXPECT_EQ(trace, "out.json");
+
+    std::string empty = "unchanged";
+    options.Read("empty", empty);
+    EXPECT_EQ(empty, "");
+}
+
+TEST(CommandLineOptions, AbsentKeysLeaveValuesUnchanged)
+{
+    const CommandLineOptions options({ "-benchmark" });
+
+    int frames = 42;
+    options.Read("frames", 1, frames);
+    EXPECT_EQ(frames, 42);
+
+    std::string trace = "default.json";
+    options.Read("trace", trace);
+    EXPECT_EQ(trace, "default.json");
+}
+
+TEST(CommandLineOptions, RejectsMalformedIntegers)
+{
+    // What atoi used to turn into 0, 12 or a wrapped value.
+    for (const char* arg : { "frames=", "frames=x", "frames=12x", "frames=1.5", "frames=99999999999", "frames=0", "frames=-3" })
+    {
+        const CommandLineOptions options({ arg });
+        int frames = 7;
+        EXPECT_THROW(options.Read("frames", 1, frames), std::invalid_argument) << arg;
+        EXPECT_EQ(frames, 7) << arg;
+    }
+}
+
+TEST(CommandLineOptions, RejectsNamelessAndUnknownOptions)
+{
+    EXPECT_THROW(CommandLineOptions({ "=5" }), std::invalid_argument);
+
+    // "frame=" must not be mistaken for "frames=", nor "items=" found inside "maxitems=".
+    const CommandLineOptions options({ "frame=3", "maxitems=10" });
+    EXPECT_THROW(options.CheckKeys({ "frames", "items" }), std::invalid_argument);
+    EXPECT_NO_THROW(options.CheckKeys({ "frame", "maxitems" }));
+}
+
+TEST(HeadlessBenchmarkDesc, ReadsOptions)
+{
+    HeadlessBenchmarkDesc desc;
+    desc.ReadOptions(CommandLineOptions({ "-benchmark", "frames=20", "items=0", "instances=300", "materials=4",
+        "waves=64", "frameresources=2", "trace=t.json" }));
+
+    EXPECT_EQ(desc.FrameCount, 20);
+    EXPECT_EQ(desc.RenderItemCount, 0);
+    EXPECT_EQ(desc.InstanceCount, 300);
+    EXPECT_EQ(desc.MaterialCount, 4);
+    EXPECT_EQ(desc.WaveRowCount, 64);
+    EXPECT_EQ(desc.WaveColumnCount, 64);
+    EXPECT_EQ(desc.FrameResourceCount, 2);
+    EXPECT_EQ(desc.TraceFilename, "t.json");
+}
+
+TEST(HeadlessBenchmarkDesc, RejectsBadOptions)
+{
+    HeadlessBenchmarkDesc desc;
+    EXPECT_THROW(desc.ReadOptions(CommandLineOptions({ "latency=2" })), std::invalid_argument);
+    EXPECT_THROW(desc.ReadOptions(CommandLineOptions({ "waves=8" })), std::invalid_argument);
+    EXPECT_THROW(desc.ReadOptions(CommandLineOptions({ "materials=0" })), std::invalid_argument);
+    EXPECT_THROW(desc.ReadOptions(CommandLineOptions({ "frameresources=0" })), std::invalid_argument);
+}
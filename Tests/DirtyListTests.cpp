@@ -0,0 +1,145 @@
+#include "DirtyList.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <vector>
+
+// Defined by FrameResource.cpp in the game, which the portable build leaves out.
+int gNumFrameResources = NUM_FRAME_RESOURCES;
+
+namespace
+{
+    struct TestObject
+    {
+        int Id = 0;
+        int NumFramesDirty = 0;
+        bool InDirtyList = false;
+    };
+
+    // Runs one frame and returns how often each object was updated.
+    std::map<int, int> RunFrame(DirtyList<TestObject>& list)
+    {
+        std::map<int, int> updates;
+        list.ForEachDirty([&](TestObject* object) { ++updates[object->Id]; });
+        return updates;
+    }
+
+    class DirtyListTest : public ::testing::Test
+    {
+    protected:
+        void TearDown() override { gNumFrameResources = NUM_FRAME_RESOURCES; }
+    };
+}
+
+TEST_F(DirtyListTest, UpdatesEachObjectOncePerFrameResource)
+{
+    gNumFrameResources = 3;
+    std::vector<TestObject> objects(10);
+    for (int i = 0; i < 10; ++i)
+    {
+        objects[i].Id = i;
+    }
+
+    DirtyList<TestObject> list;
+    list.Mark(&objects[2]);
+    list.Mark(&objects[7]);
+    EXPECT_EQ(list.Size(), 2u);
+
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        EXPECT_EQ(RunFrame(list), (std::map<int, int>{ { 2, 1 }, { 7, 1 } })) << "frame " << frame;
+    }
+
+    EXPECT_EQ(list.Size(), 0u);
+    EXPECT_FALSE(objects[2].InDirtyList);
+    EXPECT_EQ(objects[2].NumFramesDirty, 0);
+    EXPECT_TRUE(RunFrame(list).empty());
+}
+
+TEST_F(DirtyListTest, MarkingTwiceQueuesOnceAndRestartsTheCount)
+{
+    gNumFrameResources = 3;
+    TestObject object;
+    DirtyList<TestObject> list;
+
+    list.Mark(&object);
+    list.Mark(&object);
+    EXPECT_EQ(list.Size(), 1u);
+    EXPECT_EQ(RunFrame(list)[0], 1);
+
+    // Changed again after one frame: every frame resource needs the new value.
+    list.Mark(&object);
+    EXPECT_EQ(list.Size(), 1u);
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        EXPECT_EQ(RunFrame(list)[0], 1);
+    }
+    EXPECT_EQ(list.Size(), 0u);
+}
+
+TEST_F(DirtyListTest, FollowsTheRingDepthAtMarkTime)
+{
+    gNumFrameResources = 2;
+    TestObject shallow;
+    shallow.Id = 1;
+    DirtyList<TestObject> list;
+    list.Mark(&shallow);
+
+    gNumFrameResources = 4;
+    TestObject deep;
+    deep.Id = 2;
+    list.Mark(&deep);
+
+    int frames = 0;
+    int shallowUpdates = 0;
+    int deepUpdates = 0;
+    while (list.Size() != 0)
+    {
+        const std::map<int, int> updates = RunFrame(list);
+        shallowUpdates += updates.count(1) ? updates.at(1) : 0;
+        deepUpdates += updates.count(2) ? updates.at(2) : 0;
+        ++frames;
+    }
+    EXPECT_EQ(frames, 4);
+    EXPECT_EQ(shallowUpdates, 2);
+    EXPECT_EQ(deepUpdates, 4);
+}
+
+TEST_F(DirtyListTest, MatchesAFullScan)
+{
+    // Random marks over many frames give the same updates as the old walk over every
+    // object checking NumFramesDirty.
+    gNumFrameResources = 3;
+    const int objectCount = 50;
+    std::vector<TestObject> listed(objectCount);
+    std::vector<int> scanned(objectCount, 0);
+    for (int i = 0; i < objectCount; ++i)
+    {
+        listed[i].Id = i;
+    }
+
+    DirtyList<TestObject> list;
+    unsigned seed = 12345;
+    for (int frame = 0; frame < 200; ++frame)
+    {
+        for (int k = 0; k < 5; ++k)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            const int i = (int)((seed >> 8) % objectCount);
+            list.Mark(&listed[i]);
+            scanned[i] = gNumFrameResources;
+        }
+
+        std::map<int, int> expected;
+        for (int i = 0; i < objectCount; ++i)
+        {
+            if (scanned[i] > 0)
+            {
+                ++expected[i];
+                --scanned[i];
+            }
+        }
+        ASSERT_EQ(RunFrame(list), expected) << "frame " << frame;
+    }
+}
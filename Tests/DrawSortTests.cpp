@@ -0,0 +1,158 @@
+#include "DrawSort.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<DrawSortEntry> StableSorted(std::vector<DrawSortEntry> entries)
+    {
+        std::stable_sort(entries.begin(), entries.end(),
+            [](const DrawSortEntry& a, const DrawSortEntry& b) { return a.Key < b.Key; });
+        return entries;
+    }
+
+    // Keys firstKey | (random & mask), so only the bits of mask vary.
+    std::vector<DrawSortEntry> MakeEntries(size_t count, std::uint64_t firstKey, std::uint64_t mask, unsigned seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::vector<DrawSortEntry> entries(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            entries[i].Key = (firstKey & ~mask) | (rng() & mask);
+            entries[i].Index = (std::uint32_t)i;
+        }
+        return entries;
+    }
+
+    void ExpectSortsLikeStableSort(std::vector<DrawSortEntry> entries)
+    {
+        const std::vector<DrawSortEntry> expected = StableSorted(entries);
+        std::vector<DrawSortEntry> scratch;
+        RadixSortDrawKeys(entries, scratch);
+
+        ASSERT_EQ(entries.size(), expected.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            ASSERT_EQ(entries[i].Key, expected[i].Key) << "entry " << i;
+            ASSERT_EQ(entries[i].Index, expected[i].Index) << "entry " << i;
+        }
+    }
+}
+
+TEST(DrawSort, TrivialLists)
+{
+    ExpectSortsLikeStableSort({});
+    ExpectSortsLikeStableSort({ { 5, 0 } });
+    ExpectSortsLikeStableSort({ { 5, 0 }, { 3, 1 } });
+    ExpectSortsLikeStableSort({ { 7, 0 }, { 7, 1 }, { 7, 2 } });
+}
+
+TEST(DrawSort, MatchesStableSort)
+{
+    // Live bit spans on both sides of the 11- and 16-bit digit widths, at offsets that are
+    // not digit aligned, including the top bit and all 64.
+    const std::uint64_t masks[] =
+    {
+        0x1ull,
+        0x7FFull << 3,
+        0xFFFull << 20,
+        0xFFFFull << 40,
+        0x1FFFFull << 7,
+        0xFFFFFFFFFFull << 14,
+        0x8000000000000001ull,
+        ~0ull,
+    };
+
+    // Small lists always use 11-bit digits; large ones may take a single 16-bit digit.
+    for (size_t count : { (size_t)100, (size_t)40000 })
+    {
+        for (std::uint64_t mask : masks)
+        {
+            SCOPED_TRACE(::testing::Message() << "count " << count << " mask " << std::hex << mask);
+            ExpectSortsLikeStableSort(MakeEntries(count, 0x0123456789ABCDEFull, mask, (unsigned)(mask ^ count)));
+        }
+    }
+}
+
+TEST(DrawSort, KeepsEqualKeysInOrder)
+{
+    // Few distinct keys and many duplicates: the index order inside each key must survive.
+    std::vector<DrawSortEntry> entries = MakeEntries(5000, 0, 0x3ull << 30, 3);
+    ExpectSortsLikeStableSort(entries);
+}
+
+TEST(DrawSort, ReusesScratch)
+{
+    std::vector<DrawSortEntry> scratch;
+    for (unsigned frame = 0; frame < 4; ++frame)
+    {
+        std::vector<DrawSortEntry> entries = MakeEntries(1000 + frame * 700, 0, 0xFFFFFull << frame * 9, frame);
+        const std::vector<DrawSortEntry> expected = StableSorted(entries);
+        RadixSortDrawKeys(entries, scratch);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            ASSERT_EQ(entries[i].Index, expected[i].Index) << "frame " << frame << " entry " << i;
+        }
+    }
+}
+
+TEST(DrawSort, OpaqueKeysGroupByStateThenDepth)
+{
+    DrawKeyFields near;
+    near.Layer = 0;
+    near.Texture = 2;
+    near.Material = 1;
+    near.Depth = DrawKey::QuantizeDepth(2.0f, 1.0f, 1000.0f);
+
+    DrawKeyFields far = near;
+    far.Depth = DrawKey::QuantizeDepth(900.0f, 1.0f, 1000.0f);
+
+    DrawKeyFields otherTexture = near;
+    otherTexture.Texture = 3;
+
+    DrawKeyFields nextLayer = near;
+    nextLayer.Layer = 1;
+    nextLayer.Texture = 0;
+
+    EXPECT_LT(DrawKey::MakeOpaque(near), DrawKey::MakeOpaque(far));
+    EXPECT_LT(DrawKey::MakeOpaque(far), DrawKey::MakeOpaque(otherTexture));
+    EXPECT_LT(DrawKey::MakeOpaque(otherTexture), DrawKey::MakeOpaque(nextLayer));
+
+    // Opaque keys keep a coarse depth: draws closer together than one step share a key.
+    DrawKeyFields almostNear = near;
+    almostNear.Depth = near.Depth + 1;
+    EXPECT_EQ(DrawKey::MakeOpaque(near), DrawKey::MakeOpaque(almostNear));
+}
+
+TEST(DrawSort, TransparentKeysSortBackToFront)
+{
+    DrawKeyFields far;
+    far.Layer = 2;
+    far.Texture = 9;
+    far.Depth = DrawKey::QuantizeDepth(900.0f, 1.0f, 1000.0f);
+
+    DrawKeyFields near = far;
+    near.Texture = 0;
+    near.Depth = DrawKey::QuantizeDepth(2.0f, 1.0f, 1000.0f);
+
+    DrawKeyFields nearer = near;
+    nearer.Depth = near.Depth - 1;
+
+    EXPECT_LT(DrawKey::MakeTransparent(far), DrawKey::MakeTransparent(near));
+    EXPECT_LT(DrawKey::MakeTransparent(near), DrawKey::MakeTransparent(nearer));
+}
+
+TEST(DrawSort, QuantizeDepthClamps)
+{
+    const std::uint32_t maxDepth = (1u << DrawKey::DepthBits) - 1;
+    EXPECT_EQ(DrawKey::QuantizeDepth(0.5f, 1.0f, 100.0f), 0u);
+    EXPECT_EQ(DrawKey::QuantizeDepth(1.0f, 1.0f, 100.0f), 0u);
+    EXPECT_EQ(DrawKey::QuantizeDepth(100.0f, 1.0f, 100.0f), maxDepth);
+    EXPECT_EQ(DrawKey::QuantizeDepth(1e30f, 1.0f, 100.0f), maxDepth);
+    EXPECT_LT(DrawKey::QuantizeDepth(40.0f, 1.0f, 100.0f), DrawKey::QuantizeDepth(41.0f, 1.0f, 100.0f));
+    EXPECT_EQ(DrawKey::QuantizeDepth(5.0f, 10.0f, 10.0f), 0u);
+}
@@ -0,0 +1,345 @@
+#include "DrawStateCache.h"
+#include "ParallelFor.h"
+#include "config.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // What a command list has bound when it draws.
+    struct BoundState
+    {
+        D3D12_VERTEX_BUFFER_VIEW VertexBuffer = {};
+        D3D12_INDEX_BUFFER_VIEW IndexBuffer = {};
+        D3D12_PRIMITIVE_TOPOLOGY Topology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+        UINT64 Root[16] = {};
+
+        bool operator==(const BoundState& Other) const
+        {
+            return std::memcmp(&VertexBuffer, &Other.VertexBuffer, sizeof(VertexBuffer)) == 0 &&
+                std::memcmp(&IndexBuffer, &Other.IndexBuffer, sizeof(IndexBuffer)) == 0 &&
+                Topology == Other.Topology &&
+                std::memcmp(Root, Other.Root, sizeof(Root)) == 0;
+        }
+    };
+
+    struct RecordedDraw
+    {
+        BoundState State;
+        UINT IndexCount;
+        UINT StartIndexLocation;
+        INT BaseVertexLocation;
+    };
+
+    // Stands in for ID3D12GraphicsCommandList: tracks the bound state and records every
+    // draw with the state it would have used.
+    class MockCommandList
+    {
+    public:
+        BoundState State;
+        std::vector<RecordedDraw> Draws;
+        UINT CallCount = 0;
+
+        void IASetVertexBuffers(UINT StartSlot, UINT NumViews, const D3D12_VERTEX_BUFFER_VIEW* Views)
+        {
+            ASSERT_EQ(StartSlot, 0u);
+            ASSERT_EQ(NumViews, 1u);
+            State.VertexBuffer = *Views;
+            ++CallCount;
+        }
+
+        void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* View)
+        {
+            State.IndexBuffer = *View;
+            ++CallCount;
+        }
+
+        void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY Topology)
+        {
+            State.Topology = Topology;
+            ++CallCount;
+        }
+
+        void SetGraphicsRootDescriptorTable(UINT RootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE Handle)
+        {
+            State.Root[RootParameterIndex] = Handle.ptr;
+            ++CallCount;
+        }
+
+        void SetGraphicsRootConstantBufferView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS Address)
+        {
+            State.Root[RootParameterIndex] = Address;
+            ++CallCount;
+        }
+
+        void SetGraphicsRootShaderResourceView(UINT RootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS Address)
+        {
+            State.Root[RootParameterIndex] = Address;
+            ++CallCount;
+        }
+
+        void DrawIndexedInstanced(UINT IndexCountPerInstance, UINT InstanceCount, UINT StartIndexLocation, INT BaseVertexLocation, UINT StartInstanceLocation)
+        {
+            EXPECT_EQ(InstanceCount, 1u);
+            EXPECT_EQ(StartInstanceLocation, 0u);
+            Draws.push_back({ State, IndexCountPerInstance, StartIndexLocation, BaseVertexLocation });
+        }
+    };
+
+    // The per-item part of D3D12::DrawRenderItems.
+    struct TestItem
+    {
+        int Geometry;
+        int Material;
+        int Object;
+        D3D12_PRIMITIVE_TOPOLOGY Topology;
+    };
+
+    template<typename Recorder>
+    void RecordItem(Recorder& Target, const TestItem& Item)
+    {
+        const D3D12_VERTEX_BUFFER_VIEW VertexBuffer = { 0x10000 + (UINT64)Item.Geometry * 0x1000, 0x1000, 32 };
+        const D3D12_INDEX_BUFFER_VIEW IndexBuffer = { 0x80000 + (UINT64)Item.Geometry * 0x1000, 0x1000, DXGI_FORMAT_R16_UINT };
+
+        Target.SetVertexBuffer(VertexBuffer);
+        Target.SetIndexBuffer(IndexBuffer);
+        Target.SetPrimitiveTopology(Item.Topology);
+        Target.SetGraphicsRootDescriptorTable(0, { 0x400 + (UINT64)Item.Material * 32 });
+        Target.SetGraphicsRootConstantBufferView(1, 0x100000 + (UINT64)Item.Object * 256);
+        Target.SetGraphicsRootConstantBufferView(3, 0x200000 + (UINT64)Item.Material * 256);
+        Target.DrawIndexedInstanced(3 * (Item.Geometry + 1), 1, 6 * Item.Object, Item.Geometry, 0);
+    }
+
+    // Forwards every bind, like DrawRenderItems did before the cache.
+    struct UncachedRecorder
+    {
+        MockCommandList* CmdList;
+
+        void SetVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& View) { CmdList->IASetVertexBuffers(0, 1, &View); }
+        void SetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& View) { CmdList->IASetIndexBuffer(&View); }
+        void SetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY Topology) { CmdList->IASetPrimitiveTopology(Topology); }
+        void SetGraphicsRootDescriptorTable(UINT Index, D3D12_GPU_DESCRIPTOR_HANDLE Handle) { CmdList->SetGraphicsRootDescriptorTable(Index, Handle); }
+        void SetGraphicsRootConstantBufferView(UINT Index, D3D12_GPU_VIRTUAL_ADDRESS Address) { CmdList->SetGraphicsRootConstantBufferView(Index, Address); }
+        void DrawIndexedInstanced(UINT IndexCount, UINT InstanceCount, UINT StartIndex, INT BaseVertex, UINT StartInstance)
+        {
+            CmdList->DrawIndexedInstanced(IndexCount, InstanceCount, StartIndex, BaseVertex, StartInstance);
+        }
+    };
+
+    void ExpectSameDraws(const MockCommandList& Actual, const MockCommandList& Expected)
+    {
+        ASSERT_EQ(Actual.Draws.size(), Expected.Draws.size());
+        for (size_t i = 0; i < Actual.Draws.size(); ++i)
+        {
+            ASSERT_TRUE(Actual.Draws[i].State == Expected.Draws[i].State) << "draw " << i;
+            ASSERT_EQ(Actual.Draws[i].IndexCount, Expected.Draws[i].IndexCount) << "draw " << i;
+            ASSERT_EQ(Actual.Draws[i].StartIndexLocation, Expected.Draws[i].StartIndexLocation) << "draw " << i;
+            ASSERT_EQ(Actual.Draws[i].BaseVertexLocation, Expected.Draws[i].BaseVertexLocation) << "draw " << i;
+        }
+    }
+}
+
+TEST(DrawStateCache, DropsOnlyRepeatedBinds)
+{
+    MockCommandList CmdList;
+    DrawStateCache<MockCommandList> State(&CmdList);
+
+    const D3D12_VERTEX_BUFFER_VIEW VertexBuffer = { 0x1000, 256, 32 };
+    State.SetVertexBuffer(VertexBuffer);
+    State.SetVertexBuffer(VertexBuffer);
+
+    // Same location but a different size is a different view.
+    const D3D12_VERTEX_BUFFER_VIEW Larger = { 0x1000, 512, 32 };
+    State.SetVertexBuffer(Larger);
+
+    State.SetGraphicsRootConstantBufferView(1, 0x2000);
+    State.SetGraphicsRootConstantBufferView(1, 0x2000);
+    State.SetGraphicsRootConstantBufferView(3, 0x2000);
+    State.SetGraphicsRootShaderResourceView(5, 0x3000);
+    State.SetGraphicsRootShaderResourceView(5, 0x3000);
+
+    State.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    State.SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    State.DrawIndexedInstanced(3, 1, 0, 0, 0);
+
+    EXPECT_EQ(CmdList.CallCount, 6u);
+    EXPECT_EQ(State.Stats().Emitted, 6u);
+    EXPECT_EQ(State.Stats().Elided, 4u);
+    EXPECT_EQ(State.Stats().Draws, 1u);
+    EXPECT_EQ(CmdList.Draws[0].State.VertexBuffer.SizeInBytes, 512u);
+}
+
+TEST(DrawStateCache, InvalidateRebindsEverything)
+{
+    MockCommandList CmdList;
+    DrawStateCache<MockCommandList> State(&CmdList);
+    const TestItem Item = { 1, 2, 3, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST };
+
+    RecordItem(State, Item);
+    EXPECT_EQ(CmdList.CallCount, 6u);
+    RecordItem(State, Item);
+    EXPECT_EQ(CmdList.CallCount, 6u);
+
+    // Something else bound behind the cache's back.
+    State.Invalidate();
+    RecordItem(State, Item);
+    EXPECT_EQ(CmdList.CallCount, 12u);
+}
+
+TEST(DrawStateCache, RootSlotsPastTheCacheAreAlwaysEmitted)
+{
+    MockCommandList CmdList;
+    DrawStateCache<MockCommandList> State(&CmdList);
+    const UINT Slot = DrawStateCache<MockCommandList>::MaxRootParameters;
+
+    State.SetGraphicsRootConstantBufferView(Slot, 0x100);
+    State.SetGraphicsRootConstantBufferView(Slot, 0x100);
+    EXPECT_EQ(CmdList.CallCount, 2u);
+    EXPECT_EQ(State.Stats().Elided, 0u);
+}
+
+TEST(DrawStateCache, DrawsWithTheSameStateAsUncachedRecording)
+{
+    std::mt19937 Rng(1);
+    for (int Trial = 0; Trial < 200; ++Trial)
+    {
+        std::vector<TestItem> Items(1 + Rng() % 200);
+        for (TestItem& Item : Items)
+        {
+            Item.Geometry = (int)(Rng() % 3);
+            Item.Material = (int)(Rng() % 4);
+            Item.Object = (int)(Rng() % 5);
+            Item.Topology = Rng() % 5 ? D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST : D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+        }
+
+        MockCommandList Uncached;
+        UncachedRecorder Reference = { &Uncached };
+        MockCommandList Cached;
+        DrawStateCache<MockCommandList> State(&Cached);
+        for (const TestItem& Item : Items)
+        {
+            RecordItem(Reference, Item);
+            RecordItem(State, Item);
+        }
+
+        SCOPED_TRACE(::testing::Message() << "trial " << Trial);
+        ExpectSameDraws(Cached, Uncached);
+
+        const DrawStateStats& Stats = State.Stats();
+        EXPECT_EQ(Stats.Draws, (UINT)Items.size());
+        EXPECT_EQ(Stats.Emitted + Stats.Elided, 6 * (UINT)Items.size());
+        EXPECT_EQ(Stats.Emitted, Cached.CallCount);
+    }
+}
+
+TEST(DrawStateCache, SortedListsBindMostStateOnce)
+{
+    // 1000 items sorted by geometry (2) then material (4): only the per-object constant
+    // buffer changes on every draw.
+    MockCommandList CmdList;
+    DrawStateCache<MockCommandList> State(&CmdList);
+    int Object = 0;
+    for (int Geometry = 0; Geometry < 2; ++Geometry)
+    {
+        for (int Material = 0; Material < 4; ++Material)
+        {
+            for (int i = 0; i < 125; ++i)
+            {
+                RecordItem(State, { Geometry, Material, Object++, D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST });
+            }
+        }
+    }
+
+    // 2 vertex + 2 index buffers, 1 topology, 8 textures, 1000 object CBs, 8 material CBs.
+    EXPECT_EQ(State.Stats().Emitted, 1021u);
+    EXPECT_EQ(State.Stats().Elided, 6000u - 1021u);
+    EXPECT_EQ(State.Stats().Draws, 1000u);
+}
+
+TEST(DrawStateCache, ChunkCountFollowsWorkersAndMinimumSize)
+{
+    EXPECT_EQ(DrawChunkCount(0, 8, 256), 1);
+    EXPECT_EQ(DrawChunkCount(100, 8, 256), 1);
+    EXPECT_EQ(DrawChunkCount(511, 8, 256), 1);
+    EXPECT_EQ(DrawChunkCount(600, 8, 256), 2);
+    EXPECT_EQ(DrawChunkCount(20000, 8, 256), 8);
+    EXPECT_EQ(DrawChunkCount(20000, 3, 256), 3);
+    EXPECT_EQ(DrawChunkCount(20000, 0, 256), 1);
+
+    // The chunks tile the list without gaps or overlaps.
+    for (size_t DrawCount : { (size_t)0, (size_t)600, (size_t)20001 })
+    {
+        const int ChunkCount = DrawChunkCount(DrawCount, 8, 256);
+        EXPECT_EQ(DrawChunkBegin(DrawCount, 0, ChunkCount), 0u);
+        EXPECT_EQ(DrawChunkBegin(DrawCount, ChunkCount, ChunkCount), DrawCount);
+        for (int Chunk = 0; Chunk < ChunkCount; ++Chunk)
+        {
+            EXPECT_GE(DrawChunkBegin(DrawCount, Chunk + 1, ChunkCount) - DrawChunkBegin(DrawCount, Chunk, ChunkCount),
+                ChunkCount > 1 ? 256u : 0u);
+        }
+    }
+}
+
+TEST(DrawStateCache, ParallelChunksDrawLikeSerialRecording)
+{
+    // The recording in D3D12::Draw: chunks of the sorted opaque list recorded on separate
+    // lists by the default executor, then submitted in chunk order.
+    ThreadPool Pool(3);
+    SetDefaultExecutor(&Pool);
+    const int WorkerCount = (std::min)(MAX_RECORD_WORKERS, GetDefaultExecutor().Concurrency());
+
+    std::mt19937 Rng(5);
+    for (size_t DrawCount : { (size_t)100, (size_t)600, (size_t)20000 })
+    {
+        std::vector<TestItem> Items(DrawCount);
+        for (size_t i = 0; i < DrawCount; ++i)
+        {
+            // Sorted by geometry and material, as after SortRenderItems.
+            Items[i] = { (int)(i * 3 / DrawCount), (int)(i * 40 / DrawCount), (int)(Rng() % 1000), D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST };
+        }
+
+        MockCommandList Serial;
+        UncachedRecorder Reference = { &Serial };
+        for (const TestItem& Item : Items)
+        {
+            RecordItem(Reference, Item);
+        }
+
+        const int ChunkCount = DrawChunkCount(DrawCount, WorkerCount, 256);
+        std::vector<MockCommandList> Lists(ChunkCount);
+        std::vector<DrawStateStats> ChunkStats(ChunkCount);
+        ParallelFor(0, ChunkCount, 1, [&](int ChunkBegin, int ChunkEnd)
+        {
+            for (int Chunk = ChunkBegin; Chunk < ChunkEnd; ++Chunk)
+            {
+                DrawStateCache<MockCommandList> State(&Lists[Chunk]);
+                const size_t End = DrawChunkBegin(DrawCount, Chunk + 1, ChunkCount);
+                for (size_t i = DrawChunkBegin(DrawCount, Chunk, ChunkCount); i < End; ++i)
+                {
+                    RecordItem(State, Items[i]);
+                }
+                ChunkStats[Chunk] = State.Stats();
+            }
+        });
+
+        MockCommandList Submitted;
+        DrawStateStats Stats;
+        for (int Chunk = 0; Chunk < ChunkCount; ++Chunk)
+        {
+            Submitted.Draws.insert(Submitted.Draws.end(), Lists[Chunk].Draws.begin(), Lists[Chunk].Draws.end());
+            Stats += ChunkStats[Chunk];
+        }
+
+        SCOPED_TRACE(::testing::Message() << DrawCount << " draws in " << ChunkCount << " chunks");
+        ExpectSameDraws(Submitted, Serial);
+        EXPECT_EQ(Stats.Draws, (UINT)DrawCount);
+        EXPECT_EQ(Stats.Emitted + Stats.Elided, 6 * (UINT)DrawCount);
+    }
+
+    SetDefaultExecutor(nullptr);
+}
@@ -0,0 +1,198 @@
+#include "FenceWaiter.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Completes PollsUntilComplete polls after a wait starts polling, or when blocked on.
+    class SimulatedFence : public WaitableFence
+    {
+    public:
+        std::uint64_t Completed = 0;
+        std::uint64_t Target = 0;
+        int PollsUntilComplete = -1;            // -1: only BlockUntil completes it.
+        std::vector<std::uint64_t> BlockedOn;
+
+        std::uint64_t GetCompletedValue() override
+        {
+            if (PollsUntilComplete == 0)
+            {
+                Completed = Target;
+            }
+            if (PollsUntilComplete > 0)
+            {
+                --PollsUntilComplete;
+            }
+            return Completed;
+        }
+
+        void BlockUntil(std::uint64_t value) override
+        {
+            BlockedOn.push_back(value);
+            Completed = value;
+        }
+    };
+
+    // A GPU thread that retires one submitted frame every few hundred microseconds.
+    class ThreadedFence : public WaitableFence
+    {
+    public:
+        std::uint64_t GetCompletedValue() override
+        {
+            return mCompleted.load();
+        }
+
+        void BlockUntil(std::uint64_t value) override
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [&] { return mCompleted.load() >= value; });
+        }
+
+        void Complete(std::uint64_t value)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mCompleted.store(value);
+            }
+            mCondition.notify_all();
+        }
+
+    private:
+        std::atomic<std::uint64_t> mCompleted{ 0 };
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+    };
+
+    SimulatedFence* MakeWaiter(FenceWaiter& waiter)
+    {
+        auto fence = std::make_unique<SimulatedFence>();
+        SimulatedFence* raw = fence.get();
+        waiter.SetFence(std::move(fence));
+        return raw;
+    }
+}
+
+TEST(FenceWaiter, CompletedValuesDoNotStall)
+{
+    FenceWaiter waiter;
+    SimulatedFence* fence = MakeWaiter(waiter);
+    fence->Completed = 5;
+
+    EXPECT_TRUE(waiter.IsComplete(5));
+    EXPECT_FALSE(waiter.IsComplete(6));
+    EXPECT_FALSE(waiter.Wait(0));
+    EXPECT_FALSE(waiter.Wait(3));
+    EXPECT_FALSE(waiter.Wait(5));
+
+    EXPECT_EQ(waiter.GetStats().WaitCount, 3u);
+    EXPECT_EQ(waiter.GetStats().StallCount, 0u);
+    EXPECT_TRUE(fence->BlockedOn.empty());
+}
+
+TEST(FenceWaiter, FenceReachedWhileSpinningDoesNotBlock)
+{
+    FenceWaiter waiter;
+    SimulatedFence* fence = MakeWaiter(waiter);
+    waiter.SetSpinMicroseconds(1000000);
+    fence->Target = 7;
+    fence->PollsUntilComplete = 3;
+
+    EXPECT_TRUE(waiter.Wait(7));
+    EXPECT_TRUE(fence->BlockedOn.empty());
+    EXPECT_EQ(waiter.GetStats().StallCount, 1u);
+    EXPECT_EQ(waiter.GetStats().SpinCount, 1u);
+}
+
+TEST(FenceWaiter, BlocksOnceTheSpinRunsOut)
+{
+    FenceWaiter waiter;
+    SimulatedFence* fence = MakeWaiter(waiter);
+
+    waiter.SetSpinMicroseconds(0);
+    EXPECT_TRUE(waiter.Wait(2));
+    waiter.SetSpinMicroseconds(100);
+    EXPECT_TRUE(waiter.Wait(4));
+
+    EXPECT_EQ(fence->BlockedOn, (std::vector<std::uint64_t>{ 2, 4 }));
+    const FenceWaiter::Stats& stats = waiter.GetStats();
+    EXPECT_EQ(stats.WaitCount, 2u);
+    EXPECT_EQ(stats.StallCount, 2u);
+    EXPECT_EQ(stats.SpinCount, 0u);
+    EXPECT_GE(stats.LastStallMilliseconds, 0.1 * 0.5);
+    EXPECT_GE(stats.MaxStallMilliseconds, stats.LastStallMilliseconds);
+    EXPECT_GE(stats.StallMilliseconds, stats.MaxStallMilliseconds);
+
+    waiter.ResetStats();
+    EXPECT_EQ(waiter.GetStats().WaitCount, 0u);
+    EXPECT_EQ(waiter.GetStats().StallMilliseconds, 0.0);
+}
+
+TEST(FenceWaiter, FrameLatencyLimit)
+{
+    FenceWaiter waiter;
+    SimulatedFence* fence = MakeWaiter(waiter);
+    waiter.SetSpinMicroseconds(0);
+    fence->Completed = 3;
+
+    EXPECT_EQ(waiter.FramesInFlight(5), 2u);
+    EXPECT_EQ(waiter.FramesInFlight(2), 0u);
+
+    // Disabled, too few frames submitted, or already under the limit.
+    EXPECT_FALSE(waiter.WaitForFrameLatency(5, 0));
+    EXPECT_FALSE(waiter.WaitForFrameLatency(1, 2));
+    EXPECT_FALSE(waiter.WaitForFrameLatency(5, 3));
+    EXPECT_TRUE(fence->BlockedOn.empty());
+
+    // Frames 4 and 5 are in flight; a limit of 2 waits for frame 4 so one stays queued.
+    EXPECT_TRUE(waiter.WaitForFrameLatency(5, 2));
+    EXPECT_EQ(fence->BlockedOn, (std::vector<std::uint64_t>{ 4 }));
+    EXPECT_EQ(waiter.FramesInFlight(5), 1u);
+
+    // A limit of 1 drains the queue.
+    EXPECT_TRUE(waiter.WaitForFrameLatency(5, 1));
+    EXPECT_EQ(waiter.FramesInFlight(5), 0u);
+}
+
+TEST(FenceWaiter, KeepsLatencyAgainstARunningGpu)
+{
+    const std::uint64_t frameCount = 200;
+    const std::uint32_t maxLatency = 2;
+
+    auto fence = std::make_unique<ThreadedFence>();
+    ThreadedFence* gpu = fence.get();
+    FenceWaiter waiter(std::move(fence));
+    waiter.SetSpinMicroseconds(20);
+
+    std::atomic<std::uint64_t> submitted{ 0 };
+    std::thread gpuThread([&]
+    {
+        for (std::uint64_t frame = 1; frame <= frameCount; ++frame)
+        {
+            while (submitted.load() < frame)
+            {
+                std::this_thread::yield();
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            gpu->Complete(frame);
+        }
+    });
+
+    for (std::uint64_t frame = 1; frame <= frameCount; ++frame)
+    {
+        waiter.WaitForFrameLatency(frame - 1, maxLatency);
+        ASSERT_LT(waiter.FramesInFlight(frame - 1), maxLatency) << "frame " << frame;
+        submitted.store(frame);
+    }
+    waiter.Wait(frameCount);
+    gpuThread.join();
+
+    EXPECT_EQ(waiter.FramesInFlight(frameCount), 0u);
+    EXPECT_GT(waiter.GetStats().StallCount, 0u);
+}
@@ -0,0 +1,108 @@
+#include "FrameTimeHistogram.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+TEST(FrameTimeHistogram, EmptyReportsZero)
+{
+    FrameTimeHistogram histogram;
+    EXPECT_EQ(histogram.SampleCount(), 0u);
+    EXPECT_EQ(histogram.Mean(), 0.0);
+    EXPECT_EQ(histogram.StandardDeviation(), 0.0);
+    EXPECT_EQ(histogram.Percentile(0.99), 0.0);
+    EXPECT_EQ(histogram.Max(), 0.0);
+}
+
+TEST(FrameTimeHistogram, SmallValuesAreExact)
+{
+    // 1..50 us all fall into the exact buckets.
+    FrameTimeHistogram histogram(100);
+    for (int us = 1; us <= 50; ++us)
+    {
+        histogram.AddSample(us * 1e-6);
+    }
+
+    EXPECT_EQ(histogram.SampleCount(), 50u);
+    EXPECT_DOUBLE_EQ(histogram.Mean(), 25.5e-3);
+    EXPECT_DOUBLE_EQ(histogram.Percentile(0.0), 1e-3);
+    EXPECT_DOUBLE_EQ(histogram.Percentile(0.5), 25e-3);
+    EXPECT_DOUBLE_EQ(histogram.Percentile(0.9), 45e-3);
+    EXPECT_DOUBLE_EQ(histogram.Max(), 50e-3);
+}
+
+TEST(FrameTimeHistogram, PercentilesStayWithinThreePercent)
+{
+    // One sample at a time over 1 us .. 100 s, so every bucket boundary region is hit.
+    for (double seconds = 1e-6; seconds < 100.0; seconds *= 1.037)
+    {
+        FrameTimeHistogram histogram(1);
+        histogram.AddSample(seconds);
+        const double ms = std::round(seconds * 1e6) * 1e-3;
+        EXPECT_NEAR(histogram.Percentile(0.5), ms, ms * 0.03) << seconds << " s";
+    }
+}
+
+TEST(FrameTimeHistogram, MeanAndDeviationAreExact)
+{
+    FrameTimeHistogram histogram(4);
+    histogram.AddSample(0.001);
+    histogram.AddSample(0.003);
+    histogram.AddSample(0.001);
+    histogram.AddSample(0.003);
+
+    EXPECT_DOUBLE_EQ(histogram.Mean(), 2.0);
+    EXPECT_NEAR(histogram.StandardDeviation(), 1.0, 1e-9);
+}
+
+TEST(FrameTimeHistogram, OldSamplesLeaveTheWindow)
+{
+    FrameTimeHistogram histogram(10);
+    for (int i = 0; i < 10; ++i)
+    {
+        histogram.AddSample(0.001);
+    }
+    // A 50 ms hitch, then enough fast frames to push it and the 1 ms frames out.
+    histogram.AddSample(0.050);
+    EXPECT_NEAR(histogram.Max(), 50.0, 1.5);
+    for (int i = 0; i < 10; ++i)
+    {
+        histogram.AddSample(0.005);
+    }
+
+    EXPECT_EQ(histogram.SampleCount(), 10u);
+    EXPECT_NEAR(histogram.Mean(), 5.0, 1e-9);
+    EXPECT_NEAR(histogram.StandardDeviation(), 0.0, 1e-6);
+    EXPECT_NEAR(histogram.Percentile(0.01), 5.0, 0.15);
+    EXPECT_NEAR(histogram.Max(), 5.0, 0.15);
+}
+
+TEST(FrameTimeHistogram, ClampsOutOfRangeSamples)
+{
+    FrameTimeHistogram histogram(2);
+    histogram.AddSample(-1.0);
+    EXPECT_EQ(histogram.Max(), 0.0);
+
+    // Anything past about 134 s lands in the last bucket.
+    histogram.AddSample(1e6);
+    EXPECT_NEAR(histogram.Max(), 134217.7, 134217.7 * 0.03);
+}
+
+TEST(FrameTimeHistogram, ClearEmptiesTheWindow)
+{
+    FrameTimeHistogram histogram(3);
+    histogram.AddSample(0.010);
+    histogram.AddSample(0.020);
+    histogram.Clear();
+    EXPECT_EQ(histogram.SampleCount(), 0u);
+    EXPECT_EQ(histogram.Max(), 0.0);
+
+    // The ring restarts, so the window holds exactly the new samples.
+    for (int i = 0; i < 5; ++i)
+    {
+        histogram.AddSample(0.002);
+    }
+    EXPECT_EQ(histogram.SampleCount(), 3u);
+    EXPECT_NEAR(histogram.Mean(), 2.0, 1e-9);
+    EXPECT_NEAR(histogram.Max(), 2.0, 0.06);
+}
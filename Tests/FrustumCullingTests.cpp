@@ -0,0 +1,152 @@
+#include "FrustumCulling.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Camera at (0, 0, -10) looking down +z, 90 degree vertical field of view, near 1, far 100.
+    XMMATRIX MakeViewProj()
+    {
+        const XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -10.0f, 1.0f),
+            XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        const XMMATRIX proj = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.5f, 1.0f, 100.0f);
+        return XMMatrixMultiply(view, proj);
+    }
+
+    float PlaneDistance(const XMFLOAT4& plane, const XMFLOAT3& p)
+    {
+        return plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+    }
+
+    bool ReferenceVisible(const FrustumPlanes& frustum, const BoundingSphere& sphere)
+    {
+        if (sphere.Radius < 0.0f)
+        {
+            return true;
+        }
+        for (const XMFLOAT4& plane : frustum.Planes)
+        {
+            if (PlaneDistance(plane, sphere.Center) < -sphere.Radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+TEST(FrustumCulling, PlanesFromViewProj)
+{
+    const FrustumPlanes frustum = FrustumPlanes::FromViewProj(MakeViewProj());
+
+    for (const XMFLOAT4& plane : frustum.Planes)
+    {
+        EXPECT_NEAR(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z, 1.0f, 1e-5f);
+        EXPECT_GT(PlaneDistance(plane, XMFLOAT3(0.0f, 0.0f, 0.0f)), 0.0f);
+    }
+
+    // Near and far planes lie 1 and 100 units in front of the eye.
+    EXPECT_NEAR(PlaneDistance(frustum.Planes[4], XMFLOAT3(0.0f, 0.0f, -9.0f)), 0.0f, 1e-4f);
+    EXPECT_NEAR(PlaneDistance(frustum.Planes[5], XMFLOAT3(0.0f, 0.0f, 90.0f)), 0.0f, 1e-3f);
+
+    // 90 degrees vertically: the top plane passes through (0, 20, 10).
+    EXPECT_NEAR(PlaneDistance(frustum.Planes[3], XMFLOAT3(0.0f, 20.0f, 10.0f)), 0.0f, 1e-4f);
+}
+
+TEST(FrustumCulling, MatchesScalarReference)
+{
+    const FrustumPlanes frustum = FrustumPlanes::FromViewProj(MakeViewProj());
+
+    // An odd count so the last SIMD block is partly padding.
+    const std::uint32_t count = 10007;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+    std::uniform_real_distribution<float> radius(0.0f, 8.0f);
+
+    std::vector<BoundingSphere> spheres;
+    SphereCullSet cullSet;
+    cullSet.Resize(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        BoundingSphere sphere(XMFLOAT3(position(rng), position(rng), position(rng)), radius(rng));
+        if (i % 97 == 0)
+        {
+            sphere = AlwaysVisibleBounds;
+        }
+        spheres.push_back(sphere);
+        cullSet.SetSphere(i, sphere);
+    }
+
+    std::vector<std::uint8_t> visible;
+    cullSet.Cull(frustum, visible);
+    ASSERT_EQ(visible.size(), count);
+
+    int visibleCount = 0;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(visible[i] != 0, ReferenceVisible(frustum, spheres[i])) << "sphere " << i;
+        visibleCount += visible[i];
+    }
+
+    // Both outcomes occur often enough to mean something.
+    EXPECT_GT(visibleCount, 500);
+    EXPECT_LT(visibleCount, (int)count - 500);
+}
+
+TEST(FrustumCulling, SpheresWithoutBoundsAreAlwaysVisible)
+{
+    const FrustumPlanes frustum = FrustumPlanes::FromViewProj(MakeViewProj());
+
+    SphereCullSet cullSet;
+    cullSet.Resize(3);
+
+    // Behind the camera: culled with real bounds, kept without.
+    cullSet.SetSphere(0, BoundingSphere(XMFLOAT3(0.0f, 0.0f, -50.0f), 1.0f));
+    cullSet.SetSphere(1, BoundingSphere(XMFLOAT3(0.0f, 0.0f, -50.0f), AlwaysVisibleBounds.Radius));
+
+    // The default bounds stay unbounded after a world transform.
+    BoundingSphere worldBounds;
+    AlwaysVisibleBounds.Transform(worldBounds, XMMatrixScaling(3.0f, 3.0f, 3.0f) * XMMatrixTranslation(0.0f, 0.0f, -500.0f));
+    cullSet.SetSphere(2, worldBounds);
+
+    std::vector<std::uint8_t> visible;
+    cullSet.Cull(frustum, visible);
+    EXPECT_EQ(visible, (std::vector<std::uint8_t>{ 0, 1, 1 }));
+}
+
+TEST(FrustumCulling, EmptySlotsAreCulled)
+{
+    const FrustumPlanes frustum = FrustumPlanes::FromViewProj(MakeViewProj());
+    const BoundingSphere inView(XMFLOAT3(0.0f, 0.0f, 0.0f), 1.0f);
+
+    SphereCullSet cullSet;
+    cullSet.Resize(12);
+    for (std::uint32_t i = 0; i < 12; ++i)
+    {
+        cullSet.SetSphere(i, inView);
+    }
+
+    // Shrinking pads the tail of the last block; growing again adds empty slots, not the
+    // spheres that were there before.
+    cullSet.Resize(3);
+    EXPECT_EQ(cullSet.Size(), 3u);
+    EXPECT_EQ(cullSet.Capacity() % 4, 0u);
+    cullSet.Resize(12);
+
+    std::vector<std::uint8_t> visible;
+    cullSet.Cull(frustum, visible);
+    ASSERT_EQ(visible.size(), 12u);
+    for (std::uint32_t i = 0; i < 12; ++i)
+    {
+        EXPECT_EQ(visible[i], i < 3 ? 1 : 0) << "slot " << i;
+    }
+
+    cullSet.Resize(0);
+    cullSet.Cull(frustum, visible);
+    EXPECT_TRUE(visible.empty());
+}
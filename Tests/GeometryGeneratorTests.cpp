@@ -0,0 +1,310 @@
+#include "GeometryGenerator.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <tuple>
+#include <utility>
+
+using namespace DirectX;
+
+namespace
+{
+    using Edge = std::pair<std::uint32_t, std::uint32_t>;
+
+    // Number of triangles using each undirected edge.
+    std::map<Edge, int> CountEdges(const GeometryGenerator::MeshData& mesh)
+    {
+        std::map<Edge, int> edges;
+        for (size_t i = 0; i < mesh.Indices32.size(); i += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                std::uint32_t a = mesh.Indices32[i + k];
+                std::uint32_t b = mesh.Indices32[i + (k + 1) % 3];
+                ++edges[a < b ? Edge(a, b) : Edge(b, a)];
+            }
+        }
+        return edges;
+    }
+
+    std::set<std::tuple<float, float, float>> DistinctPositions(const GeometryGenerator::MeshData& mesh)
+    {
+        std::set<std::tuple<float, float, float>> positions;
+        for (const GeometryGenerator::Vertex& v : mesh.Vertices)
+        {
+            positions.emplace(v.Position.x, v.Position.y, v.Position.z);
+        }
+        return positions;
+    }
+}
+
+TEST(GeometryGenerator, GeosphereSharesEdgeMidpoints)
+{
+    GeometryGenerator geoGen;
+
+    for (std::uint32_t subdivisions = 0; subdivisions <= 4; ++subdivisions)
+    {
+        const GeometryGenerator::MeshData mesh = geoGen.CreateGeosphere(2.0f, subdivisions);
+
+        // Icosahedron: V = 12, F = 20.  Each level maps V -> V + E and F -> 4F, which for a
+        // closed triangle mesh gives V = 10 * 4^n + 2.
+        const std::uint32_t faces = 20u << (2 * subdivisions);
+        EXPECT_EQ(mesh.Vertices.size(), 10u * (1u << (2 * subdivisions)) + 2u) << subdivisions;
+        EXPECT_EQ(mesh.Indices32.size(), 3u * faces) << subdivisions;
+
+        // Closed and watertight: every edge is shared by exactly two triangles.
+        const std::map<Edge, int> edges = CountEdges(mesh);
+        EXPECT_EQ(edges.size(), 3u * faces / 2u) << subdivisions;
+        for (const auto& e : edges)
+        {
+            ASSERT_EQ(e.second, 2) << "edge " << e.first.first << "-" << e.first.second;
+        }
+
+        // No vertex is duplicated and all lie on the sphere.
+        EXPECT_EQ(DistinctPositions(mesh).size(), mesh.Vertices.size()) << subdivisions;
+        for (const GeometryGenerator::Vertex& v : mesh.Vertices)
+        {
+            const float r = std::sqrt(v.Position.x * v.Position.x + v.Position.y * v.Position.y + v.Position.z * v.Position.z);
+            ASSERT_NEAR(r, 2.0f, 1e-5f);
+        }
+    }
+}
+
+TEST(GeometryGenerator, SubdividedBoxSharesMidpointsWithinEachFace)
+{
+    GeometryGenerator geoGen;
+
+    // The box's faces have their own vertices.  Once subdivided, a face (4 vertices, 5
+    // edges) has 9 vertices and 8 triangles, with no midpoint created twice.
+    const GeometryGenerator::MeshData mesh = geoGen.CreateBox(2.0f, 2.0f, 2.0f, 1);
+    EXPECT_EQ(mesh.Vertices.size(), 6u * 9u);
+    EXPECT_EQ(mesh.Indices32.size(), 6u * 8u * 3u);
+
+    for (const auto& e : CountEdges(mesh))
+    {
+        EXPECT_LE(e.second, 2);
+    }
+}
+
+// The portable build's XMVectorSinCos evaluates the SDK's polynomial, so the hills tests
+// below measure its approximation error rather than comparing the CRT with itself.
+TEST(GeometryGenerator, SinCosIsTheSdkPolynomial)
+{
+    float maxError = 0.0f;
+    int inexact = 0;
+    for (int i = -2000; i <= 2000; i += 4)
+    {
+        const XMVECTOR angles = XMVectorSet(i * 0.01f, (i + 1) * 0.01f, (i + 2) * 0.01f, (i + 3) * 0.01f);
+        XMVECTOR sinV, cosV;
+        XMVectorSinCos(&sinV, &cosV, angles);
+
+        XMFLOAT4 a, s, c;
+        XMStoreFloat4(&a, angles);
+        XMStoreFloat4(&s, sinV);
+        XMStoreFloat4(&c, cosV);
+        for (const auto& lane : { std::make_tuple(a.x, s.x, c.x), std::make_tuple(a.y, s.y, c.y),
+            std::make_tuple(a.z, s.z, c.z), std::make_tuple(a.w, s.w, c.w) })
+        {
+            const float angle = std::get<0>(lane);
+            const float sinError = std::fabs(std::get<1>(lane) - std::sin(angle));
+            const float cosError = std::fabs(std::get<2>(lane) - std::cos(angle));
+            maxError = std::fmax(maxError, std::fmax(sinError, cosError));
+            inexact += (sinError != 0.0f || cosError != 0.0f) ? 1 : 0;
+        }
+    }
+
+    EXPECT_LT(maxError, 2e-6f);
+    EXPECT_GT(inexact, 0);
+}
+
+namespace
+{
+    // ApplyHills uses DirectXMath's polynomial sin/cos; GetHillsHeight uses the CRT.  The
+    // height is about |x| + 0.3 |z|, so its error grows with the distance from the origin.
+    void ExpectMatchesScalarHills(const GeometryGenerator::Vertex& v, size_t i)
+    {
+        const float height = GeometryGenerator::GetHillsHeight(v.Position.x, v.Position.z);
+        const XMFLOAT3 normal = GeometryGenerator::GetHillsNormal(v.Position.x, v.Position.z);
+        const float heightTolerance = 1e-5f * (1.0f + std::fabs(v.Position.x) + std::fabs(v.Position.z));
+
+        ASSERT_NEAR(v.Position.y, height, heightTolerance) << "vertex " << i;
+        ASSERT_NEAR(v.Normal.x, normal.x, 1e-5f) << "vertex " << i;
+        ASSERT_NEAR(v.Normal.y, normal.y, 1e-5f) << "vertex " << i;
+        ASSERT_NEAR(v.Normal.z, normal.z, 1e-5f) << "vertex " << i;
+    }
+}
+
+TEST(GeometryGenerator, BatchedHillsMatchScalarHills)
+{
+    GeometryGenerator geoGen;
+
+    // 51 x 51 vertices: not a multiple of 4, so the scalar tail runs too.
+    GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, 51, 51);
+    ASSERT_NE(grid.Vertices.size() % 4, 0u);
+
+    GeometryGenerator::ApplyHills(grid.Vertices.data(), grid.Vertices.size());
+    for (size_t i = 0; i < grid.Vertices.size(); ++i)
+    {
+        ExpectMatchesScalarHills(grid.Vertices[i], i);
+    }
+}
+
+TEST(GeometryGenerator, ParallelHillsMatchBatchedHills)
+{
+    GeometryGenerator geoGen;
+
+    GeometryGenerator::MeshData serial = geoGen.CreateGrid(160.0f, 160.0f, 75, 61);
+    GeometryGenerator::MeshData parallel = serial;
+
+    GeometryGenerator::ApplyHills(serial.Vertices.data(), serial.Vertices.size());
+    GeometryGenerator::ApplyHills(parallel, 61);
+
+    ASSERT_EQ(serial.Vertices.size(), parallel.Vertices.size());
+    for (size_t i = 0; i < serial.Vertices.size(); ++i)
+    {
+        // Row blocks start on multiples of the row length, so the 4-wide groups can differ
+        // from the serial run; compare against the scalar reference instead.
+        ExpectMatchesScalarHills(parallel.Vertices[i], i);
+    }
+}
+
+TEST(GeometryGenerator, TerrainHillsUpdateTileBounds)
+{
+    GeometryGenerator geoGen;
+
+    GeometryGenerator::TerrainData terrain = geoGen.CreateTerrain(160.0f, 160.0f, 4, 4, 16, 3);
+    GeometryGenerator::ApplyHills(terrain);
+
+    for (size_t i = 0; i < terrain.Vertices.size(); ++i)
+    {
+        ExpectMatchesScalarHills(terrain.Vertices[i], i);
+    }
+
+    // Every vertex of a tile lies inside that tile's box.
+    for (std::uint32_t tile = 0; tile < terrain.TileCountX * terrain.TileCountZ; ++tile)
+    {
+        const BoundingBox& box = terrain.TileBounds[tile];
+        for (std::uint32_t i = 0; i < terrain.TileVertexCount; ++i)
+        {
+            const XMFLOAT3& p = terrain.Vertices[(size_t)tile * terrain.TileVertexCount + i].Position;
+            ASSERT_LE(std::fabs(p.y - box.Center.y), box.Extents.y + 1e-4f) << "tile " << tile;
+            ASSERT_LE(std::fabs(p.x - box.Center.x), box.Extents.x + 1e-4f) << "tile " << tile;
+        }
+    }
+}
+
+namespace
+{
+    // Positions (x, z) a tile's triangles use on one of its borders at the given draw args.
+    std::set<std::pair<float, float>> UsedBorderPositions(const GeometryGenerator::TerrainData& terrain,
+        std::uint32_t tileX, std::uint32_t tileZ, std::uint32_t lod, std::uint32_t mask, std::uint32_t edge)
+    {
+        const std::uint32_t n = terrain.TileQuads + 1;
+        const SubmeshGeometry subMesh = terrain.GetTileSubmesh(tileX, tileZ, lod, mask);
+
+        std::set<std::pair<float, float>> used;
+        for (std::uint32_t k = 0; k < subMesh.IndexCount; ++k)
+        {
+            const std::uint32_t index = terrain.Indices16[subMesh.StartIndexLocation + k];
+            const std::uint32_t i = index / n;
+            const std::uint32_t j = index % n;
+            const bool onEdge =
+                (edge == GeometryGenerator::TerrainData::StitchNorth && i == 0) ||
+                (edge == GeometryGenerator::TerrainData::StitchSouth && i == n - 1) ||
+                (edge == GeometryGenerator::TerrainData::StitchWest && j == 0) ||
+                (edge == GeometryGenerator::TerrainData::StitchEast && j == n - 1);
+            if (onEdge)
+            {
+                const XMFLOAT3& p = terrain.Vertices[subMesh.BaseVertexLocation + index].Position;
+                used.emplace(p.x, p.z);
+            }
+        }
+        return used;
+    }
+}
+
+TEST(GeometryGenerator, TerrainLodsRefineTowardTheEye)
+{
+    GeometryGenerator geoGen;
+    GeometryGenerator::TerrainData terrain = geoGen.CreateTerrain(200.0f, 200.0f, 8, 8, 16, 3);
+    GeometryGenerator::ApplyHills(terrain);
+
+    // Eye above the north-west corner tile; the far corner is well past two LOD steps.
+    const XMFLOAT3 eye = terrain.TileBounds[0].Center;
+    std::vector<std::uint32_t> lods;
+    std::vector<std::uint32_t> masks;
+    terrain.SelectTileLods(eye, 30.0f, lods, masks);
+
+    ASSERT_EQ(lods.size(), 64u);
+    ASSERT_EQ(masks.size(), 64u);
+    EXPECT_EQ(lods[0], 0u);
+    EXPECT_EQ(lods[63], terrain.LodCount - 1);
+
+    for (std::uint32_t z = 0; z < terrain.TileCountZ; ++z)
+    {
+        for (std::uint32_t x = 0; x < terrain.TileCountX; ++x)
+        {
+            const std::uint32_t lod = lods[z * 8 + x];
+            ASSERT_LT(lod, terrain.LodCount);
+            if (x + 1 < 8) EXPECT_LE(std::abs((int)lod - (int)lods[z * 8 + x + 1]), 1) << x << "," << z;
+            if (z + 1 < 8) EXPECT_LE(std::abs((int)lod - (int)lods[(z + 1) * 8 + x]), 1) << x << "," << z;
+        }
+    }
+}
+
+TEST(GeometryGenerator, TerrainLodsAreLimitedToOneStepBetweenNeighbours)
+{
+    GeometryGenerator geoGen;
+    GeometryGenerator::TerrainData terrain = geoGen.CreateTerrain(200.0f, 200.0f, 8, 8, 16, 5);
+
+    // A short LOD distance would put the coarsest LOD right next to the eye's tile.
+    std::vector<std::uint32_t> lods;
+    std::vector<std::uint32_t> masks;
+    terrain.SelectTileLods(terrain.TileBounds[27].Center, 1.0f, lods, masks);
+
+    EXPECT_EQ(lods[27], 0u);
+    EXPECT_EQ(lods[26], 1u);
+    EXPECT_EQ(lods[19], 1u);
+    EXPECT_EQ(lods[18], 2u);
+    EXPECT_EQ(masks[27], (std::uint32_t)(GeometryGenerator::TerrainData::StitchNorth | GeometryGenerator::TerrainData::StitchSouth |
+        GeometryGenerator::TerrainData::StitchWest | GeometryGenerator::TerrainData::StitchEast));
+}
+
+TEST(GeometryGenerator, StitchedTerrainTilesShareTheirBorderVertices)
+{
+    GeometryGenerator geoGen;
+    GeometryGenerator::TerrainData terrain = geoGen.CreateTerrain(200.0f, 200.0f, 8, 8, 16, 3);
+
+    for (const XMFLOAT3& eye : { XMFLOAT3(-90.0f, 0.0f, 90.0f), XMFLOAT3(0.0f, 10.0f, 0.0f), XMFLOAT3(40.0f, 0.0f, -70.0f) })
+    {
+        std::vector<std::uint32_t> lods;
+        std::vector<std::uint32_t> masks;
+        terrain.SelectTileLods(eye, 25.0f, lods, masks);
+
+        // Without cracks both sides of every shared border use exactly the same vertices.
+        for (std::uint32_t z = 0; z < terrain.TileCountZ; ++z)
+        {
+            for (std::uint32_t x = 0; x < terrain.TileCountX; ++x)
+            {
+                const std::uint32_t t = z * terrain.TileCountX + x;
+                if (x + 1 < terrain.TileCountX)
+                {
+                    EXPECT_EQ(UsedBorderPositions(terrain, x, z, lods[t], masks[t], GeometryGenerator::TerrainData::StitchEast),
+                        UsedBorderPositions(terrain, x + 1, z, lods[t + 1], masks[t + 1], GeometryGenerator::TerrainData::StitchWest))
+                        << "tiles " << x << "," << z << " and east";
+                }
+                if (z + 1 < terrain.TileCountZ)
+                {
+                    const std::uint32_t s = t + terrain.TileCountX;
+                    EXPECT_EQ(UsedBorderPositions(terrain, x, z, lods[t], masks[t], GeometryGenerator::TerrainData::StitchSouth),
+                        UsedBorderPositions(terrain, x, z + 1, lods[s], masks[s], GeometryGenerator::TerrainData::StitchNorth))
+                        << "tiles " << x << "," << z << " and south";
+                }
+            }
+        }
+    }
+}
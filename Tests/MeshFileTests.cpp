@@ -0,0 +1,348 @@
+#include "MeshFile.h"
+#include "MeshTextParser.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    // Same size and layout as the engine's Vertex (position, normal, texcoord).
+    struct TestVertex
+    {
+        float Pos[3];
+        float Normal[3];
+        float TexC[2];
+    };
+
+    struct TestMesh
+    {
+        MeshFileHeader Header;
+        std::vector<MeshFileSubmesh> Submeshes;
+        std::vector<TestVertex> Vertices;
+        std::vector<std::uint16_t> Indices;
+    };
+
+    // A strip of quads split into two submeshes, the second one based at vertex 4.
+    TestMesh MakeMesh()
+    {
+        TestMesh mesh;
+        for (int i = 0; i < 8; ++i)
+        {
+            const float x = (float)(i / 2);
+            const float z = (float)(i % 2);
+            mesh.Vertices.push_back({ { x, 0.5f * x, z }, { 0.0f, 1.0f, 0.0f }, { x / 3.0f, z } });
+        }
+        mesh.Indices = { 0, 1, 2, 2, 1, 3, 0, 1, 2, 2, 1, 3 };
+
+        MeshFileSubmesh first;
+        std::strcpy(first.Name, "strip");
+        first.IndexCount = 6;
+        first.BoundsCenter = { 0.5f, 0.25f, 0.5f };
+        first.BoundsExtents = { 0.5f, 0.25f, 0.5f };
+        first.SphereRadius = 0.75f;
+
+        MeshFileSubmesh second = first;
+        std::strcpy(second.Name, "strip#1");
+        second.StartIndexLocation = 6;
+        second.BaseVertexLocation = 4;
+        second.BoundsCenter = { 2.5f, 1.25f, 0.5f };
+
+        mesh.Submeshes = { first, second };
+
+        mesh.Header.VertexCount = (std::uint32_t)mesh.Vertices.size();
+        mesh.Header.VertexByteStride = sizeof(TestVertex);
+        mesh.Header.IndexCount = (std::uint32_t)mesh.Indices.size();
+        mesh.Header.IndexByteStride = sizeof(std::uint16_t);
+        return mesh;
+    }
+
+    std::string Serialize(const TestMesh& mesh)
+    {
+        std::ostringstream out(std::ios::binary);
+        EXPECT_TRUE(MeshFile::Write(out, mesh.Header, mesh.Submeshes, mesh.Vertices.data(), mesh.Indices.data()));
+        return out.str();
+    }
+
+    // MeshFile::Read into vectors; the arrays are sized by the header it checked.
+    bool Read(const std::string& bytes, MeshFileHeader& header, std::vector<MeshFileSubmesh>& submeshes,
+        std::vector<TestVertex>& vertices, std::vector<char>& indexBytes)
+    {
+        std::istringstream in(bytes, std::ios::binary);
+        return MeshFile::Read(in, sizeof(TestVertex), header, submeshes,
+            [&](const MeshFileHeader& h, void*& vertexData, void*& indexData)
+            {
+                vertices.resize(h.VertexCount);
+                indexBytes.resize((size_t)MeshFile::IndexDataSize(h));
+                vertexData = vertices.data();
+                indexData = indexBytes.data();
+                return true;
+            });
+    }
+
+    bool Deserialize(const std::string& bytes, TestMesh& mesh)
+    {
+        std::vector<char> indexBytes;
+        if (!Read(bytes, mesh.Header, mesh.Submeshes, mesh.Vertices, indexBytes) ||
+            mesh.Header.IndexByteStride != sizeof(std::uint16_t))
+        {
+            return false;
+        }
+
+        mesh.Indices.resize(mesh.Header.IndexCount);
+        std::memcpy(mesh.Indices.data(), indexBytes.data(), indexBytes.size());
+        return true;
+    }
+
+    std::string ReadFile(const char* filename)
+    {
+        std::ifstream fin(filename, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    }
+
+    MeshFileHeader* HeaderOf(std::string& bytes)
+    {
+        return reinterpret_cast<MeshFileHeader*>(&bytes[0]);
+    }
+
+    MeshFileSubmesh* SubmeshOf(std::string& bytes, size_t i)
+    {
+        return reinterpret_cast<MeshFileSubmesh*>(&bytes[sizeof(MeshFileHeader) + i * sizeof(MeshFileSubmesh)]);
+    }
+}
+
+TEST(MeshFile, RoundTrip)
+{
+    const TestMesh source = MakeMesh();
+    const std::string bytes = Serialize(source);
+
+    EXPECT_EQ(bytes.size(), sizeof(MeshFileHeader) + 2 * sizeof(MeshFileSubmesh) +
+        source.Vertices.size() * sizeof(TestVertex) + source.Indices.size() * sizeof(std::uint16_t));
+
+    TestMesh loaded;
+    ASSERT_TRUE(Deserialize(bytes, loaded));
+
+    EXPECT_EQ(loaded.Header.Magic, (std::uint32_t)MeshFile::Magic);
+    EXPECT_EQ(loaded.Header.Version, (std::uint32_t)MeshFile::Version);
+    EXPECT_EQ(loaded.Header.SubmeshCount, 2u);
+    EXPECT_EQ(std::memcmp(loaded.Vertices.data(), source.Vertices.data(), source.Vertices.size() * sizeof(TestVertex)), 0);
+    EXPECT_EQ(loaded.Indices, source.Indices);
+
+    ASSERT_EQ(loaded.Submeshes.size(), source.Submeshes.size());
+    for (size_t i = 0; i < source.Submeshes.size(); ++i)
+    {
+        const MeshFileSubmesh& a = source.Submeshes[i];
+        const MeshFileSubmesh& b = loaded.Submeshes[i];
+        EXPECT_STREQ(a.Name, b.Name);
+        EXPECT_EQ(a.IndexCount, b.IndexCount);
+        EXPECT_EQ(a.StartIndexLocation, b.StartIndexLocation);
+        EXPECT_EQ(a.BaseVertexLocation, b.BaseVertexLocation);
+        EXPECT_EQ(a.BoundsCenter.x, b.BoundsCenter.x);
+        EXPECT_EQ(a.BoundsCenter.y, b.BoundsCenter.y);
+        EXPECT_EQ(a.BoundsExtents.z, b.BoundsExtents.z);
+        EXPECT_EQ(a.SphereRadius, b.SphereRadius);
+    }
+}
+
+TEST(MeshFile, RoundTrip32BitIndices)
+{
+    TestMesh source = MakeMesh();
+    std::vector<std::uint32_t> indices32(source.Indices.begin(), source.Indices.end());
+    source.Header.IndexByteStride = sizeof(std::uint32_t);
+
+    std::ostringstream out(std::ios::binary);
+    ASSERT_TRUE(MeshFile::Write(out, source.Header, source.Submeshes, source.Vertices.data(), indices32.data()));
+
+    MeshFileHeader header;
+    std::vector<MeshFileSubmesh> submeshes;
+    std::vector<TestVertex> vertices;
+    std::vector<char> indexBytes;
+    ASSERT_TRUE(Read(out.str(), header, submeshes, vertices, indexBytes));
+    EXPECT_EQ(header.IndexByteStride, sizeof(std::uint32_t));
+
+    std::vector<std::uint32_t> loaded(header.IndexCount);
+    std::memcpy(loaded.data(), indexBytes.data(), indexBytes.size());
+    EXPECT_EQ(loaded, indices32);
+}
+
+TEST(MeshFile, WriteMeshPicksTheIndexWidth)
+{
+    const TestMesh source = MakeMesh();
+    std::vector<std::uint32_t> indices32(source.Indices.begin(), source.Indices.end());
+
+    // The last index belongs to the submesh based at vertex 4 and names the last vertex.
+    for (std::uint32_t vertexCount : { 8u, 0x10005u })
+    {
+        std::vector<TestVertex> vertices(source.Vertices);
+        vertices.resize(vertexCount);
+        indices32.back() = vertexCount - 5;
+
+        std::ostringstream out(std::ios::binary);
+        ASSERT_TRUE(MeshFile::WriteMesh(out, source.Submeshes, vertices.data(), vertexCount, sizeof(TestVertex), indices32));
+
+        MeshFileHeader header;
+        std::vector<MeshFileSubmesh> submeshes;
+        std::vector<TestVertex> loadedVertices;
+        std::vector<char> indexBytes;
+        ASSERT_TRUE(Read(out.str(), header, submeshes, loadedVertices, indexBytes));
+        EXPECT_EQ(header.IndexByteStride, indices32.back() > 0xffffu ? sizeof(std::uint32_t) : sizeof(std::uint16_t));
+        EXPECT_EQ(header.VertexCount, vertexCount);
+    }
+}
+
+TEST(MeshFile, SubmeshNames)
+{
+    MeshFileSubmesh subMesh;
+    std::memset(subMesh.Name, 'x', sizeof(subMesh.Name));
+    MeshFile::SetName(subMesh, "skull#2");
+    EXPECT_EQ(MeshFile::GetName(subMesh), "skull#2");
+
+    // A name filling the whole field without a terminator is still read in bounds.
+    std::memset(subMesh.Name, 'x', sizeof(subMesh.Name));
+    EXPECT_EQ(MeshFile::GetName(subMesh), std::string(sizeof(subMesh.Name), 'x'));
+}
+
+// Parses the shipped models, writes them with the writer MeshLoader::SaveBinaryMesh uses
+// and reads them back with the reader MeshLoader::LoadBinaryMesh uses.
+TEST(MeshFile, RoundTripsModelsBitForBit)
+{
+    for (const char* filename : { "Models/skull.txt", "Models/car.txt" })
+    {
+        const std::string text = ReadFile(filename);
+        ASSERT_FALSE(text.empty()) << filename << " not found; run from the repository root";
+
+        MeshTextParser parser(text.data(), text.data() + text.size());
+        ASSERT_TRUE(parser.ParseHeader()) << parser.GetError();
+        std::vector<TestVertex> vertices(parser.VertexCount());
+        std::vector<std::uint32_t> indices32(3 * (size_t)parser.TriangleCount());
+        ASSERT_TRUE(parser.ParseVertices(vertices.data(), sizeof(TestVertex),
+            offsetof(TestVertex, Pos), offsetof(TestVertex, Normal), offsetof(TestVertex, TexC)) &&
+            parser.ParseIndices(indices32.data())) << parser.GetError();
+
+        std::vector<MeshFileSubmesh> submeshes(1);
+        MeshFile::SetName(submeshes[0], filename);
+        submeshes[0].IndexCount = (std::uint32_t)indices32.size();
+
+        std::ostringstream out(std::ios::binary);
+        ASSERT_TRUE(MeshFile::WriteMesh(out, submeshes, vertices.data(), (std::uint32_t)vertices.size(),
+            sizeof(TestVertex), indices32));
+
+        MeshFileHeader header;
+        std::vector<MeshFileSubmesh> loadedSubmeshes;
+        std::vector<TestVertex> loadedVertices;
+        std::vector<char> indexBytes;
+        ASSERT_TRUE(Read(out.str(), header, loadedSubmeshes, loadedVertices, indexBytes)) << filename;
+
+        ASSERT_EQ(loadedVertices.size(), vertices.size()) << filename;
+        EXPECT_EQ(std::memcmp(loadedVertices.data(), vertices.data(), vertices.size() * sizeof(TestVertex)), 0) << filename;
+
+        // Both models have fewer than 65,536 vertices, so the file holds 16-bit indices.
+        ASSERT_EQ(header.IndexByteStride, sizeof(std::uint16_t)) << filename;
+        std::vector<std::uint16_t> indices16(header.IndexCount);
+        std::memcpy(indices16.data(), indexBytes.data(), indexBytes.size());
+        EXPECT_EQ(std::vector<std::uint32_t>(indices16.begin(), indices16.end()), indices32) << filename;
+
+        ASSERT_EQ(loadedSubmeshes.size(), 1u);
+        EXPECT_EQ(MeshFile::GetName(loadedSubmeshes[0]), filename);
+        EXPECT_EQ(loadedSubmeshes[0].IndexCount, indices32.size());
+    }
+}
+
+TEST(MeshFile, RejectsTruncatedAndOversizedFiles)
+{
+    const std::string bytes = Serialize(MakeMesh());
+    TestMesh loaded;
+
+    for (size_t size : { (size_t)0, sizeof(MeshFileHeader) - 1, sizeof(MeshFileHeader), bytes.size() - 1 })
+    {
+        EXPECT_FALSE(Deserialize(bytes.substr(0, size), loaded)) << "size " << size;
+    }
+    EXPECT_FALSE(Deserialize(bytes + '\0', loaded));
+}
+
+TEST(MeshFile, RejectsStaleLayouts)
+{
+    const std::string good = Serialize(MakeMesh());
+    TestMesh loaded;
+
+    std::string bytes = good;
+    HeaderOf(bytes)->Magic ^= 1;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    HeaderOf(bytes)->Version = MeshFile::Version - 1;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    HeaderOf(bytes)->VertexByteStride += 4;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    HeaderOf(bytes)->IndexByteStride = 3;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+}
+
+TEST(MeshFile, RejectsCountsThatOverflow32Bits)
+{
+    // Counts whose byte sizes wrap to the real ones in 32-bit math must not pass the size
+    // check or reach an allocation.
+    const std::string good = Serialize(MakeMesh());
+    TestMesh loaded;
+
+    std::string bytes = good;
+    HeaderOf(bytes)->VertexCount += 0x80000000u;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    HeaderOf(bytes)->IndexCount += 0x80000000u;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    HeaderOf(bytes)->SubmeshCount = 0xffffffffu;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    HeaderOf(bytes)->VertexCount = 0xffffffffu;
+    HeaderOf(bytes)->IndexCount = 0xffffffffu;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+}
+
+TEST(MeshFile, RejectsSubmeshesOutsideTheArrays)
+{
+    const std::string good = Serialize(MakeMesh());
+    TestMesh loaded;
+
+    std::string bytes = good;
+    SubmeshOf(bytes, 1)->IndexCount = 7;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    SubmeshOf(bytes, 1)->StartIndexLocation = 0xfffffffeu;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    SubmeshOf(bytes, 0)->BaseVertexLocation = -1;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    bytes = good;
+    SubmeshOf(bytes, 0)->BaseVertexLocation = 9;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+
+    // Base 5 leaves only three vertices for index 3.
+    bytes = good;
+    SubmeshOf(bytes, 1)->BaseVertexLocation = 5;
+    EXPECT_FALSE(Deserialize(bytes, loaded));
+}
+
+TEST(MeshFile, RejectsIndicesPastTheVertexArray)
+{
+    TestMesh mesh = MakeMesh();
+    mesh.Indices[4] = 8;
+    TestMesh loaded;
+    EXPECT_FALSE(Deserialize(Serialize(mesh), loaded));
+}
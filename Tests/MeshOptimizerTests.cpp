@@ -0,0 +1,204 @@
+#include "MeshOptimizer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    struct TestVertex
+    {
+        float Pos[3];
+    };
+
+    struct TestMesh
+    {
+        std::vector<TestVertex> Vertices;
+        std::vector<std::uint32_t> Indices;
+    };
+
+    using Triangle = std::array<std::tuple<float, float, float>, 3>;
+
+    // Triangles by vertex position, each rotated to start at its smallest corner so the
+    // winding is kept but the starting corner does not matter.
+    std::vector<Triangle> Triangles(const TestMesh& mesh)
+    {
+        std::vector<Triangle> triangles;
+        for (size_t i = 0; i < mesh.Indices.size(); i += 3)
+        {
+            Triangle t;
+            for (int k = 0; k < 3; ++k)
+            {
+                const float* p = mesh.Vertices[mesh.Indices[i + k]].Pos;
+                t[k] = std::make_tuple(p[0], p[1], p[2]);
+            }
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            triangles.push_back(t);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // A size x size vertex grid with its triangles in random order, the worst case for the
+    // vertex cache.
+    TestMesh MakeShuffledGrid(std::uint32_t size)
+    {
+        TestMesh grid;
+        for (std::uint32_t i = 0; i < size; ++i)
+        {
+            for (std::uint32_t j = 0; j < size; ++j)
+            {
+                grid.Vertices.push_back({ { (float)j, 0.0f, (float)i } });
+            }
+        }
+
+        std::vector<std::array<std::uint32_t, 3>> triangles;
+        for (std::uint32_t i = 0; i + 1 < size; ++i)
+        {
+            for (std::uint32_t j = 0; j + 1 < size; ++j)
+            {
+                const std::uint32_t v = i * size + j;
+                triangles.push_back({ v, v + 1, v + size });
+                triangles.push_back({ v + size, v + 1, v + size + 1 });
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(11));
+
+        for (const auto& t : triangles)
+        {
+            grid.Indices.insert(grid.Indices.end(), t.begin(), t.end());
+        }
+        return grid;
+    }
+}
+
+TEST(MeshOptimizer, AnalyzeCountsCacheMisses)
+{
+    // Two triangles sharing an edge: 4 transforms for 2 triangles and 4 vertices.
+    const std::uint32_t quad[] = { 0, 1, 2, 2, 1, 3 };
+    MeshOptimizer::CacheStats stats = MeshOptimizer::AnalyzeVertexCache(quad, 6, 4);
+    EXPECT_FLOAT_EQ(stats.ACMR, 2.0f);
+    EXPECT_FLOAT_EQ(stats.ATVR, 1.0f);
+
+    // With a 2-entry FIFO, vertex 0 has been evicted by the time it is used again.
+    const std::uint32_t fan[] = { 0, 1, 2, 0, 2, 3 };
+    stats = MeshOptimizer::AnalyzeVertexCache(fan, 6, 4, 2);
+    EXPECT_FLOAT_EQ(stats.ACMR, 2.5f);
+    EXPECT_FLOAT_EQ(stats.ATVR, 1.25f);
+}
+
+TEST(MeshOptimizer, OptimizeKeepsTrianglesAndImprovesACMR)
+{
+    TestMesh grid = MakeShuffledGrid(40);
+    const std::vector<Triangle> before = Triangles(grid);
+
+    const MeshOptimizer::Report report = MeshOptimizer::Optimize(grid.Vertices, grid.Indices);
+
+    EXPECT_EQ(Triangles(grid), before);
+
+    // A shuffled grid misses on nearly every vertex; a regular grid can get close to 0.6
+    // with a 16-entry cache.
+    EXPECT_GT(report.Before.ACMR, 2.0f);
+    EXPECT_LT(report.After.ACMR, 0.8f);
+    EXPECT_LT(report.After.ATVR, 1.5f);
+}
+
+TEST(MeshOptimizer, KeepsAlreadyBetterTriangleOrder)
+{
+    // A quad is already optimal; Optimize must not make it worse.
+    std::vector<TestVertex> vertices(4);
+    std::vector<std::uint32_t> indices = { 0, 1, 2, 2, 1, 3 };
+    const MeshOptimizer::Report report = MeshOptimizer::Optimize(vertices, indices);
+    EXPECT_LE(report.After.ACMR, report.Before.ACMR);
+}
+
+TEST(MeshOptimizer, FormatReport)
+{
+    MeshOptimizer::Report report;
+    report.Before = { 2.5f, 3.0f };
+    report.After = { 0.625f, 1.25f };
+    EXPECT_EQ(MeshOptimizer::FormatReport("skull", report), "skull: ACMR 2.500 -> 0.625, ATVR 3.000 -> 1.250\n");
+}
+
+TEST(MeshOptimizer, VertexFetchUsesFirstUseOrderAndDropsUnused)
+{
+    // Vertices 1 and 4 are never referenced.
+    std::vector<int> vertices = { 10, 11, 12, 13, 14, 15 };
+    std::vector<std::uint32_t> indices = { 5, 3, 0, 0, 3, 2 };
+
+    std::vector<std::uint32_t> remap;
+    const size_t vertexCount = MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(), vertices.size(), remap);
+    ASSERT_EQ(vertexCount, 4u);
+    EXPECT_EQ(indices, (std::vector<std::uint32_t>{ 0, 1, 2, 2, 1, 3 }));
+    EXPECT_EQ(remap, (std::vector<std::uint32_t>{ 2, UINT32_MAX, 3, 1, UINT32_MAX, 0 }));
+
+    MeshOptimizer::RemapVertices(vertices, remap, vertexCount);
+    EXPECT_EQ(vertices, (std::vector<int>{ 15, 13, 10, 12 }));
+}
+
+TEST(MeshOptimizer, CompactIndicesSplitsLargeMeshesInto16BitChunks)
+{
+    // A 300x300 grid (90,000 vertices) followed by a quad submesh based past it.
+    TestMesh grid = MakeShuffledGrid(300);
+    const std::uint32_t gridVertexCount = (std::uint32_t)grid.Vertices.size();
+    ASSERT_GT(gridVertexCount, 0xffffu);
+
+    std::vector<std::uint32_t> indices = grid.Indices;
+    indices.insert(indices.end(), { 0, 1, 2, 2, 1, 3 });
+
+    std::vector<MeshOptimizer::IndexRange> ranges(2);
+    ranges[0].IndexCount = (std::uint32_t)grid.Indices.size();
+    ranges[1].IndexCount = 6;
+    ranges[1].StartIndexLocation = ranges[0].IndexCount;
+    ranges[1].BaseVertexLocation = (std::int32_t)gridVertexCount;
+
+    // Each vertex holds its own original index.
+    std::vector<std::uint32_t> vertices(gridVertexCount + 4);
+    for (std::uint32_t v = 0; v < vertices.size(); ++v)
+    {
+        vertices[v] = v;
+    }
+
+    const std::vector<std::uint32_t> original = indices;
+    std::vector<std::uint32_t> vertexSources;
+    const std::vector<MeshOptimizer::IndexChunk> chunks =
+        MeshOptimizer::CompactIndices(indices.data(), ranges, vertices.size(), vertexSources);
+    MeshOptimizer::GatherVertices(vertices, vertexSources);
+
+    ASSERT_GE(chunks.size(), 3u);
+    EXPECT_EQ(chunks.back().Submesh, 1u);
+    EXPECT_EQ(chunks.back().Number, 0);
+
+    std::uint32_t nextIndex = 0;
+    for (size_t c = 0; c < chunks.size(); ++c)
+    {
+        const MeshOptimizer::IndexChunk& chunk = chunks[c];
+        const MeshOptimizer::IndexRange& source = ranges[chunk.Submesh];
+
+        // Chunks tile the index buffer in order and never split a triangle.
+        EXPECT_EQ(chunk.StartIndexLocation, nextIndex);
+        EXPECT_EQ(chunk.IndexCount % 3, 0u);
+        nextIndex += chunk.IndexCount;
+        if (c > 0)
+        {
+            EXPECT_EQ(chunk.Number, chunk.Submesh == chunks[c - 1].Submesh ? chunks[c - 1].Number + 1 : 0);
+        }
+
+        const std::uint32_t chunkVertexEnd = c + 1 < chunks.size() ?
+            (std::uint32_t)chunks[c + 1].BaseVertexLocation : (std::uint32_t)vertices.size();
+        EXPECT_LE(chunkVertexEnd - (std::uint32_t)chunk.BaseVertexLocation, (std::uint32_t)MeshOptimizer::MaxChunkVertexCount);
+
+        for (std::uint32_t i = chunk.StartIndexLocation; i < chunk.StartIndexLocation + chunk.IndexCount; ++i)
+        {
+            ASSERT_LE(indices[i], 0xffffu) << "chunk " << c;
+            ASSERT_EQ(vertices[chunk.BaseVertexLocation + indices[i]], original[i] + source.BaseVertexLocation)
+                << "chunk " << c << " index " << i;
+        }
+    }
+    EXPECT_EQ(nextIndex, (std::uint32_t)indices.size());
+}
@@ -0,0 +1,190 @@
+#include "MeshTextParser.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct TestVertex
+    {
+        float Pos[3];
+        float Normal[3];
+        float TexC[2];
+    };
+
+    struct ParsedMesh
+    {
+        std::vector<TestVertex> Vertices;
+        std::vector<std::uint32_t> Indices;
+    };
+
+    bool Parse(const std::string& text, ParsedMesh& mesh, std::string* error = nullptr)
+    {
+        MeshTextParser parser(text.data(), text.data() + text.size());
+        bool parsed = parser.ParseHeader();
+        if (parsed)
+        {
+            mesh.Vertices.resize(parser.VertexCount());
+            mesh.Indices.resize(3 * (size_t)parser.TriangleCount());
+            parsed = parser.ParseVertices(mesh.Vertices.data(), sizeof(TestVertex),
+                offsetof(TestVertex, Pos), offsetof(TestVertex, Normal), offsetof(TestVertex, TexC)) &&
+                parser.ParseIndices(mesh.Indices.data());
+        }
+        if (error != nullptr)
+        {
+            *error = parser.GetError();
+        }
+        return parsed;
+    }
+
+    // The istream reader MeshTextParser replaced, kept as the reference.
+    bool ParseWithStream(const std::string& text, ParsedMesh& mesh)
+    {
+        std::istringstream in(text);
+        std::string ignore;
+        std::uint32_t vertexCount = 0;
+        std::uint32_t triangleCount = 0;
+
+        in >> ignore >> vertexCount;
+        in >> ignore >> triangleCount;
+        in >> ignore >> ignore >> ignore >> ignore;
+
+        mesh.Vertices.assign(vertexCount, TestVertex());
+        for (TestVertex& v : mesh.Vertices)
+        {
+            in >> v.Pos[0] >> v.Pos[1] >> v.Pos[2] >> v.Normal[0] >> v.Normal[1] >> v.Normal[2];
+        }
+
+        in >> ignore >> ignore >> ignore;
+
+        mesh.Indices.assign(3 * (size_t)triangleCount, 0);
+        for (std::uint32_t& index : mesh.Indices)
+        {
+            in >> index;
+        }
+        return !in.fail();
+    }
+
+    std::string ReadFile(const char* filename)
+    {
+        std::ifstream fin(filename, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    }
+
+    const char* const QuadText =
+        "VertexCount: 4\n"
+        "TriangleCount: 2\n"
+        "VertexList (pos, normal, texC)\n"
+        "{\n"
+        "\t-1 0 -1 0 1 0 0 1\n"
+        "\t-1 0 1 0 1 0 0 0\n"
+        "\t1 0 1 0 1 0 1 0\n"
+        "\t1.5e0 -0.25 -1 0 1 0 1 1\n"
+        "}\n"
+        "TriangleList\n"
+        "{\n"
+        "\t0 1 2\n"
+        "\t0 2 3\n"
+        "}\n";
+}
+
+TEST(MeshTextParser, ParsesTexCoords)
+{
+    ParsedMesh mesh;
+    ASSERT_TRUE(Parse(QuadText, mesh));
+
+    ASSERT_EQ(mesh.Vertices.size(), 4u);
+    EXPECT_EQ(mesh.Vertices[3].Pos[0], 1.5f);
+    EXPECT_EQ(mesh.Vertices[3].Pos[1], -0.25f);
+    EXPECT_EQ(mesh.Vertices[3].Normal[1], 1.0f);
+    EXPECT_EQ(mesh.Vertices[3].TexC[0], 1.0f);
+    EXPECT_EQ(mesh.Vertices[3].TexC[1], 1.0f);
+    EXPECT_EQ(mesh.Indices, (std::vector<std::uint32_t>{ 0, 1, 2, 0, 2, 3 }));
+}
+
+TEST(MeshTextParser, ZeroesMissingTexCoords)
+{
+    std::string text = QuadText;
+    text.replace(text.find("(pos, normal, texC)"), 19, "(pos, normal)");
+    for (const char* line : { " 0 1\n", " 0 0\n", " 1 0\n", " 1 1\n" })
+    {
+        text.erase(text.find(line, text.find("VertexList")), 4);
+    }
+
+    ParsedMesh mesh;
+    ASSERT_TRUE(Parse(text, mesh));
+    for (const TestVertex& v : mesh.Vertices)
+    {
+        EXPECT_EQ(v.TexC[0], 0.0f);
+        EXPECT_EQ(v.TexC[1], 0.0f);
+    }
+    EXPECT_EQ(mesh.Vertices[2].Pos[0], 1.0f);
+}
+
+TEST(MeshTextParser, ReportsErrorsWithLineNumbers)
+{
+    ParsedMesh mesh;
+    std::string error;
+
+    std::string text = QuadText;
+    text.replace(text.find("0 2 3"), 5, "0 2 4");
+    EXPECT_FALSE(Parse(text, mesh, &error));
+    EXPECT_EQ(error.rfind("line 13:", 0), 0u) << error;
+
+    text = QuadText;
+    text.replace(text.find("1.5e0"), 5, "1.5x0");
+    EXPECT_FALSE(Parse(text, mesh, &error));
+    EXPECT_EQ(error.rfind("line 8:", 0), 0u) << error;
+
+    text = QuadText;
+    text.resize(text.find("TriangleList"));
+    EXPECT_FALSE(Parse(text, mesh, &error));
+    EXPECT_FALSE(error.empty());
+
+    // Counts the rest of the file cannot hold fail before anything is sized from them.
+    text = QuadText;
+    text.replace(text.find("VertexCount: 4"), 14, "VertexCount: 4000000000");
+    ParsedMesh unsized;
+    EXPECT_FALSE(Parse(text, unsized, &error));
+    EXPECT_EQ(error.rfind("line 1: VertexCount", 0), 0u) << error;
+    EXPECT_TRUE(unsized.Vertices.empty());
+
+    text = QuadText;
+    text.replace(text.find("TriangleCount: 2"), 16, "TriangleCount: 20");
+    EXPECT_FALSE(Parse(text, mesh, &error));
+    EXPECT_EQ(error.rfind("line 2: TriangleCount", 0), 0u) << error;
+
+    EXPECT_FALSE(Parse("VertexCount 4", mesh, &error));
+    EXPECT_FALSE(Parse("", mesh, &error));
+}
+
+TEST(MeshTextParser, MatchesStreamReaderOnModels)
+{
+    for (const char* filename : { "Models/skull.txt", "Models/car.txt" })
+    {
+        const std::string text = ReadFile(filename);
+        ASSERT_FALSE(text.empty()) << filename;
+
+        ParsedMesh parsed;
+        ParsedMesh reference;
+        ASSERT_TRUE(Parse(text, parsed)) << filename;
+        ASSERT_TRUE(ParseWithStream(text, reference)) << filename;
+
+        ASSERT_EQ(parsed.Vertices.size(), reference.Vertices.size()) << filename;
+        for (size_t i = 0; i < parsed.Vertices.size(); ++i)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                ASSERT_EQ(parsed.Vertices[i].Pos[k], reference.Vertices[i].Pos[k]) << filename << " vertex " << i;
+                ASSERT_EQ(parsed.Vertices[i].Normal[k], reference.Vertices[i].Normal[k]) << filename << " vertex " << i;
+            }
+        }
+        EXPECT_EQ(parsed.Indices, reference.Indices) << filename;
+    }
+}
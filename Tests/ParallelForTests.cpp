@@ -0,0 +1,112 @@
+#include "ParallelFor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace
+{
+    // Runs a For over [begin, end) and checks every index is visited exactly once, in
+    // chunks no larger than grainSize.
+    void ExpectCoversRangeOnce(ParallelExecutor& executor, int begin, int end, int grainSize)
+    {
+        std::vector<std::atomic<int>> visits(end > begin ? end - begin : 0);
+        std::atomic<bool> chunkTooLarge{ false };
+
+        executor.For(begin, end, grainSize, [&](int chunkBegin, int chunkEnd)
+        {
+            if (chunkEnd - chunkBegin > std::max(1, grainSize))
+            {
+                chunkTooLarge = true;
+            }
+            for (int i = chunkBegin; i < chunkEnd; ++i)
+            {
+                visits[i - begin].fetch_add(1);
+            }
+        });
+
+        for (size_t i = 0; i < visits.size(); ++i)
+        {
+            ASSERT_EQ(visits[i].load(), 1) << "index " << begin + (int)i;
+        }
+        EXPECT_FALSE(chunkTooLarge) << "grain " << grainSize;
+    }
+}
+
+TEST(ParallelFor, ThreadPoolVisitsEveryIndexOnce)
+{
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.Concurrency(), 4);
+
+    ExpectCoversRangeOnce(pool, 0, 0, 1);
+    ExpectCoversRangeOnce(pool, 5, 6, 1);
+    ExpectCoversRangeOnce(pool, -7, 1000, 1);
+    ExpectCoversRangeOnce(pool, 0, 1000, 7);
+    ExpectCoversRangeOnce(pool, 0, 1000, 0);
+    ExpectCoversRangeOnce(pool, 0, 10, 100);
+}
+
+TEST(ParallelFor, SerialExecutorRunsOneChunk)
+{
+    SerialExecutor serial;
+    int calls = 0;
+    serial.For(3, 40, 4, [&](int begin, int end)
+    {
+        ++calls;
+        EXPECT_EQ(begin, 3);
+        EXPECT_EQ(end, 40);
+    });
+    EXPECT_EQ(calls, 1);
+
+    serial.For(5, 5, 1, [&](int, int) { ++calls; });
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ParallelFor, NestedCallsComplete)
+{
+    ThreadPool pool(2);
+    std::atomic<int> total{ 0 };
+
+    pool.For(0, 16, 1, [&](int outerBegin, int outerEnd)
+    {
+        for (int i = outerBegin; i < outerEnd; ++i)
+        {
+            pool.For(0, 100, 10, [&](int begin, int end)
+            {
+                total.fetch_add(end - begin);
+            });
+        }
+    });
+
+    EXPECT_EQ(total.load(), 1600);
+}
+
+TEST(ParallelFor, DefaultExecutorCanBeReplaced)
+{
+    SerialExecutor serial;
+    SetDefaultExecutor(&serial);
+    EXPECT_EQ(&GetDefaultExecutor(), &serial);
+
+    int calls = 0;
+    ParallelFor(0, 100, 1, [&](int, int) { ++calls; });
+    EXPECT_EQ(calls, 1);
+
+    SetDefaultExecutor(nullptr);
+    EXPECT_NE(&GetDefaultExecutor(), &serial);
+}
+
+TEST(ParallelFor, RowsPerTileStaysInRange)
+{
+    EXPECT_EQ(RowsPerTile(0, 1024), 1);
+    for (int rows : { 1, 7, 128, 4096 })
+    {
+        for (std::size_t bytesPerRow : { (std::size_t)1, (std::size_t)4096, (std::size_t)1 << 20 })
+        {
+            const int tile = RowsPerTile(rows, bytesPerRow);
+            EXPECT_GE(tile, 1) << rows << " rows of " << bytesPerRow;
+            EXPECT_LE(tile, rows) << rows << " rows of " << bytesPerRow;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#include "WavesStencil.h"
+#include "CpuFeatures.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Runs kernel over one interior row of a random 3-row grid and returns the new row.
+    std::vector<float> RunRow(WavesStencil::RowFn kernel, int count, unsigned seed)
+    {
+        const int stride = count + 2;
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> height(-1.0f, 1.0f);
+
+        std::vector<float> prev(3 * stride);
+        std::vector<float> curr(3 * stride);
+        for (int i = 0; i < 3 * stride; ++i)
+        {
+            prev[i] = height(rng);
+            curr[i] = height(rng);
+        }
+
+        // Same constants as the scene's 128x128 waves.
+        kernel(&prev[stride + 1], &curr[stride + 1], stride, count, -0.9941f, 1.9346f, 0.0149f);
+        return std::vector<float>(prev.begin() + stride + 1, prev.begin() + stride + 1 + count);
+    }
+
+    void ExpectMatchesScalar(WavesStencil::RowFn kernel)
+    {
+        // Every tail length of the 4- and 8-wide loops, and rows long enough to loop.
+        for (int count = 0; count <= 40; ++count)
+        {
+            const std::vector<float> expected = RunRow(WavesStencil::RowScalar, count, 7u * count + 1u);
+            const std::vector<float> actual = RunRow(kernel, count, 7u * count + 1u);
+            ASSERT_EQ(actual, expected) << "count " << count;
+        }
+        const std::vector<float> expected = RunRow(WavesStencil::RowScalar, 1021, 99u);
+        EXPECT_EQ(RunRow(kernel, 1021, 99u), expected);
+    }
+}
+
+TEST(WavesStencil, SSE2MatchesScalarBitForBit)
+{
+    ExpectMatchesScalar(WavesStencil::RowSSE2);
+}
+
+TEST(WavesStencil, AVX2MatchesScalarBitForBit)
+{
+    if (!CpuSupportsAVX2())
+    {
+        GTEST_SKIP() << "no AVX2 on this CPU";
+    }
+    ExpectMatchesScalar(WavesStencil::RowAVX2);
+}
+
+TEST(WavesStencil, SelectsWidestSupportedKernel)
+{
+    EXPECT_EQ(WavesStencil::SelectRow(), CpuSupportsAVX2() ? WavesStencil::RowAVX2 : WavesStencil::RowSSE2);
+}
@@ -0,0 +1,358 @@
+#include "Waves.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // The simulation as it was before the heights were packed into dense arrays: every
+    // cell steps on its own, in the same operation order, and the normals are recomputed
+    // over the whole interior.
+    struct ReferenceWaves
+    {
+        int M;
+        int N;
+        float Dx;
+        float K1;
+        float K2;
+        float K3;
+        std::vector<XMFLOAT3> Prev;
+        std::vector<XMFLOAT3> Curr;
+        std::vector<XMFLOAT3> Normals;
+
+        ReferenceWaves(int m, int n, float dx, float dt, float speed, float damping)
+            : M(m), N(n), Dx(dx)
+        {
+            float d = damping * dt + 2.f;
+            float e = (speed*speed)*(dt*dt) / (dx*dx);
+            K1 = (damping*dt - 2.0f) / d;
+            K2 = (4.0f - 8.0f*e) / d;
+            K3 = (2.0f*e) / d;
+
+            float halfWidth = (n - 1)*dx*0.5f;
+            float halfDepth = (m - 1)*dx*0.5f;
+            for (int i = 0; i < m; ++i)
+            {
+                for (int j = 0; j < n; ++j)
+                {
+                    Prev.emplace_back(-halfWidth + j*dx, 0.0f, halfDepth - i*dx);
+                }
+            }
+            Curr = Prev;
+            Normals.assign(m*n, XMFLOAT3(0.0f, 1.0f, 0.0f));
+        }
+
+        void Step()
+        {
+            for (int i = 1; i < M-1; ++i)
+            {
+                for (int j = 1; j < N-1; ++j)
+                {
+                    Prev[i*N+j].y =
+                        K1*Prev[i*N+j].y +
+                        K2*Curr[i*N+j].y +
+                        K3*(Curr[(i+1)*N+j].y +
+                            Curr[(i-1)*N+j].y +
+                            Curr[i*N+j+1].y +
+                            Curr[i*N+j-1].y);
+                }
+            }
+            std::swap(Prev, Curr);
+
+            for (int i = 1; i < M-1; ++i)
+            {
+                for (int j = 1; j < N-1; ++j)
+                {
+                    float l = Curr[i*N+j-1].y;
+                    float r = Curr[i*N+j+1].y;
+                    float t = Curr[(i-1)*N+j].y;
+                    float b = Curr[(i+1)*N+j].y;
+                    XMFLOAT3 normal(-r+l, 2.0f*Dx, b-t);
+                    XMStoreFloat3(&Normals[i*N+j], XMVector3Normalize(XMLoadFloat3(&normal)));
+                }
+            }
+        }
+
+        void Disturb(int i, int j, float magnitude)
+        {
+            float halfMag = 0.5f*magnitude;
+            Curr[i*N+j].y     += magnitude;
+            Curr[i*N+j+1].y   += halfMag;
+            Curr[i*N+j-1].y   += halfMag;
+            Curr[(i+1)*N+j].y += halfMag;
+            Curr[(i-1)*N+j].y += halfMag;
+        }
+    };
+
+    void ExpectMatchesReference(const Waves& waves, const ReferenceWaves& reference, int stepCount)
+    {
+        for (int i = 0; i < waves.VertexCount(); ++i)
+        {
+            const XMFLOAT3 p = waves.Position(i);
+            ASSERT_FLOAT_EQ(p.x, reference.Curr[i].x) << "vertex " << i << " after " << stepCount << " steps";
+            ASSERT_FLOAT_EQ(p.y, reference.Curr[i].y) << "vertex " << i << " after " << stepCount << " steps";
+            ASSERT_FLOAT_EQ(p.z, reference.Curr[i].z) << "vertex " << i << " after " << stepCount << " steps";
+            ASSERT_EQ(waves.Height(i), p.y);
+
+            const XMFLOAT3& n = waves.Normal(i);
+            ASSERT_NEAR(n.x, reference.Normals[i].x, 1e-5f) << "vertex " << i << " after " << stepCount << " steps";
+            ASSERT_NEAR(n.y, reference.Normals[i].y, 1e-5f) << "vertex " << i << " after " << stepCount << " steps";
+            ASSERT_NEAR(n.z, reference.Normals[i].z, 1e-5f) << "vertex " << i << " after " << stepCount << " steps";
+        }
+    }
+}
+
+TEST(Waves, DenseHeightsMatchReferenceSimulation)
+{
+    // Odd sizes leave remainders after every vector width; 128x128 spans several tiles.
+    const int sizes[][2] = { { 37, 29 }, { 5, 70 }, { 128, 128 } };
+    for (const auto& size : sizes)
+    {
+        const int m = size[0];
+        const int n = size[1];
+        Waves waves(m, n, 1.0f, 0.03f, 4.0f, 0.2f);
+        ReferenceWaves reference(m, n, 1.0f, 0.03f, 4.0f, 0.2f);
+
+        waves.Disturb(m / 2, n / 2, 0.5f);
+        reference.Disturb(m / 2, n / 2, 0.5f);
+        waves.Disturb(2, n - 3, -0.3f);
+        reference.Disturb(2, n - 3, -0.3f);
+
+        // Single steps, then temporally blocked ones of every size up to and past the block.
+        int stepCount = 0;
+        for (int substeps : { 1, 1, 2, 3, 4, 5, 9 })
+        {
+            waves.Step(substeps);
+            for (int s = 0; s < substeps; ++s)
+            {
+                reference.Step();
+            }
+            stepCount += substeps;
+            ExpectMatchesReference(waves, reference, stepCount);
+        }
+    }
+}
+
+TEST(Waves, UpdateRunsFixedSteps)
+{
+    Waves waves(40, 40, 1.0f, 0.03f, 4.0f, 0.2f);
+    ReferenceWaves reference(40, 40, 1.0f, 0.03f, 4.0f, 0.2f);
+    waves.Disturb(20, 20, 1.0f);
+    reference.Disturb(20, 20, 1.0f);
+
+    // 0.05 s per frame is one step and 0.02 s left over, which makes the second frame two steps.
+    waves.Update(0.05f);
+    reference.Step();
+    ExpectMatchesReference(waves, reference, 1);
+
+    waves.Update(0.05f);
+    reference.Step();
+    reference.Step();
+    ExpectMatchesReference(waves, reference, 3);
+
+    // A long stall is cut to MaxSubsteps steps and the rest is dropped.
+    waves.Update(10.0f);
+    for (int s = 0; s < waves.MaxSubsteps(); ++s)
+    {
+        reference.Step();
+    }
+    ExpectMatchesReference(waves, reference, 3 + waves.MaxSubsteps());
+}
+
+TEST(Waves, WritesVerticesOfAllRows)
+{
+    struct TestVertex
+    {
+        XMFLOAT3 Pos;
+        XMFLOAT3 Normal;
+        XMFLOAT2 TexC;
+    };
+
+    Waves waves(33, 47, 0.5f, 0.03f, 4.0f, 0.2f);
+    waves.Disturb(10, 10, 1.0f);
+    waves.Step(3);
+
+    std::vector<TestVertex> vertices(waves.VertexCount());
+    waves.WriteVertices(vertices.data());
+
+    for (int i = 0; i < waves.VertexCount(); ++i)
+    {
+        const XMFLOAT3 p = waves.Position(i);
+        ASSERT_EQ(vertices[i].Pos.x, p.x);
+        ASSERT_EQ(vertices[i].Pos.y, p.y);
+        ASSERT_EQ(vertices[i].Pos.z, p.z);
+        ASSERT_EQ(vertices[i].Normal.y, waves.Normal(i).y);
+        ASSERT_FLOAT_EQ(vertices[i].TexC.x, 0.5f + p.x / waves.Width());
+        ASSERT_FLOAT_EQ(vertices[i].TexC.y, 0.5f + p.z / waves.Depth());
+    }
+}
+
+namespace
+{
+    using RowRanges = std::vector<std::pair<int, int>>;
+
+    RowRanges DirtyRows(const Waves& waves, std::uint64_t sinceVersion)
+    {
+        RowRanges rowRanges;
+        waves.GetDirtyRows(sinceVersion, rowRanges);
+        return rowRanges;
+    }
+
+    // Largest height change of each row's interior since heights was taken, the drift
+    // Step adds up per row.
+    std::vector<float> RowDrift(const Waves& waves, const std::vector<float>& heights)
+    {
+        const int n = waves.ColumnCount();
+        std::vector<float> drift(waves.RowCount(), 0.0f);
+        for (int i = 1; i < waves.RowCount() - 1; ++i)
+        {
+            for (int j = 1; j < n - 1; ++j)
+            {
+                drift[i] = std::max(drift[i], std::fabs(waves.Height(i*n + j) - heights[i*n + j]));
+            }
+        }
+        return drift;
+    }
+
+    std::vector<float> Heights(const Waves& waves)
+    {
+        std::vector<float> heights(waves.VertexCount());
+        for (int i = 0; i < waves.VertexCount(); ++i)
+        {
+            heights[i] = waves.Height(i);
+        }
+        return heights;
+    }
+}
+
+TEST(Waves, FreshGridIsDirtyEverywhere)
+{
+    Waves waves(40, 32, 1.0f, 0.03f, 4.0f, 0.2f);
+    EXPECT_GT(waves.Version(), 0u);
+    EXPECT_EQ(DirtyRows(waves, 0), (RowRanges{ { 0, 40 } }));
+    EXPECT_TRUE(DirtyRows(waves, waves.Version()).empty());
+}
+
+TEST(Waves, StillGridReportsNothing)
+{
+    Waves waves(40, 32, 1.0f, 0.03f, 4.0f, 0.2f);
+    const std::uint64_t version = waves.Version();
+    waves.Step(1);
+    waves.Step(4);
+    EXPECT_TRUE(DirtyRows(waves, version).empty());
+}
+
+TEST(Waves, DisturbDirtiesItsRowAndNeighbours)
+{
+    Waves waves(40, 32, 1.0f, 0.03f, 4.0f, 0.2f);
+    const std::uint64_t version = waves.Version();
+    waves.Disturb(12, 7, 0.25f);
+    EXPECT_GT(waves.Version(), version);
+    EXPECT_EQ(DirtyRows(waves, version), (RowRanges{ { 11, 14 } }));
+}
+
+TEST(Waves, RowsBelowTheDirtyThresholdWaitUntilTheirDriftAddsUp)
+{
+    Waves waves(40, 32, 1.0f, 0.03f, 4.0f, 0.2f);
+    const float threshold = 0.5f;
+    waves.SetDirtyThreshold(threshold);
+    EXPECT_EQ(waves.DirtyThreshold(), threshold);
+
+    // Disturb reports its rows right away and counts the magnitude towards their drift.
+    const float magnitude = 0.2f;
+    waves.Disturb(20, 16, magnitude);
+    std::vector<float> drift(waves.RowCount(), 0.0f);
+    drift[19] = drift[20] = drift[21] = magnitude;
+
+    // Replay the drift sums Step keeps and check each step reports exactly the rows whose
+    // sum passed the threshold, and their neighbours.
+    int reportedSteps = 0;
+    int firstReportedStep = -1;
+    for (int step = 0; step < 60; ++step)
+    {
+        const std::vector<float> heights = Heights(waves);
+        const std::uint64_t version = waves.Version();
+        waves.Step(1);
+
+        const std::vector<float> stepDrift = RowDrift(waves, heights);
+        std::vector<bool> expectedDirty(waves.RowCount(), false);
+        for (int i = 1; i < waves.RowCount() - 1; ++i)
+        {
+            drift[i] += stepDrift[i];
+            if (drift[i] > threshold)
+            {
+                drift[i] = 0.0f;
+                expectedDirty[i - 1] = expectedDirty[i] = expectedDirty[i + 1] = true;
+            }
+        }
+
+        std::vector<bool> dirty(waves.RowCount(), false);
+        for (const auto& range : DirtyRows(waves, version))
+        {
+            std::fill(dirty.begin() + range.first, dirty.begin() + range.second, true);
+        }
+        ASSERT_EQ(dirty, expectedDirty) << "step " << step;
+        if (std::count(dirty.begin(), dirty.end(), true) > 0)
+        {
+            ++reportedSteps;
+            firstReportedStep = firstReportedStep < 0 ? step : firstReportedStep;
+        }
+    }
+
+    // The disturbed rows start under the threshold and take a few steps of movement to
+    // pass it; after that, most steps still report nothing.
+    EXPECT_GT(firstReportedStep, 0);
+    EXPECT_LT(reportedSteps, 30) << "first reported at step " << firstReportedStep;
+}
+
+TEST(Waves, OlderConsumersGetTheUnionOfChanges)
+{
+    Waves waves(40, 32, 1.0f, 0.03f, 4.0f, 0.2f);
+    const std::uint64_t v0 = waves.Version();
+    waves.Disturb(5, 5, 0.25f);
+    const std::uint64_t v1 = waves.Version();
+    waves.Disturb(30, 10, 0.25f);
+    waves.Disturb(7, 20, 0.25f);
+
+    EXPECT_EQ(DirtyRows(waves, v0), (RowRanges{ { 4, 9 }, { 29, 32 } }));
+    EXPECT_EQ(DirtyRows(waves, v1), (RowRanges{ { 6, 9 }, { 29, 32 } }));
+    EXPECT_TRUE(DirtyRows(waves, waves.Version()).empty());
+}
+
+TEST(Waves, EachFrameResourceCatchesUpOnTheFramesItMissed)
+{
+    // The pattern UpdateWaves follows: frame resource f % 3 uploads the rows changed since
+    // its own version, then records the current one.
+    const int frameResourceCount = 3;
+    Waves waves(64, 32, 1.0f, 0.03f, 4.0f, 0.2f);
+    std::vector<std::uint64_t> versions(frameResourceCount, 0);
+
+    auto DisturbedRows = [](int frame) { return std::make_pair(4 + 8 * frame - 1, 4 + 8 * frame + 2); };
+
+    for (int frame = 0; frame < 7; ++frame)
+    {
+        waves.Disturb(4 + 8 * frame, 10, 0.25f);
+
+        std::uint64_t& version = versions[frame % frameResourceCount];
+        const RowRanges rows = DirtyRows(waves, version);
+        version = waves.Version();
+
+        if (frame < frameResourceCount)
+        {
+            // First use of this frame resource: its buffer has never been written.
+            EXPECT_EQ(rows, (RowRanges{ { 0, 64 } })) << "frame " << frame;
+        }
+        else
+        {
+            const RowRanges expected = { DisturbedRows(frame - 2), DisturbedRows(frame - 1), DisturbedRows(frame) };
+            EXPECT_EQ(rows, expected) << "frame " << frame;
+        }
+    }
+}
@@ -2,6 +2,7 @@
 
 #include "d3dUtil.h"
 #include "DDSTextureLoader12.h"
+#include "Profiler.h"
 
 FTextureManager::FTextureManager(ID3D12Device* InDevice, ID3D12GraphicsCommandList* InCmdList)
 	: Device(InDevice), CmdList(InCmdList) 
@@ -10,6 +11,8 @@ FTextureManager::FTextureManager(ID3D12Device* InDevice, ID3D12GraphicsCommandLi
 
 void FTextureManager::LoadTexture(const std::string& InTextureName, const std::wstring& InFileName)
 {
+	PROFILE_ZONE("LoadTexture");
+
 	auto NewTexture = std::make_shared<Texture>();
 	NewTexture->Name = InTextureName;
 	NewTexture->Filename = InFileName;
@@ -3,6 +3,7 @@
 #include "d3d12.h"
 #include "d3dx12.h"
 #include "wrl.h"
+#include "StreamCopy.h"
 
 // CPU에서 GPU로 데이터를 복사하기위한 업로드 힙을 생성하고 관리하는 Template Class.
 template<typename T>
@@ -10,6 +11,10 @@ class UploadBuffer
 {
 public:
     UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer);
+
+    // GPU 리소스 없이 시스템 메모리만 사용하는 버퍼. 헤드리스 벤치마크처럼 디바이스가 없을 때 업로드 힙 대신 쓴다.
+    // Resource()는 nullptr을 반환한다.
+    UploadBuffer(UINT elementCount, bool isConstantBuffer);
     UploadBuffer(const UploadBuffer& rhs) = delete;
     UploadBuffer& operator=(const UploadBuffer& rhs) = delete;
 
@@ -19,6 +24,13 @@ public:
 
     void CopyData(int elementIndex, const T& data);
 
+    // count개의 요소를 순차적으로 한 번에 쓴다. 상수 버퍼가 아니면 non-temporal store 로 연속 복사.
+    void CopyData(int firstElement, const T* data, int count);
+
+    // 매핑된 메모리에 직접 쓰기 위한 포인터. 요소가 빈틈없이 붙어 있어야 하므로 상수 버퍼에는 쓸 수 없다.
+    // Write-combined 메모리이므로 읽지 말고 앞에서부터 순서대로 쓸 것.
+    T* MappedData(int firstElement = 0);
+
 private:
     // 실제 GPU 리소스를 가리키는 포인터
     Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
@@ -26,6 +38,9 @@ private:
     // GPU 메모리를 CPU에서 접근할 수 있도록 매핑한 포인터
     BYTE* mMappedData = nullptr;
 
+    // 디바이스 없이 생성된 경우 mMappedData가 가리키는 시스템 메모리
+    std::vector<BYTE> mCpuBacking;
+
     // 각 요소의 크기(상수 버퍼일 경우 256바이트 단위로 정렬)
     UINT mElementByteSize = 0;
 
@@ -64,6 +79,21 @@ inline UploadBuffer<T>::UploadBuffer(ID3D12Device* device, UINT elementCount, bo
     ThrowIfFailed(mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));  
 }
 
+template<typename T>
+inline UploadBuffer<T>::UploadBuffer(UINT elementCount, bool isConstantBuffer)
+    : mIsConstantBuffer(isConstantBuffer)
+{
+    mElementByteSize = sizeof(T);
+
+    if (isConstantBuffer)
+    {
+        mElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
+    }
+
+    mCpuBacking.resize((size_t)mElementByteSize * elementCount);
+    mMappedData = mCpuBacking.data();
+}
+
 template<typename T>
 inline UploadBuffer<T>::~UploadBuffer()
 {
@@ -86,3 +116,25 @@ inline void UploadBuffer<T>::CopyData(int elementIndex, const T& data)
 {
     memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
 }
+
+template<typename T>
+inline void UploadBuffer<T>::CopyData(int firstElement, const T* data, int count)
+{
+    if (!mIsConstantBuffer)
+    {
+        StreamCopy(&mMappedData[firstElement * mElementByteSize], data, (size_t)count * sizeof(T));
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        memcpy(&mMappedData[(firstElement + i) * mElementByteSize], &data[i], sizeof(T));
+    }
+}
+
+template<typename T>
+inline T* UploadBuffer<T>::MappedData(int firstElement)
+{
+    assert(!mIsConstantBuffer);
+    return reinterpret_cast<T*>(&mMappedData[firstElement * mElementByteSize]);
+}
@@ -1,10 +1,94 @@
 ﻿#include "Waves.h"
 
 #include "Waves.h"
-#include <ppl.h>
+#include "WavesStencil.h"
+#include "ParallelFor.h"
+#include "Profiler.h"
+#include "CpuFeatures.h"
 #include <algorithm>
 #include <vector>
 #include <cassert>
+#include <cmath>
+#include <immintrin.h>
+
+void WavesStencil::RowScalar(float* prev, const float* curr, int stride, int count, float k1, float k2, float k3)
+{
+    for (int j = 0; j < count; ++j)
+    {
+        prev[j] =
+            k1*prev[j] +
+            k2*curr[j] +
+            k3*(curr[j + stride] +
+                curr[j - stride] +
+                curr[j + 1] +
+                curr[j - 1]);
+    }
+}
+
+void WavesStencil::RowSSE2(float* prev, const float* curr, int stride, int count, float k1, float k2, float k3)
+{
+    const __m128 vK1 = _mm_set1_ps(k1);
+    const __m128 vK2 = _mm_set1_ps(k2);
+    const __m128 vK3 = _mm_set1_ps(k3);
+
+    int j = 0;
+    for (; j + 4 <= count; j += 4)
+    {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(curr + j + stride), _mm_loadu_ps(curr + j - stride));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(curr + j + 1));
+        sum = _mm_add_ps(sum, _mm_loadu_ps(curr + j - 1));
+
+        __m128 h = _mm_add_ps(_mm_mul_ps(vK1, _mm_loadu_ps(prev + j)), _mm_mul_ps(vK2, _mm_loadu_ps(curr + j)));
+        h = _mm_add_ps(h, _mm_mul_ps(vK3, sum));
+        _mm_storeu_ps(prev + j, h);
+    }
+
+    RowScalar(prev + j, curr + j, stride, count - j, k1, k2, k3);
+}
+
+WE_TARGET_AVX2 void WavesStencil::RowAVX2(float* prev, const float* curr, int stride, int count, float k1, float k2, float k3)
+{
+    const __m256 vK1 = _mm256_set1_ps(k1);
+    const __m256 vK2 = _mm256_set1_ps(k2);
+    const __m256 vK3 = _mm256_set1_ps(k3);
+
+    int j = 0;
+    for (; j + 8 <= count; j += 8)
+    {
+        __m256 sum = _mm256_add_ps(_mm256_loadu_ps(curr + j + stride), _mm256_loadu_ps(curr + j - stride));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(curr + j + 1));
+        sum = _mm256_add_ps(sum, _mm256_loadu_ps(curr + j - 1));
+
+        __m256 h = _mm256_add_ps(_mm256_mul_ps(vK1, _mm256_loadu_ps(prev + j)), _mm256_mul_ps(vK2, _mm256_loadu_ps(curr + j)));
+        h = _mm256_add_ps(h, _mm256_mul_ps(vK3, sum));
+        _mm256_storeu_ps(prev + j, h);
+    }
+
+    // Avoid AVX-SSE transition penalties in the tail and after returning.
+    _mm256_zeroupper();
+    RowScalar(prev + j, curr + j, stride, count - j, k1, k2, k3);
+}
+
+// SSE2 is the baseline on every platform we build for (DirectXMath requires it).
+WavesStencil::RowFn WavesStencil::SelectRow()
+{
+    return CpuSupportsAVX2() ? RowAVX2 : RowSSE2;
+}
+
+namespace
+{
+    const WavesStencil::RowFn StencilRow = WavesStencil::SelectRow();
+
+    float MaxAbsDifference(const float* a, const float* b, int count)
+    {
+        float result = 0.0f;
+        for (int j = 0; j < count; ++j)
+        {
+            result = std::max(result, std::fabs(a[j] - b[j]));
+        }
+        return result;
+    }
+}
 
 Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
 {
@@ -23,28 +107,19 @@ Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
     mK2 = (4.0f - 8.0f*e) / d;
     mK3 = (2.0f*e) / d;
 
-    mPrevSolution.resize(m*n);
-    mCurrSolution.resize(m*n);
-    mNormals.resize(m*n);
-    mTangentX.resize(m*n);
+    mPrevSolution.assign(m*n, 0.0f);
+    mCurrSolution.assign(m*n, 0.0f);
+    mNormals.assign(m*n, DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f));
 
-    // Generate grid vertices in system memory.
+    // Every row starts out dirty so each upload buffer gets written once.
+    mVersion = 1;
+    mRowVersion.assign(m, mVersion);
+    mRowDrift.assign(m, 0.0f);
+    mTangentX.assign(m*n, DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f));
 
-    float halfWidth = (n - 1)*dx*0.5f;
-    float halfDepth = (m - 1)*dx*0.5f;
-    for(int i = 0; i < m; ++i)
-    {
-        float z = halfDepth - i*dx;
-        for(int j = 0; j < n; ++j)
-        {
-            float x = -halfWidth + j*dx;
-
-            mPrevSolution[i*n + j] = DirectX::XMFLOAT3(x, 0.0f, z);
-            mCurrSolution[i*n + j] = DirectX::XMFLOAT3(x, 0.0f, z);
-            mNormals[i*n + j] = DirectX::XMFLOAT3(0.0f, 1.0f, 0.0f);
-            mTangentX[i*n + j] = DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f);
-        }
-    }
+    // Grid x/z are not stored; Position() rebuilds them from these.
+    mHalfWidth = (n - 1)*dx*0.5f;
+    mHalfDepth = (m - 1)*dx*0.5f;
 }
 
 int Waves::RowCount() const
@@ -79,85 +154,278 @@ float Waves::Depth() const
 
 void Waves::Update(float dt)
 {
-    static float t = 0;
-
-	// Accumulate time.
-	t += dt;
-
-	// Only update the simulation at the specified time step.
-	if( t >= mTimeStep )
-	{
-		// Only update interior points; we use zero boundary conditions.
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-		//for(int i = 1; i < mNumRows-1; ++i)
-		{
-			for(int j = 1; j < mNumCols-1; ++j)
-			{
-				// After this update we will be discarding the old previous
-				// buffer, so overwrite that buffer with the new update.
-				// Note how we can do this inplace (read/write to same element) 
-				// because we won't need prev_ij again and the assignment happens last.
-
-				// Note j indexes x and i indexes z: h(x_j, z_i, t_k)
-				// Moreover, our +z axis goes "down"; this is just to 
-				// keep consistent with our row indices going down.
-
-				mPrevSolution[i*mNumCols+j].y = 
-					mK1*mPrevSolution[i*mNumCols+j].y +
-					mK2*mCurrSolution[i*mNumCols+j].y +
-					mK3*(mCurrSolution[(i+1)*mNumCols+j].y + 
-					     mCurrSolution[(i-1)*mNumCols+j].y + 
-					     mCurrSolution[i*mNumCols+j+1].y + 
-						 mCurrSolution[i*mNumCols+j-1].y);
-			}
-		});
-
-		// We just overwrote the previous buffer with the new data, so
-		// this data needs to become the current solution and the old
-		// current solution becomes the new previous solution.
-		std::swap(mPrevSolution, mCurrSolution);
-
-		t = 0.0f; // reset time
-
-		//
-		// Compute normals using finite difference scheme.
-		//
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-		//for(int i = 1; i < mNumRows - 1; ++i)
-		{
-			for(int j = 1; j < mNumCols-1; ++j)
-			{
-				float l = mCurrSolution[i*mNumCols+j-1].y;
-				float r = mCurrSolution[i*mNumCols+j+1].y;
-				float t = mCurrSolution[(i-1)*mNumCols+j].y;
-				float b = mCurrSolution[(i+1)*mNumCols+j].y;
-				mNormals[i*mNumCols+j].x = -r+l;
-				mNormals[i*mNumCols+j].y = 2.0f*mSpatialStep;
-				mNormals[i*mNumCols+j].z = b-t;
-
-				DirectX::XMVECTOR n = DirectX::XMVector3Normalize(XMLoadFloat3(&mNormals[i*mNumCols+j]));
-				XMStoreFloat3(&mNormals[i*mNumCols+j], n);
-
-				mTangentX[i*mNumCols+j] = DirectX::XMFLOAT3(2.0f*mSpatialStep, r-l, 0.0f);
-				DirectX::XMVECTOR T = DirectX::XMVector3Normalize(XMLoadFloat3(&mTangentX[i*mNumCols+j]));
-				XMStoreFloat3(&mTangentX[i*mNumCols+j], T);
-			}
-		});
-	}
+    PROFILE_ZONE("Waves::Update");
+
+    // Accumulate time.
+    mAccumulator += dt;
+
+    // Run as many fixed steps as the accumulated time covers, so the simulation speed
+    // doesn't depend on the frame rate.
+    int substeps = (int)(mAccumulator / mTimeStep);
+    mAccumulator -= substeps * mTimeStep;
+
+    // Under load, cap the work per frame and drop the time we can't catch up on
+    // instead of falling further behind every frame.
+    if (substeps > mMaxSubsteps)
+    {
+        substeps = mMaxSubsteps;
+        mAccumulator = 0.0f;
+    }
+
+    if (substeps > 0)
+    {
+        Step(substeps);
+    }
+}
+
+void Waves::SetMaxSubsteps(int maxSubsteps)
+{
+    mMaxSubsteps = std::max(1, maxSubsteps);
+}
+
+void Waves::Step(int substeps)
+{
+    PROFILE_ZONE("Waves::Step");
+
+    // Only update interior points; we use zero boundary conditions, so rows 0 and
+    // mNumRows-1 (and columns 0 and mNumCols-1) never change.
+    //
+    // The grid is processed in tiles of whole rows.  Each tile updates its heights and
+    // then immediately computes normals/tangents for the rows it can, while the heights
+    // are still in cache.  The first and last row of a tile need the neighbouring tiles'
+    // new heights, so those are finished in a short second pass.
+    const int interiorRows = mNumRows - 2;
+    if (interiorRows <= 0 || substeps <= 0)
+    {
+        return;
+    }
+
+    const size_t bytesPerRow = mNumCols * (2 * sizeof(float) + 2 * sizeof(DirectX::XMFLOAT3));
+
+    while (substeps > 0)
+    {
+        const int k = std::min(substeps, MaxTemporalBlock);
+        substeps -= k;
+        const bool computeNormals = (substeps == 0);
+
+        // Tiles advanced k steps at once recompute a k-row halo on each side, so keep
+        // them tall enough for that to stay cheap.
+        int tileRows = RowsPerTile(interiorRows, bytesPerRow);
+        if (k > 1)
+        {
+            tileRows = std::max(tileRows, 4 * k);
+        }
+        const int tileCount = (interiorRows + tileRows - 1) / tileRows;
+
+        if (k == 1)
+        {
+            ParallelFor(0, tileCount, 1, [this, tileRows, computeNormals](int tileBegin, int tileEnd)
+            {
+                for (int tile = tileBegin; tile < tileEnd; ++tile)
+                {
+                    const int rowBegin = 1 + tile * tileRows;
+                    const int rowEnd = std::min(rowBegin + tileRows, mNumRows - 1);
+
+                    // After this update we will be discarding the old previous
+                    // buffer, so overwrite that buffer with the new update.
+                    // Note how we can do this inplace (read/write to same element) 
+                    // because we won't need prev_ij again and the assignment happens last.
+
+                    // Note j indexes x and i indexes z: h(x_j, z_i, t_k)
+                    // Moreover, our +z axis goes "down"; this is just to 
+                    // keep consistent with our row indices going down.
+
+                    // Row i, columns 1..mNumCols-2, 4 or 8 cells per instruction.
+                    for (int i = rowBegin; i < rowEnd; ++i)
+                    {
+                        StencilRow(&mPrevSolution[i*mNumCols+1], &mCurrSolution[i*mNumCols+1],
+                            mNumCols, mNumCols - 2, mK1, mK2, mK3);
+
+                        // The row is still in cache; record how far it moved.
+                        mRowDrift[i] += MaxAbsDifference(&mPrevSolution[i*mNumCols+1], &mCurrSolution[i*mNumCols+1], mNumCols - 2);
+                    }
+
+                    if (computeNormals)
+                    {
+                        ComputeNormals(mPrevSolution.data(), rowBegin + 1, rowEnd - 1);
+                    }
+                }
+            });
+
+            // We just overwrote the previous buffer with the new data, so
+            // this data needs to become the current solution and the old
+            // current solution becomes the new previous solution.
+            std::swap(mPrevSolution, mCurrSolution);
+        }
+        else
+        {
+            // Temporal blocking: each tile copies its rows plus a k-row halo into scratch,
+            // advances k steps there (the valid region shrinks by a row per step) and writes
+            // its own rows of the last two levels to separate output buffers, since the
+            // neighbouring tiles still read the inputs.
+            if (mNextPrev.size() != mPrevSolution.size())
+            {
+                // Copies also give the outputs their (fixed) boundary rows.
+                mNextPrev = mPrevSolution;
+                mNextCurr = mCurrSolution;
+            }
+
+            ParallelFor(0, tileCount, 1, [this, k, tileRows, computeNormals](int tileBegin, int tileEnd)
+            {
+                thread_local std::vector<float> scratchPrev;
+                thread_local std::vector<float> scratchCurr;
+
+                for (int tile = tileBegin; tile < tileEnd; ++tile)
+                {
+                    const int rowBegin = 1 + tile * tileRows;
+                    const int rowEnd = std::min(rowBegin + tileRows, mNumRows - 1);
+                    const int lo = std::max(0, rowBegin - k);
+                    const int hi = std::min(mNumRows, rowEnd + k);
+
+                    scratchPrev.assign(mPrevSolution.begin() + lo*mNumCols, mPrevSolution.begin() + hi*mNumCols);
+                    scratchCurr.assign(mCurrSolution.begin() + lo*mNumCols, mCurrSolution.begin() + hi*mNumCols);
+
+                    for (int s = 0; s < k; ++s)
+                    {
+                        // Rows next to the grid boundary stay valid; halo rows go stale from the outside in.
+                        const int updateBegin = (lo == 0) ? 1 : lo + s + 1;
+                        const int updateEnd = (hi == mNumRows) ? mNumRows - 1 : hi - s - 1;
+                        for (int i = updateBegin; i < updateEnd; ++i)
+                        {
+                            StencilRow(&scratchPrev[(i-lo)*mNumCols+1], &scratchCurr[(i-lo)*mNumCols+1],
+                                mNumCols, mNumCols - 2, mK1, mK2, mK3);
+                        }
+                        std::swap(scratchPrev, scratchCurr);
+                    }
+
+                    for (int i = rowBegin; i < rowEnd; ++i)
+                    {
+                        mRowDrift[i] += MaxAbsDifference(&scratchCurr[(i-lo)*mNumCols+1], &mCurrSolution[i*mNumCols+1], mNumCols - 2);
+                    }
+
+                    std::copy(scratchPrev.begin() + (rowBegin-lo)*mNumCols, scratchPrev.begin() + (rowEnd-lo)*mNumCols,
+                        mNextPrev.begin() + rowBegin*mNumCols);
+                    std::copy(scratchCurr.begin() + (rowBegin-lo)*mNumCols, scratchCurr.begin() + (rowEnd-lo)*mNumCols,
+                        mNextCurr.begin() + rowBegin*mNumCols);
+
+                    if (computeNormals)
+                    {
+                        ComputeNormals(mNextCurr.data(), rowBegin + 1, rowEnd - 1);
+                    }
+                }
+            });
+
+            std::swap(mPrevSolution, mNextPrev);
+            std::swap(mCurrSolution, mNextCurr);
+        }
+
+        if (computeNormals)
+        {
+            // Finish the first and last row of every tile now that all heights are final.
+            ParallelFor(0, tileCount, RowsPerTile(tileCount, 2 * bytesPerRow), [this, tileRows](int tileBegin, int tileEnd)
+            {
+                for (int tile = tileBegin; tile < tileEnd; ++tile)
+                {
+                    const int rowBegin = 1 + tile * tileRows;
+                    const int rowEnd = std::min(rowBegin + tileRows, mNumRows - 1);
+
+                    ComputeNormals(mCurrSolution.data(), rowBegin, rowBegin + 1);
+                    if (rowEnd - 1 > rowBegin)
+                    {
+                        ComputeNormals(mCurrSolution.data(), rowEnd - 1, rowEnd);
+                    }
+                }
+            });
+        }
+    }
+
+    // A row whose heights drifted past the threshold since it was last marked changes its
+    // own vertices and the normals of the rows next to it.  Summing the drift bounds how far
+    // an un-uploaded row can lag behind the simulation.
+    ++mVersion;
+    for (int i = 1; i < mNumRows - 1; ++i)
+    {
+        if (mRowDrift[i] > mDirtyThreshold)
+        {
+            mRowDrift[i] = 0.0f;
+            mRowVersion[i-1] = mVersion;
+            mRowVersion[i] = mVersion;
+            mRowVersion[i+1] = mVersion;
+        }
+    }
+}
+
+void Waves::SetDirtyThreshold(float threshold)
+{
+    mDirtyThreshold = std::max(0.0f, threshold);
+}
+
+void Waves::GetDirtyRows(std::uint64_t sinceVersion, std::vector<std::pair<int, int>>& rowRanges) const
+{
+    for (int i = 0; i < mNumRows; )
+    {
+        if (mRowVersion[i] <= sinceVersion)
+        {
+            ++i;
+            continue;
+        }
+
+        const int rowBegin = i;
+        while (i < mNumRows && mRowVersion[i] > sinceVersion)
+        {
+            ++i;
+        }
+        rowRanges.emplace_back(rowBegin, i);
+    }
+}
+
+void Waves::ComputeNormals(const float* heights, int rowBegin, int rowEnd)
+{
+    //
+    // Compute normals using finite difference scheme.
+    //
+    for(int i = rowBegin; i < rowEnd; ++i)
+    {
+        for(int j = 1; j < mNumCols-1; ++j)
+        {
+            float l = heights[i*mNumCols+j-1];
+            float r = heights[i*mNumCols+j+1];
+            float t = heights[(i-1)*mNumCols+j];
+            float b = heights[(i+1)*mNumCols+j];
+            mNormals[i*mNumCols+j].x = -r+l;
+            mNormals[i*mNumCols+j].y = 2.0f*mSpatialStep;
+            mNormals[i*mNumCols+j].z = b-t;
+
+            DirectX::XMVECTOR n = DirectX::XMVector3Normalize(XMLoadFloat3(&mNormals[i*mNumCols+j]));
+            XMStoreFloat3(&mNormals[i*mNumCols+j], n);
+
+            mTangentX[i*mNumCols+j] = DirectX::XMFLOAT3(2.0f*mSpatialStep, r-l, 0.0f);
+            DirectX::XMVECTOR T = DirectX::XMVector3Normalize(XMLoadFloat3(&mTangentX[i*mNumCols+j]));
+            XMStoreFloat3(&mTangentX[i*mNumCols+j], T);
+        }
+    }
 }
 
 void Waves::Disturb(int i, int j, float magnitude)
 {
-	// Don't disturb boundaries.
-	assert(i > 1 && i < mNumRows-2);
-	assert(j > 1 && j < mNumCols-2);
+    // Don't disturb boundaries.
+    assert(i > 1 && i < mNumRows-2);
+    assert(j > 1 && j < mNumCols-2);
 
-	float halfMag = 0.5f*magnitude;
+    float halfMag = 0.5f*magnitude;
 
-	// Disturb the ijth vertex height and its neighbors.
-	mCurrSolution[i*mNumCols+j].y     += magnitude;
-	mCurrSolution[i*mNumCols+j+1].y   += halfMag;
-	mCurrSolution[i*mNumCols+j-1].y   += halfMag;
-	mCurrSolution[(i+1)*mNumCols+j].y += halfMag;
-	mCurrSolution[(i-1)*mNumCols+j].y += halfMag;
+    // Disturb the ijth vertex height and its neighbors.
+    mCurrSolution[i*mNumCols+j]     += magnitude;
+    mCurrSolution[i*mNumCols+j+1]   += halfMag;
+    mCurrSolution[i*mNumCols+j-1]   += halfMag;
+    mCurrSolution[(i+1)*mNumCols+j] += halfMag;
+    mCurrSolution[(i-1)*mNumCols+j] += halfMag;
+
+    // The heights show up right away; the next step also refreshes the normals around them.
+    ++mVersion;
+    for (int row = i-1; row <= i+1; ++row)
+    {
+        mRowVersion[row] = mVersion;
+        mRowDrift[row] += std::fabs(magnitude);
+    }
 }
@@ -4,7 +4,11 @@
 #define WAVES_H
 
 #include <vector>
+#include <utility>
+#include <cstdint>
 #include <DirectXMath.h>
+#include "ParallelFor.h"
+#include "StreamCopy.h"
 
 class Waves
 {
@@ -21,14 +25,53 @@ public:
     float Width() const;
     float Depth() const;
 
-    const DirectX::XMFLOAT3& Position(int i) const {return mCurrSolution[i]; }
+    // Only heights are simulated; x and z follow from the grid index.
+    DirectX::XMFLOAT3 Position(int i) const
+    {
+        return DirectX::XMFLOAT3(-mHalfWidth + (i % mNumCols)*mSpatialStep, mCurrSolution[i], mHalfDepth - (i / mNumCols)*mSpatialStep);
+    }
+    float Height(int i) const {return mCurrSolution[i]; }
     const DirectX::XMFLOAT3& Normal(int i) const {return mNormals[i];}
     const DirectX::XMFLOAT3& TangentX(int i) const {return mTangentX[i];}
 
+    // Advances the simulation by dt seconds in fixed mTimeStep steps, carrying the
+    // remainder over to the next call.  At most MaxSubsteps() steps run per call.
     void Update(float dt);
     void Disturb(int i, int j, float magnitude);
 
+    // Advances the simulation by substeps time steps and recomputes normals/tangents once.
+    void Step(int substeps);
+
+    // Largest number of steps a tile advances at once when Step is given several.
+    static const int MaxTemporalBlock = 4;
+
+    int MaxSubsteps() const { return mMaxSubsteps; }
+    void SetMaxSubsteps(int maxSubsteps);
+
+    // Writes Pos, Normal and TexC (mapping [-w/2,w/2] --> [0,1]) of all VertexCount()
+    // vertices to dst, e.g. a mapped upload buffer.  Rows are built in parallel in a
+    // per-thread staging row and streamed out whole, so dst is written sequentially
+    // and never read.
+    template<typename V>
+    void WriteVertices(V* dst) const { WriteVertices(dst, 0, mNumRows); }
+
+    // Same, for rows [rowBegin, rowEnd) only.  dst still points at vertex 0.
+    template<typename V>
+    void WriteVertices(V* dst, int rowBegin, int rowEnd) const;
+
+    // Change tracking for partial uploads.  The version goes up whenever vertices change.
+    // A consumer remembers the version it last wrote out, asks for the rows changed since
+    // then and writes just those.  Rows are only reported once their heights have moved
+    // by more than the dirty threshold in total, so settled water stops costing uploads.
+    std::uint64_t Version() const { return mVersion; }
+    void GetDirtyRows(std::uint64_t sinceVersion, std::vector<std::pair<int, int>>& rowRanges) const;
+
+    float DirtyThreshold() const { return mDirtyThreshold; }
+    void SetDirtyThreshold(float threshold);
+
 private:
+    void ComputeNormals(const float* heights, int rowBegin, int rowEnd);
+
     int mNumRows = 0;
     int mNumCols = 0;
 
@@ -42,11 +85,57 @@ private:
 
     float mTimeStep = 0.0f;
     float mSpatialStep = 0.0f;
+    float mHalfWidth = 0.0f;
+    float mHalfDepth = 0.0f;
+
+    // Simulated time not yet consumed by a step.
+    float mAccumulator = 0.0f;
+    int mMaxSubsteps = 8;
+
+    // Row-major heights, 4 bytes per cell, so the stencil only streams what it uses.
+    std::vector<float> mPrevSolution;
+    std::vector<float> mCurrSolution;
+    // Output buffers for temporally blocked steps, allocated on first use.
+    std::vector<float> mNextPrev;
+    std::vector<float> mNextCurr;
+
+    // Version at which each row's vertices last changed, and how far its heights have
+    // moved since then.
+    std::uint64_t mVersion = 0;
+    std::vector<std::uint64_t> mRowVersion;
+    std::vector<float> mRowDrift;
+    float mDirtyThreshold = 1e-3f;
 
-    std::vector<DirectX::XMFLOAT3> mPrevSolution;
-    std::vector<DirectX::XMFLOAT3> mCurrSolution;
     std::vector<DirectX::XMFLOAT3> mNormals;
     std::vector<DirectX::XMFLOAT3> mTangentX;
 };
 
+template<typename V>
+void Waves::WriteVertices(V* dst, int rowBegin, int rowEnd) const
+{
+    ParallelForRows(rowBegin, rowEnd, mNumCols * (sizeof(V) + sizeof(float) + 2 * sizeof(DirectX::XMFLOAT3)),
+        [this, dst](int tileBegin, int tileEnd)
+    {
+        thread_local std::vector<V> staging;
+        staging.resize(mNumCols);
+
+        const float width = Width();
+        const float depth = Depth();
+
+        for (int i = tileBegin; i < tileEnd; ++i)
+        {
+            for (int j = 0; j < mNumCols; ++j)
+            {
+                V& v = staging[j];
+                v.Pos = Position(i*mNumCols + j);
+                v.Normal = mNormals[i*mNumCols + j];
+                v.TexC.x = 0.5f + (v.Pos.x / width);
+                v.TexC.y = 0.5f + (v.Pos.z / depth);
+            }
+
+            StreamCopy(dst + i*mNumCols, staging.data(), mNumCols * sizeof(V));
+        }
+    });
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+// Row kernels of the wave equation stencil behind Waves::Step, one per instruction set.
+// Each updates count cells of one interior row:
+//
+//   prev = k1*prev + k2*curr + k3*(down + up + right + left)
+//
+// prev and curr point at the first cell to update and stride is the row pitch in floats.
+// All kernels use the same operation order (no FMA), so they produce bit-identical results.
+namespace WavesStencil
+{
+	typedef void (*RowFn)(float* prev, const float* curr, int stride, int count, float k1, float k2, float k3);
+
+	void RowScalar(float* prev, const float* curr, int stride, int count, float k1, float k2, float k3);
+	void RowSSE2(float* prev, const float* curr, int stride, int count, float k1, float k2, float k3);
+
+	// Only call when CpuSupportsAVX2().
+	void RowAVX2(float* prev, const float* curr, int stride, int count, float k1, float k2, float k3);
+
+	// The widest kernel this CPU runs.
+	RowFn SelectRow();
+}
@@ -1,4 +1,13 @@
 #pragma once
 
 #define MaxLights				16
+// Default depth of the frame-resource ring.
 #define NUM_FRAME_RESOURCES		3
+
+// Frame resources in the ring.  More lets the CPU run further ahead of the GPU, fewer
+// lowers input latency.  Changed at runtime through D3D12::SetFrameResourceCount.
+extern int gNumFrameResources;
+
+// Most command lists Draw records in parallel.  Each frame resource owns one allocator
+// and one list per recording worker.
+#define MAX_RECORD_WORKERS		8
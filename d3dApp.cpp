@@ -7,15 +7,33 @@
 #include "Material.h"
 #include "UploadBuffer.h"
 #include "TextureManager.h"
+#include "MeshLoader.h"
+#include "Profiler.h"
+#include "ParallelFor.h"
 
 #include "DDSTextureLoader12.h"
 
+#include <exception>
+
 D3D12* D3D12::mApp = nullptr;
 
 using Microsoft::WRL::ComPtr;
 using namespace std;
 using namespace DirectX;
 
+namespace
+{
+    // Fewest opaque draws worth a command list of their own; below this the list setup
+    // costs more than recording in parallel saves.
+    const size_t MinDrawsPerChunk = 256;
+
+    // The terrain lies under the instanced skull grid, which spans [-100, 100] on each axis.
+    const float TerrainOffsetY = -110.0f;
+
+    // Tiles step down one LOD per this many units between the eye and their bounds.
+    const float TerrainLodDistance = 60.0f;
+}
+
 LRESULT CALLBACK MainWndProc(HWND WindowHandle, UINT Message, WPARAM WParam, LPARAM LParam)
 {
     return D3D12::GetApp()->MsgProc(WindowHandle, Message, WParam, LParam);
@@ -94,6 +112,9 @@ int D3D12::Run()
                 CalculateFrameStats();
                 Update(mTimer);
                 Draw(mTimer);
+
+                // 이번 프레임에 기록된 zone 들을 집계.
+                Profiler::EndFrame();
             }
             else
             {
@@ -106,6 +127,8 @@ int D3D12::Run()
 
 bool D3D12::Initialize()
 {
+    PROFILE_ZONE("Initialize");
+
     if (!InitMainWindow())
     {
         return false;
@@ -131,6 +154,7 @@ bool D3D12::Initialize()
     BuildGeometries();
     BuildMaterials();
     BuildRenderItems();
+    BuildInstancedRenderItems();
     BuildFrameResources();
     BuildPSOs();
 
@@ -231,6 +255,20 @@ LRESULT D3D12::MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
         break;
     case WM_MENUCHAR:
         return MAKELRESULT(0, MNC_CLOSE);
+    case WM_KEYUP:
+        // F9: 다음 120 프레임을 Chrome trace(profile.json)로 저장.
+        if (wParam == VK_F9)
+        {
+            Profiler::CaptureFrames(120, "profile.json");
+            return 0;
+        }
+        // F8: 프레임 리소스 개수를 2 -> 3 -> 4 -> 2 순으로 변경.
+        if (wParam == VK_F8)
+        {
+            SetFrameResourceCount(gNumFrameResources >= 4 ? 2 : gNumFrameResources + 1);
+            return 0;
+        }
+        break;
     case WM_GETMINMAXINFO:
         ((MINMAXINFO*)lParam)->ptMinTrackSize.x = 200;
         ((MINMAXINFO*)lParam)->ptMinTrackSize.y = 200;
@@ -351,32 +389,36 @@ void D3D12::OnResize()
 
 void D3D12::Update(const GameTimer& gt)
 {
+    PROFILE_ZONE("Update");
+
     OnKeyboardInput(gt);
     UpdateCamera(gt);
 
-    mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % NUM_FRAME_RESOURCES;
+    mCurrFrameResourceIndex = (mCurrFrameResourceIndex + 1) % (int)mFrameResources.size();
     mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
 
-    if (mCurrFrameResource->Fence != 0 && mFence->GetCompletedValue() < mCurrFrameResource->Fence)
-    {
-        HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-        ThrowIfFailed(mFence->SetEventOnCompletion(mCurrFrameResource->Fence, eventHandle));
-        if (eventHandle)
-        {
-            WaitForSingleObject(eventHandle, INFINITE);
-            CloseHandle(eventHandle);
-        }
-    }
+    // GPU가 이 프레임 리소스를 다 쓸 때까지 대기.
+    mFenceWaiter.Wait(mCurrFrameResource->Fence);
+
+    // 선택적으로 GPU보다 앞서 나가는 프레임 수를 더 줄임.
+    mFenceWaiter.WaitForFrameLatency(mCurrentFence, mMaxFrameLatency);
 
     //AnimateMaterials(gt); 
     UpdateObjectCBs(gt);
     UpdateMaterialCBs(gt);
     UpdateMainPassCBs(gt);
     //UpdateWaves(gt);
+
+    UpdateTerrainLods();
+    CullRenderItems();
+    SortRenderItems();
+    UpdateInstanceBuffer();
 }
 
 void D3D12::Draw(const GameTimer& gt)
 {
+    PROFILE_ZONE("Draw");
+
     auto cmdListAlloc = mCurrFrameResource->CmdListAlloc;
     
     // 커맨드 기록에 사용된 메모리 재사용.
@@ -385,41 +427,64 @@ void D3D12::Draw(const GameTimer& gt)
 
     ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs["opaque"].Get()));
 
-    mCommandList->RSSetViewports(1, &mScreenViewport);
-    mCommandList->RSSetScissorRects(1, &mScissorRect);
-
     mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
 
     // Clear back buffer, depth buffer
     mCommandList->ClearRenderTargetView(CurrentBackBufferView(), (float*)&mMainPassCB.FogColor, 0, nullptr);
     mCommandList->ClearDepthStencilView(DepthStencilView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.f, 0, 0, nullptr);
 
-    // Specify buffers to render.
-    mCommandList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
-
-    // 셰이더에서 사용할 Descriptor Heap 바인딩(GPU리소스를 셰이더가 접근할 수 있도록 연결)
-    ID3D12DescriptorHeap* descriptorHeaps[] = { mSrvDescriptorHeap.Get() };
-    mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-
-    mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
-
-    UINT passCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(PassConstants));
+    // 이 리스트에는 전환과 클리어만 기록; 드로우는 워커 리스트에.
+    ThrowIfFailed(mCommandList->Close());
 
-    // Draw opaque items
-    auto passCB = mCurrFrameResource->PassCB->Resource();
-    mCommandList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
-    DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+    // 불투명 목록을 청크로 나눠 워커마다 자기 커맨드 리스트에 병렬로 기록.
+    // 드로우가 적으면 나눌수록 리스트 설정 비용만 늘어나므로 청크당 최소 개수를 둠.
+    const size_t OpaqueCount = mVisibleRitems[(int)RenderLayer::Opaque].size();
+    const int ChunkCount = DrawChunkCount(OpaqueCount, mRecordWorkerCount, MinDrawsPerChunk);
 
-    /* TODO: Add Others ...*/
+    // 워커들이 지오메트리 뷰 캐시를 동시에 갱신하지 않도록 여기서 미리 갱신.
+    for (auto& e : mGeometries)
+    {
+        e.second->CachedVertexBufferView();
+        e.second->CachedIndexBufferView();
+    }
 
-    mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+    DrawStateStats ChunkStats[MAX_RECORD_WORKERS];
+    std::exception_ptr ChunkErrors[MAX_RECORD_WORKERS];
+    ParallelFor(0, ChunkCount, 1, [&](int ChunkBegin, int ChunkEnd)
+    {
+        for (int Chunk = ChunkBegin; Chunk < ChunkEnd; ++Chunk)
+        {
+            // ParallelFor 본문은 예외를 던지면 안 되므로 메인 스레드에서 다시 던짐.
+            try
+            {
+                ChunkStats[Chunk] = RecordDrawChunk(Chunk, ChunkCount);
+            }
+            catch (...)
+            {
+                ChunkErrors[Chunk] = std::current_exception();
+            }
+        }
+    });
 
-    // Close recording commands.
-    ThrowIfFailed(mCommandList->Close());
+    mDrawStateStats.Clear();
+    for (int Chunk = 0; Chunk < ChunkCount; ++Chunk)
+    {
+        if (ChunkErrors[Chunk])
+        {
+            std::rethrow_exception(ChunkErrors[Chunk]);
+        }
+        mDrawStateStats += ChunkStats[Chunk];
+    }
+    mDrawChunkCount = ChunkCount;
 
-    // Add command list to queue
-    ID3D12CommandList* cmdLists[] = { mCommandList.Get() };
-    mCommandQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
+    // 기록 순서대로 한 번에 제출: 클리어 리스트 다음에 청크 리스트들.
+    ID3D12CommandList* cmdLists[MAX_RECORD_WORKERS + 1];
+    cmdLists[0] = mCommandList.Get();
+    for (int Chunk = 0; Chunk < ChunkCount; ++Chunk)
+    {
+        cmdLists[Chunk + 1] = mCurrFrameResource->WorkerCmdLists[Chunk].Get();
+    }
+    mCommandQueue->ExecuteCommandLists(ChunkCount + 1, cmdLists);
 
     // Swap back and front buffers.
     ThrowIfFailed(mSwapChain->Present(0, 0));
@@ -431,6 +496,56 @@ void D3D12::Draw(const GameTimer& gt)
     mCommandQueue->Signal(mFence.Get(), mCurrentFence);
 }
 
+void D3D12::SetPassState(ID3D12GraphicsCommandList* cmdList)
+{
+    // 커맨드 리스트마다 상태가 초기화되므로 각 리스트에 다시 설정.
+    cmdList->RSSetViewports(1, &mScreenViewport);
+    cmdList->RSSetScissorRects(1, &mScissorRect);
+
+    // Specify buffers to render.
+    cmdList->OMSetRenderTargets(1, &CurrentBackBufferView(), true, &DepthStencilView());
+
+    // 셰이더에서 사용할 Descriptor Heap 바인딩(GPU리소스를 셰이더가 접근할 수 있도록 연결)
+    ID3D12DescriptorHeap* descriptorHeaps[] = { mSrvDescriptorHeap.Get() };
+    cmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+
+    cmdList->SetGraphicsRootSignature(mRootSignature.Get());
+
+    auto passCB = mCurrFrameResource->PassCB->Resource();
+    cmdList->SetGraphicsRootConstantBufferView(2, passCB->GetGPUVirtualAddress());
+}
+
+DrawStateStats D3D12::RecordDrawChunk(int Chunk, int ChunkCount)
+{
+    PROFILE_ZONE("RecordDrawChunk");
+
+    const Microsoft::WRL::ComPtr<ID3D12CommandAllocator>& Alloc = mCurrFrameResource->WorkerCmdListAllocs[Chunk];
+    const Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>& CmdList = mCurrFrameResource->WorkerCmdLists[Chunk];
+
+    ThrowIfFailed(Alloc->Reset());
+    ThrowIfFailed(CmdList->Reset(Alloc.Get(), mPSOs.at("opaque").Get()));
+    SetPassState(CmdList.Get());
+
+    // Draw opaque items
+    const std::vector<RenderItem*>& Opaque = mVisibleRitems[(int)RenderLayer::Opaque];
+    const size_t Begin = DrawChunkBegin(Opaque.size(), Chunk, ChunkCount);
+    const size_t End = DrawChunkBegin(Opaque.size(), Chunk + 1, ChunkCount);
+    DrawStateStats Stats = DrawRenderItems(CmdList.Get(), Opaque, Begin, End);
+
+    // 마지막 청크가 인스턴싱 아이템과 Present 전환까지 기록.
+    if (Chunk == ChunkCount - 1)
+    {
+        Stats += DrawInstancedRenderItems(CmdList.Get());
+
+        /* TODO: Add Others ...*/
+
+        CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+    }
+
+    ThrowIfFailed(CmdList->Close());
+    return Stats;
+}
+
 void D3D12::OnMouseDown(WPARAM btnState, int x, int y)
 {
     mLastMousePos.x = x;
@@ -541,17 +656,7 @@ void D3D12::FlushCommandQueue()
 
     ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), mCurrentFence));
 
-    if (mFence->GetCompletedValue() < mCurrentFence)
-    {
-        HANDLE EventHandle = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-        mFence->SetEventOnCompletion(mCurrentFence, EventHandle);
-        
-        if (EventHandle)
-        {
-            WaitForSingleObject(EventHandle, INFINITE);
-            CloseHandle(EventHandle);
-        }
-    }
+    mFenceWaiter.Wait(mCurrentFence);
 }
 
 ID3D12Resource* D3D12::CurrentBackBuffer() const
@@ -588,6 +693,7 @@ bool D3D12::InitDirect3D()
     }
     
     ThrowIfFailed(md3dDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+    mFenceWaiter.SetFence(std::make_unique<D3D12WaitableFence>(mFence.Get()));
     
     DsvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
     RtvDescriptorSize = md3dDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
@@ -672,6 +778,7 @@ void D3D12::CalculateFrameStats()
 {
     static int FrameCount = 0;
     static float TimeElapsed = 0.f;
+    static double StallMillisecondsAtLastUpdate = 0.0;
 
     FrameCount++;
 
@@ -684,6 +791,39 @@ void D3D12::CalculateFrameStats()
         wstring MsPerFrameStr = to_wstring(MillisecondPerFrame);
 
         wstring WindowText = mMainWndCaption + L"   fps: " + FpsStr + L"   ms pf: " + MsPerFrameStr;
+
+        // 최근 프레임들의 분포: 평균만으로는 보이지 않는 끊김(jitter)을 표시.
+        const FrameTimeHistogram& FrameTimes = mTimer.FrameTimes();
+        wchar_t PercentileText[96];
+        swprintf_s(PercentileText, L"   p50: %.2f ms   p99: %.2f ms   jitter: %.2f ms",
+            FrameTimes.Percentile(0.5), FrameTimes.Percentile(0.99), FrameTimes.StandardDeviation());
+        WindowText += PercentileText;
+
+        // 지난 1초 동안 GPU를 기다린 시간(프레임당 평균)과 현재 GPU에 남은 프레임 수.
+        const FenceWaiter::Stats& FenceStats = mFenceWaiter.GetStats();
+        wchar_t FenceText[96];
+        swprintf_s(FenceText, L"   gpu wait: %.2f ms   in flight: %llu",
+            (FenceStats.StallMilliseconds - StallMillisecondsAtLastUpdate) / FrameCount,
+            (unsigned long long)mFenceWaiter.FramesInFlight(mCurrentFence));
+        WindowText += FenceText;
+        StallMillisecondsAtLastUpdate = FenceStats.StallMilliseconds;
+
+        // 직전 프레임에서 실제로 기록된 바인딩과 상태 캐시가 걸러낸 바인딩 수.
+        wchar_t BindText[96];
+        swprintf_s(BindText, L"   draws: %u   binds: %u (%u elided)   lists: %d",
+            mDrawStateStats.Draws, mDrawStateStats.Emitted, mDrawStateStats.Elided, mDrawChunkCount);
+        WindowText += BindText;
+
+        // 직전 프레임의 Update/Draw CPU 시간.
+        for (const Profiler::ZoneStats& Zone : Profiler::GetLastFrame())
+        {
+            if (strcmp(Zone.Name, "Update") == 0 || strcmp(Zone.Name, "Draw") == 0)
+            {
+                wchar_t ZoneText[64];
+                swprintf_s(ZoneText, L"   %S: %.2f ms", Zone.Name, Zone.TotalMilliseconds);
+                WindowText += ZoneText;
+            }
+        }
         SetWindowText(mhMainWnd, WindowText.c_str());
 
         FrameCount = 0;
@@ -729,6 +869,8 @@ void D3D12::LogOutputDisplayModes(IDXGIOutput* Output, DXGI_FORMAT Format)
 
 void D3D12::AnimateMaterials(const GameTimer& gt)
 {
+    PROFILE_ZONE("AnimateMaterials");
+
     // Scroll water material texture coordinates.
     auto WaterMat = mMaterials["Water"].get();
 
@@ -754,12 +896,14 @@ void D3D12::AnimateMaterials(const GameTimer& gt)
         WaterMat->MatTransform(3, 1) = tv;
 
         // Material changed so need to update cbuffer;
-        WaterMat->NumFramesDirty = NUM_FRAME_RESOURCES;
+        mDirtyMaterials.Mark(WaterMat);
     }
 }
 
 void D3D12::UpdateMainPassCBs(const GameTimer& gt)
 {
+    PROFILE_ZONE("UpdateMainPassCBs");
+
     XMMATRIX View = XMLoadFloat4x4(&mView);
     XMMATRIX Proj = XMLoadFloat4x4(&mProj);
     XMMATRIX ViewProj = XMMatrixMultiply(View, Proj);
@@ -799,85 +943,61 @@ void D3D12::UpdateMainPassCBs(const GameTimer& gt)
 
 void D3D12::UpdateObjectCBs(const GameTimer& gt)
 {
-    auto CurrentObjectCB = mCurrFrameResource->ObjectCB.get();
-    for (auto& R : mAllRitems)
-    {
-        if (R->NumFramesDirty > 0)
-        {
-            XMMATRIX World = XMLoadFloat4x4(&R->World);
-            XMMATRIX TexTransform = XMLoadFloat4x4(&R->TexTransform);
-
-            ObjectConstants ObjConstants;
-            XMStoreFloat4x4(&ObjConstants.World, XMMatrixTranspose(World));
-            XMStoreFloat4x4(&ObjConstants.TexTransform, XMMatrixTranspose(TexTransform));
+    PROFILE_ZONE("UpdateObjectCBs");
 
-            CurrentObjectCB->CopyData(R->ObjectCBIndex, ObjConstants);
-
-            R->NumFramesDirty--;
-        }
-    }
+    WriteObjectConstants(mDirtyRitems, *mCurrFrameResource->ObjectCB, mCullSet);
 }
 
 void D3D12::UpdateMaterialCBs(const GameTimer& gt)
 {
-    auto CurrentMaterialCB = mCurrFrameResource->MaterialCB.get();
-
-    for (auto& e : mMaterials)
-    {
-        Material* Mat = e.second.get();
-        if (Mat && Mat->NumFramesDirty > 0)
-        {
-            XMMATRIX MaterialTransform = XMLoadFloat4x4(&Mat->MatTransform);
-
-            MaterialConstants MatConstants;
-            MatConstants.DiffuseAlbedo = Mat->DiffuseAlbedo;
-            MatConstants.FresnelR0 = Mat->FresnelR0;
-            MatConstants.Roughness = Mat->Roughness;
-            XMStoreFloat4x4(&MatConstants.MatTransform, XMMatrixTranspose(MaterialTransform));
-
-            CurrentMaterialCB->CopyData(Mat->MatCBIndex, MatConstants);
+    PROFILE_ZONE("UpdateMaterialCBs");
 
-            Mat->NumFramesDirty--;
-        }
-    }
+    WriteMaterialConstants(mDirtyMaterials, *mCurrFrameResource->MaterialCB);
 }
 
 void D3D12::UpdateWaves(const GameTimer& gt)
 {
-    // Every quarter second, generate random wave.
+    PROFILE_ZONE("UpdateWaves");
+
     static float t_base = 0.0f;
-    if ((mTimer.TotalTime() - t_base) >= 0.25f)
+    StepWaves(*mWaves, mTimer.TotalTime(), gt.DeltaTime(), t_base);
+
+    // Update the wave vertex buffer with the new solution.
+    if (auto CurrWavesVB = mCurrFrameResource->WavesVB.get())
     {
-        t_base += 0.25f;
+        // 업로드 힙에 정점을 직접 쓴다. 이 프레임 자원이 마지막으로 갱신된 이후 바뀐 행만 쓴다.
+        WriteWaveVertices(*mWaves, mCurrFrameResource->WavesVersion, CurrWavesVB->MappedData(), mWavesDirtyRows);
 
-        int i = MathHelper::Rand(4, mWaves->RowCount() - 5);
-        int j = MathHelper::Rand(4, mWaves->ColumnCount() - 5);
+        // Set dynamic VB of Wave renderItem to current frame VB.
+        WavesRenderItem->Geo->VertexBufferGPU = CurrWavesVB->Resource();
+    }
+}
 
-        float r = MathHelper::RandF(0.2f, 0.5f);
+void D3D12::UpdateTerrainLods()
+{
+    PROFILE_ZONE("UpdateTerrainLods");
 
-        mWaves->Disturb(i, j, r);
+    if (mTerrainRitems.empty())
+    {
+        return;
     }
 
-    mWaves->Update(gt.DeltaTime());
+    // LODs are picked in the terrain's local space.
+    const XMFLOAT3 EyeLocal(mEyePos.x, mEyePos.y - TerrainOffsetY, mEyePos.z);
+    mTerrain.SelectTileLods(EyeLocal, TerrainLodDistance, mTerrainLods, mTerrainStitchMasks);
 
-    // Update the wave vertex buffer with the new solution.
-    if (auto CurrWavesVB = mCurrFrameResource->WavesVB.get())
+    // Only the index range changes; the tile's constants and bounds stay the same.
+    for (UINT z = 0; z < mTerrain.TileCountZ; ++z)
     {
-        for (int i = 0; i < mWaves->VertexCount(); ++i)
+        for (UINT x = 0; x < mTerrain.TileCountX; ++x)
         {
-            Vertex v;
-            v.Pos = mWaves->Position(i);
-            v.Normal = mWaves->Normal(i);
+            const UINT Tile = z * mTerrain.TileCountX + x;
+            const SubmeshGeometry SubMesh = mTerrain.GetTileSubmesh(x, z, mTerrainLods[Tile], mTerrainStitchMasks[Tile]);
 
-            // 정점의 위치를 이용해서 텍스처 조표를 계산
-            // mapping [-w/2,w/2] --> [0,1]
-            v.TexC.x = 0.5f + (v.Pos.x / mWaves->Width());
-            v.TexC.y = 0.5f + (v.Pos.z / mWaves->Depth());
-
-            CurrWavesVB->CopyData(i, v);
+            RenderItem* R = mTerrainRitems[Tile];
+            R->IndexCount = SubMesh.IndexCount;
+            R->StartIndexLocation = SubMesh.StartIndexLocation;
         }
-        // Set dynamic VB of Wave renderItem to current frame VB.
-        WavesRenderItem->Geo->VertexBufferGPU = CurrWavesVB->Resource();
     }
 }
 
@@ -888,10 +1008,13 @@ void D3D12::UpdateReflectedPassCB(const GameTimer& gt)
 
 void D3D12::LoadTextures()
 {
+    PROFILE_ZONE("LoadTextures");
+
     TextureManager->LoadTexture("bricksTex", L"Textures/bricks3.dds");
     TextureManager->LoadTexture("checkboardTex", L"Textures/checkboard.dds");
     TextureManager->LoadTexture("iceTex", L"Textures/ice.dds");
     TextureManager->LoadTexture("white1x1Tex", L"Textures/white1x1.dds");
+    TextureManager->LoadTexture("grassTex", L"Textures/grass.dds");
 }
 
 void D3D12::BuildRootSignature()
@@ -902,7 +1025,7 @@ void D3D12::BuildRootSignature()
     CD3DX12_DESCRIPTOR_RANGE TextureTable;
     TextureTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
     
-    CD3DX12_ROOT_PARAMETER SlotRootParameter[4];
+    CD3DX12_ROOT_PARAMETER SlotRootParameter[6];
 
     // Perfomance TIP: Order from most frequent to least frequent.
     SlotRootParameter[0].InitAsDescriptorTable(1, &TextureTable, D3D12_SHADER_VISIBILITY_PIXEL); 
@@ -910,9 +1033,13 @@ void D3D12::BuildRootSignature()
     SlotRootParameter[2].InitAsConstantBufferView(1);
     SlotRootParameter[3].InitAsConstantBufferView(2);
 
+    // 인스턴싱 경로: 인스턴스 데이터(t0, space1)와 재질 상수 버퍼를 구조적 버퍼로 읽기(t1, space1).
+    SlotRootParameter[4].InitAsShaderResourceView(0, 1);
+    SlotRootParameter[5].InitAsShaderResourceView(1, 1);
+
     auto StaticSamplers = GetStaticSamplers();
 
-    CD3DX12_ROOT_SIGNATURE_DESC RootSigDesc(4, SlotRootParameter,
+    CD3DX12_ROOT_SIGNATURE_DESC RootSigDesc(6, SlotRootParameter,
         (UINT)StaticSamplers.size(), StaticSamplers.data(),
         D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
 
@@ -936,7 +1063,7 @@ void D3D12::BuildDescriptorHeaps()
 {
     // Create SRV heap.
     D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-    srvHeapDesc.NumDescriptors = 4;
+    srvHeapDesc.NumDescriptors = 5;
     srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
     ThrowIfFailed(md3dDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap)));
@@ -948,6 +1075,7 @@ void D3D12::BuildDescriptorHeaps()
     auto checkboardTex = TextureManager->GetTexture("checkboardTex")->Resource;
     auto iceTex = TextureManager->GetTexture("iceTex")->Resource;
     auto white1x1Tex = TextureManager->GetTexture("white1x1Tex")->Resource;
+    auto grassTex = TextureManager->GetTexture("grassTex")->Resource;
 
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING; //SRV가 셰이더에서 RGBA 채널을 기본 방식으로 읽도록 설정.
@@ -972,10 +1100,17 @@ void D3D12::BuildDescriptorHeaps()
     
     srvDesc.Format = white1x1Tex->GetDesc().Format;
     md3dDevice->CreateShaderResourceView(white1x1Tex.Get(), &srvDesc, hDescriptor);
+
+    hDescriptor.Offset(1, CbvSrvUavDescriptorSize);
+
+    srvDesc.Format = grassTex->GetDesc().Format;
+    md3dDevice->CreateShaderResourceView(grassTex.Get(), &srvDesc, hDescriptor);
 }
 
 void D3D12::BuildShaderAndInputLayout()
 {
+    PROFILE_ZONE("BuildShaderAndInputLayout");
+
     const D3D_SHADER_MACRO defines[] =
     {
         "FOG", "1",
@@ -989,8 +1124,10 @@ void D3D12::BuildShaderAndInputLayout()
         NULL, NULL,
     };
     
-    mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "VS", "vs_5_0");
-    mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "PS", "ps_5_0");
+    mShaders["standardVS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "VS", "vs_5_1");
+    mShaders["opaquePS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "PS", "ps_5_1");
+    mShaders["instancedVS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "InstancedVS", "vs_5_1");
+    mShaders["instancedPS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", nullptr, "InstancedPS", "ps_5_1");
     //mShaders["alphaTestedPS"] = d3dUtil::CompileShader(L"Shaders/Default.hlsl", alphaTestDefines, "PS", "ps_5_0");
 
     mInputLayout =
@@ -1003,11 +1140,23 @@ void D3D12::BuildShaderAndInputLayout()
 
 void D3D12::BuildGeometries()
 {
+    PROFILE_ZONE("BuildGeometries");
+
+    BuildLandGeometry();
+    BuildBoxGeometry();
     BuildSkullGeometry();
+
+    UINT GeometrySortId = 0;
+    for (auto& e : mGeometries)
+    {
+        e.second->SortId = GeometrySortId++;
+    }
 }
 
 void D3D12::BuildPSOs()
 {
+    PROFILE_ZONE("BuildPSOs");
+
     /*typedef struct D3D12_GRAPHICS_PIPELINE_STATE_DESC
     {
     ID3D12RootSignature *pRootSignature;
@@ -1069,13 +1218,76 @@ void D3D12::BuildPSOs()
     opaquePsoDesc.SampleDesc.Quality = m4xMsaaState ? (m4xMsaaQuality - 1) : 0;
     opaquePsoDesc.DSVFormat = mDepthStencilFormat;
     ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&mPSOs["opaque"])));
+
+    // PSO for instanced opaque objects.
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedPsoDesc = opaquePsoDesc;
+    instancedPsoDesc.VS =
+    {
+        reinterpret_cast<BYTE*>(mShaders["instancedVS"]->GetBufferPointer()),
+        mShaders["instancedVS"]->GetBufferSize()
+    };
+    instancedPsoDesc.PS =
+    {
+        reinterpret_cast<BYTE*>(mShaders["instancedPS"]->GetBufferPointer()),
+        mShaders["instancedPS"]->GetBufferSize()
+    };
+    ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&instancedPsoDesc, IID_PPV_ARGS(&mPSOs["opaqueInstanced"])));
 }
 
 void D3D12::BuildFrameResources()
 {
-    for (int i = 0; i < NUM_FRAME_RESOURCES; ++i)
+    // 워커 스레드 수만큼(호출 스레드 포함) 커맨드 리스트를 준비.
+    mRecordWorkerCount = (std::max)(1, (std::min)(MAX_RECORD_WORKERS, GetDefaultExecutor().Concurrency()));
+
+    for (int i = 0; i < gNumFrameResources; ++i)
     {
-        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(), 2, (UINT)mAllRitems.size(), (UINT)mMaterials.size(), 0));
+        mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(), 2, (UINT)mAllRitems.size(), (UINT)mMaterials.size(), 0,
+            mInstanceCullSet.Size(), (UINT)mRecordWorkerCount));
+    }
+}
+
+void D3D12::SetFrameResourceCount(int Count)
+{
+    if (Count < 1)
+    {
+        Count = 1;
+    }
+    if (Count == gNumFrameResources && (int)mFrameResources.size() == Count)
+    {
+        return;
+    }
+
+    gNumFrameResources = Count;
+    if (mFrameResources.empty() || !md3dDevice)
+    {
+        return;
+    }
+
+    // 기존 프레임 리소스를 GPU가 더 이상 참조하지 않을 때까지 대기 후 다시 생성.
+    FlushCommandQueue();
+
+    mFrameResources.clear();
+    BuildFrameResources();
+    mCurrFrameResourceIndex = 0;
+    mCurrFrameResource = mFrameResources[mCurrFrameResourceIndex].get();
+
+    // 새 업로드 버퍼가 이전 버퍼의 주소를 재사용할 수 있으므로 캐시된 뷰를 버림.
+    for (auto& e : mGeometries)
+    {
+        e.second->InvalidateBufferViews();
+    }
+
+    // 새 버퍼들은 비어 있으므로 모든 상수를 다시 기록.
+    for (auto& R : mAllRitems)
+    {
+        mDirtyRitems.Mark(R.get());
+    }
+    for (auto& e : mMaterials)
+    {
+        if (e.second)
+        {
+            mDirtyMaterials.Mark(e.second.get());
+        }
     }
 }
 
@@ -1121,59 +1333,263 @@ void D3D12::BuildMaterials()
     shadowMat->FresnelR0 = XMFLOAT3(0.001f, 0.001f, 0.001f);
     shadowMat->Roughness = 0.0f;
 
+    auto grass = std::make_unique<Material>();
+    grass->Name = "grass";
+    grass->MatCBIndex = 5;
+    grass->DiffuseSrvHeapIndex = 4;
+    grass->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+    grass->FresnelR0 = XMFLOAT3(0.01f, 0.01f, 0.01f);
+    grass->Roughness = 0.125f;
+
     mMaterials["bricks"] = std::move(bricks);
     mMaterials["checkertile"] = std::move(checkertile);
     mMaterials["icemirror"] = std::move(icemirror);
     mMaterials["skullMat"] = std::move(skullMat);
     mMaterials["shadowMat"] = std::move(shadowMat);
+    mMaterials["grass"] = std::move(grass);
+
+    for (auto& e : mMaterials)
+    {
+        mDirtyMaterials.Mark(e.second.get());
+    }
 }
 
 void D3D12::BuildRenderItems()
 {
-    auto skullRitem = std::make_unique<RenderItem>();
-    skullRitem->World = MathHelper::Identity4x4();
-    skullRitem->TexTransform = MathHelper::Identity4x4();
-    skullRitem->ObjectCBIndex = 0;
-    skullRitem->Mat = mMaterials["skullMat"].get();
-    skullRitem->Geo = mGeometries["skullGeo"].get();
-    skullRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-    skullRitem->IndexCount = skullRitem->Geo->DrawArgs["skull"].IndexCount;
-    skullRitem->StartIndexLocation = skullRitem->Geo->DrawArgs["skull"].StartIndexLocation;
-    skullRitem->BaseVertexLocation = skullRitem->Geo->DrawArgs["skull"].BaseVertexLocation;
-    mSkullRitem = skullRitem.get();
-    mRitemLayer[(int)RenderLayer::Opaque].push_back(skullRitem.get());
+    // One item per 16-bit chunk; a model over 64K vertices is split by MeshLoader::CompactIndices.
+    for (const SubmeshGeometry& Chunk : MeshLoader::GetSubmeshChunks(*mGeometries["skullGeo"], "skull"))
+    {
+        auto skullRitem = std::make_unique<RenderItem>();
+        skullRitem->World = MathHelper::Identity4x4();
+        skullRitem->TexTransform = MathHelper::Identity4x4();
+        skullRitem->ObjectCBIndex = (UINT)mAllRitems.size();
+        skullRitem->Mat = mMaterials["skullMat"].get();
+        skullRitem->Geo = mGeometries["skullGeo"].get();
+        skullRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        skullRitem->IndexCount = Chunk.IndexCount;
+        skullRitem->StartIndexLocation = Chunk.StartIndexLocation;
+        skullRitem->BaseVertexLocation = Chunk.BaseVertexLocation;
+        skullRitem->Bounds = Chunk.SphereBounds;
+        if (mSkullRitem == nullptr)
+        {
+            mSkullRitem = skullRitem.get();
+        }
+        mRitemLayer[(int)RenderLayer::Opaque].push_back(skullRitem.get());
+        mDirtyRitems.Mark(skullRitem.get());
+
+        mAllRitems.push_back(std::move(skullRitem));
+    }
+
+    // Pedestal under the center skull, whose model rests on y = 0.
+    auto BoxRitem = std::make_unique<RenderItem>();
+    XMStoreFloat4x4(&BoxRitem->World, XMMatrixTranslation(0.0f, -4.0f, 0.0f));
+    BoxRitem->ObjectCBIndex = (UINT)mAllRitems.size();
+    BoxRitem->Mat = mMaterials["bricks"].get();
+    BoxRitem->Geo = mGeometries["BoxGeo"].get();
+    BoxRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+    BoxRitem->IndexCount = BoxRitem->Geo->DrawArgs["Box"].IndexCount;
+    BoxRitem->StartIndexLocation = BoxRitem->Geo->DrawArgs["Box"].StartIndexLocation;
+    BoxRitem->BaseVertexLocation = BoxRitem->Geo->DrawArgs["Box"].BaseVertexLocation;
+    BoxRitem->Bounds = BoxRitem->Geo->DrawArgs["Box"].SphereBounds;
+    mRitemLayer[(int)RenderLayer::Opaque].push_back(BoxRitem.get());
+    mDirtyRitems.Mark(BoxRitem.get());
+    mAllRitems.push_back(std::move(BoxRitem));
+
+    // One item per terrain tile.  UpdateTerrainLods fills in the index range every frame;
+    // the vertices, and so the bounds, are the same at every LOD.
+    for (UINT z = 0; z < mTerrain.TileCountZ; ++z)
+    {
+        for (UINT x = 0; x < mTerrain.TileCountX; ++x)
+        {
+            const SubmeshGeometry SubMesh = mTerrain.GetTileSubmesh(x, z, 0, 0);
+
+            auto TileRitem = std::make_unique<RenderItem>();
+            XMStoreFloat4x4(&TileRitem->World, XMMatrixTranslation(0.0f, TerrainOffsetY, 0.0f));
+            XMStoreFloat4x4(&TileRitem->TexTransform, XMMatrixScaling(20.0f, 20.0f, 1.0f));
+            TileRitem->ObjectCBIndex = (UINT)mAllRitems.size();
+            TileRitem->Mat = mMaterials["grass"].get();
+            TileRitem->Geo = mGeometries["LandGeo"].get();
+            TileRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+            TileRitem->IndexCount = SubMesh.IndexCount;
+            TileRitem->StartIndexLocation = SubMesh.StartIndexLocation;
+            TileRitem->BaseVertexLocation = SubMesh.BaseVertexLocation;
+            BoundingSphere::CreateFromBoundingBox(TileRitem->Bounds, SubMesh.Bounds);
+
+            mTerrainRitems.push_back(TileRitem.get());
+            mRitemLayer[(int)RenderLayer::Opaque].push_back(TileRitem.get());
+            mDirtyRitems.Mark(TileRitem.get());
+
+            mAllRitems.push_back(std::move(TileRitem));
+        }
+    }
+
+    mCullSet.Resize((UINT)mAllRitems.size());
+}
+
+void D3D12::BuildInstancedRenderItems()
+{
+    // 스컬 10x10x10 격자: 1000개를 드로우 한 번으로.
+    const int N = 10;
+    const float Size = 200.0f;
+    const float Step = Size / (N - 1);
+
+    Material* InstanceMats[] = { mMaterials["bricks"].get(), mMaterials["checkertile"].get(), mMaterials["icemirror"].get(), mMaterials["skullMat"].get() };
+
+    std::vector<RenderInstance> Instances(N * N * N);
+    for (int k = 0; k < N; ++k)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            for (int j = 0; j < N; ++j)
+            {
+                RenderInstance& Instance = Instances[(k * N + i) * N + j];
+                XMStoreFloat4x4(&Instance.World, XMMatrixTranslation(-0.5f * Size + j * Step, -0.5f * Size + i * Step, -0.5f * Size + k * Step));
+                Instance.Mat = InstanceMats[(i + j + k) % _countof(InstanceMats)];
+            }
+        }
+    }
+
+    // Each 16-bit chunk of the model is its own instanced draw over the same instances.
+    for (const SubmeshGeometry& Chunk : MeshLoader::GetSubmeshChunks(*mGeometries["skullGeo"], "skull"))
+    {
+        auto Skulls = std::make_unique<InstancedRenderItem>();
+        Skulls->Mat = mMaterials["skullMat"].get();
+        Skulls->Geo = mGeometries["skullGeo"].get();
+        Skulls->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        Skulls->IndexCount = Chunk.IndexCount;
+        Skulls->StartIndexLocation = Chunk.StartIndexLocation;
+        Skulls->BaseVertexLocation = Chunk.BaseVertexLocation;
+        Skulls->Bounds = Chunk.SphereBounds;
+        Skulls->Instances = Instances;
+        mInstancedRitems.push_back(std::move(Skulls));
+    }
+
+    UINT InstanceCount = 0;
+    for (auto& Item : mInstancedRitems)
+    {
+        Item->CullBase = InstanceCount;
+        Item->BoundsDirty = true;
+        InstanceCount += (UINT)Item->Instances.size();
+    }
+    mInstanceCullSet.Resize(InstanceCount);
+}
+
+void D3D12::CullRenderItems()
+{
+    PROFILE_ZONE("CullRenderItems");
+
+    XMMATRIX ViewProj = XMMatrixMultiply(XMLoadFloat4x4(&mView), XMLoadFloat4x4(&mProj));
+    const FrustumPlanes Frustum = FrustumPlanes::FromViewProj(ViewProj);
+    mCullSet.Cull(Frustum, mRitemVisible);
+
+    // 움직인 인스턴스 묶음만 월드 구를 다시 계산.
+    UpdateInstanceBounds(mInstancedRitems, mInstanceCullSet);
+    mInstanceCullSet.Cull(Frustum, mInstanceVisible);
+
+    for (int Layer = 0; Layer < (int)RenderLayer::Count; ++Layer)
+    {
+        GatherVisibleItems(mRitemLayer[Layer], mRitemVisible, mVisibleRitems[Layer]);
+    }
+}
+
+void D3D12::SortRenderItems()
+{
+    PROFILE_ZONE("SortRenderItems");
+
+    // 불투명은 상태(PSO, 텍스처, 재질, 지오메트리) 순, 반투명은 먼 것부터.
+    for (int Layer = 0; Layer < (int)RenderLayer::Count; ++Layer)
+    {
+        SortLayer(mVisibleRitems[Layer], Layer, mCullSet, mView, mMainPassCB.NearZ, mMainPassCB.FarZ, mDrawSortScratch);
+    }
+}
+
+void D3D12::UpdateInstanceBuffer()
+{
+    PROFILE_ZONE("UpdateInstanceBuffer");
 
-    mAllRitems.push_back(std::move(skullRitem));   
+    if (mCurrFrameResource->InstanceBuffer == nullptr)
+    {
+        return;
+    }
+
+    // Write-combined 메모리이므로 보이는 인스턴스를 앞에서부터 순서대로 기록.
+    WriteVisibleInstances(mInstancedRitems, mInstanceVisible, mCurrFrameResource->InstanceBuffer->MappedData());
 }
 
-void D3D12::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& RenderItems)
+DrawStateStats D3D12::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& RenderItems, size_t Begin, size_t End)
 {
+    PROFILE_ZONE("DrawRenderItems");
+
     UINT ObjCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
     UINT MatCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants));
 
-    auto ObjectCB = mCurrFrameResource->ObjectCB->Resource();
-    auto MatCB = mCurrFrameResource->MaterialCB->Resource();
+    // 루프 밖에서 한 번만 조회.
+    const D3D12_GPU_VIRTUAL_ADDRESS ObjectCBAddress = mCurrFrameResource->ObjectCB->Resource()->GetGPUVirtualAddress();
+    const D3D12_GPU_VIRTUAL_ADDRESS MatCBAddress = mCurrFrameResource->MaterialCB->Resource()->GetGPUVirtualAddress();
+    const CD3DX12_GPU_DESCRIPTOR_HANDLE SrvHeapStart(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 
-    for (size_t i = 0; i < RenderItems.size(); ++i)
+    // 정렬된 목록에서는 이웃한 아이템이 지오메트리와 재질을 공유하므로 대부분의 바인딩이 중복.
+    DrawStateCache<ID3D12GraphicsCommandList> State(cmdList);
+
+    for (size_t i = Begin; i < End; ++i)
     {
         auto RenderItem = RenderItems[i];
 
-        cmdList->IASetVertexBuffers(0, 1, &RenderItem->Geo->VertexBufferView());
-        cmdList->IASetIndexBuffer(&RenderItem->Geo->IndexBufferView());
-        cmdList->IASetPrimitiveTopology(RenderItem->PrimitiveType);
+        State.SetVertexBuffer(RenderItem->Geo->CachedVertexBufferView());
+        State.SetIndexBuffer(RenderItem->Geo->CachedIndexBufferView());
+        State.SetPrimitiveTopology(RenderItem->PrimitiveType);
+
+        CD3DX12_GPU_DESCRIPTOR_HANDLE Texture(SrvHeapStart, RenderItem->Mat->DiffuseSrvHeapIndex, CbvSrvUavDescriptorSize);
+
+        State.SetGraphicsRootDescriptorTable(0, Texture);
+        State.SetGraphicsRootConstantBufferView(1, ObjectCBAddress + (UINT64)RenderItem->ObjectCBIndex * ObjCBByteSize);
+        State.SetGraphicsRootConstantBufferView(3, MatCBAddress + (UINT64)RenderItem->Mat->MatCBIndex * MatCBByteSize);
+
+        State.DrawIndexedInstanced(RenderItem->IndexCount, 1, RenderItem->StartIndexLocation, RenderItem->BaseVertexLocation, 0);
+    }
+
+    return State.Stats();
+}
+
+DrawStateStats D3D12::DrawInstancedRenderItems(ID3D12GraphicsCommandList* cmdList)
+{
+    PROFILE_ZONE("DrawInstancedRenderItems");
+
+    if (mCurrFrameResource->InstanceBuffer == nullptr)
+    {
+        return DrawStateStats();
+    }
+
+    const D3D12_GPU_VIRTUAL_ADDRESS InstanceBufferAddress = mCurrFrameResource->InstanceBuffer->Resource()->GetGPUVirtualAddress();
+    const CD3DX12_GPU_DESCRIPTOR_HANDLE SrvHeapStart(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
 
-        CD3DX12_GPU_DESCRIPTOR_HANDLE Texture(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-        Texture.Offset(RenderItem->Mat->DiffuseSrvHeapIndex, CbvSrvUavDescriptorSize);
+    cmdList->SetPipelineState(mPSOs.at("opaqueInstanced").Get());
 
-        D3D12_GPU_VIRTUAL_ADDRESS ObjCBAddress = ObjectCB->GetGPUVirtualAddress() + RenderItem->ObjectCBIndex * ObjCBByteSize;
-        D3D12_GPU_VIRTUAL_ADDRESS MatCBAddress = MatCB->GetGPUVirtualAddress() + RenderItem->Mat->MatCBIndex * MatCBByteSize;
+    DrawStateCache<ID3D12GraphicsCommandList> State(cmdList);
+    State.SetGraphicsRootShaderResourceView(5, mCurrFrameResource->MaterialCB->Resource()->GetGPUVirtualAddress());
+
+    for (auto& Item : mInstancedRitems)
+    {
+        if (Item->VisibleCount == 0)
+        {
+            continue;
+        }
 
-        cmdList->SetGraphicsRootDescriptorTable(0, Texture);
-        cmdList->SetGraphicsRootConstantBufferView(1, ObjCBAddress);
-        cmdList->SetGraphicsRootConstantBufferView(3, MatCBAddress);
+        State.SetVertexBuffer(Item->Geo->CachedVertexBufferView());
+        State.SetIndexBuffer(Item->Geo->CachedIndexBufferView());
+        State.SetPrimitiveTopology(Item->PrimitiveType);
 
-        cmdList->DrawIndexedInstanced(RenderItem->IndexCount, 1, RenderItem->StartIndexLocation, RenderItem->BaseVertexLocation, 0);
+        CD3DX12_GPU_DESCRIPTOR_HANDLE Texture(SrvHeapStart, Item->Mat->DiffuseSrvHeapIndex, CbvSrvUavDescriptorSize);
+        State.SetGraphicsRootDescriptorTable(0, Texture);
+
+        // 버퍼를 아이템의 첫 인스턴스부터 바인딩해서 SV_InstanceID가 바로 인덱스가 되도록.
+        State.SetGraphicsRootShaderResourceView(4, InstanceBufferAddress + (UINT64)Item->FirstVisible * sizeof(InstanceData));
+
+        State.DrawIndexedInstanced(Item->IndexCount, Item->VisibleCount, Item->StartIndexLocation, Item->BaseVertexLocation, 0);
     }
+
+    cmdList->SetPipelineState(mPSOs.at("opaque").Get());
+    return State.Stats();
 }
 
 std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> D3D12::GetStaticSamplers()
@@ -1229,22 +1645,25 @@ std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> D3D12::GetStaticSamplers()
 
 void D3D12::BuildLandGeometry()
 {
+    // 200x200 크기를 16x16 quad 타일 8x8 개로 나눈다. 타일마다 16-bit 인덱스로 그릴 수 있고
+    // 각 타일은 자기 Bounds 를 가진다.
     GeometryGenerator GeoGen;
-    GeometryGenerator::MeshData Grid = GeoGen.CreateGrid(200, 200, 10, 10);
+    GeometryGenerator::TerrainData Terrain = GeoGen.CreateTerrain(200.0f, 200.0f, 8, 8, 16, 3);
+
+    // Evaluate the height field in SIMD batches, one tile per task.
+    GeometryGenerator::ApplyHills(Terrain);
 
-    std::vector<Vertex> Vertices(Grid.Vertices.size());
-    for (size_t i = 0; i < Grid.Vertices.size(); ++i)
+    std::vector<Vertex> Vertices(Terrain.Vertices.size());
+    for (size_t i = 0; i < Terrain.Vertices.size(); ++i)
     {
-        auto& P = Grid.Vertices[i].Position;
-        Vertices[i].Pos = P;
-        Vertices[i].Pos.y = GeometryGenerator::GetHillsHeight(P.x, P.z);
-        Vertices[i].Normal = GeometryGenerator::GetHillsNormal(P.x, P.z);
-        Vertices[i].TexC = Grid.Vertices[i].TexC;
+        Vertices[i].Pos = Terrain.Vertices[i].Position;
+        Vertices[i].Normal = Terrain.Vertices[i].Normal;
+        Vertices[i].TexC = Terrain.Vertices[i].TexC;
     }
 
     const UINT VbByteSize = (UINT)Vertices.size() * sizeof(Vertex);
 
-    std::vector<std::uint16_t> Indices = Grid.GetIndices16();
+    const std::vector<std::uint16_t>& Indices = Terrain.Indices16;
     const UINT IbByteSize = (UINT)Indices.size() * sizeof(std::uint16_t);
 
     auto Geo = std::make_unique<MeshGeometry>();
@@ -1267,18 +1686,17 @@ void D3D12::BuildLandGeometry()
     Geo->IndexFormat = DXGI_FORMAT_R16_UINT;
     Geo->IndexBufferByteSize = IbByteSize;
 
-    SubmeshGeometry LandSubMesh;
-    LandSubMesh.IndexCount = (UINT)Indices.size();
-    LandSubMesh.StartIndexLocation = 0;
-    LandSubMesh.BaseVertexLocation = 0;
-    Geo->DrawArgs["Grid"] = LandSubMesh;
+    // 타일마다 (LOD, stitch mask) 조합이 매 프레임 바뀌므로 DrawArgs 대신 TerrainData 를 보관하고
+    // UpdateTerrainLods 가 GetTileSubmesh 로 인덱스 범위를 고른다.
     mGeometries["LandGeo"] = std::move(Geo);
+    mTerrain = std::move(Terrain);
 }
 
 void D3D12::BuildBoxGeometry()
 {
     GeometryGenerator GeoGen;
     GeometryGenerator::MeshData Box = GeoGen.CreateBox(8.0f, 8.f, 8.f, 3);
+    MeshLoader::LogCacheStats("Box", MeshOptimizer::Optimize(Box.Vertices, Box.Indices32));
 
     std::vector<Vertex> Vertices(Box.Vertices.size());
     for (size_t i = 0; i < Box.Vertices.size(); ++i)
@@ -1320,14 +1738,14 @@ void D3D12::BuildBoxGeometry()
     BoxSubMesh.BaseVertexLocation = 0;
 
     BoxGeo->DrawArgs["Box"] = BoxSubMesh;
+    BoxGeo->ComputeSubmeshBounds();
     mGeometries["BoxGeo"] = std::move(BoxGeo);
 }
 
 void D3D12::BuildWaveGeometry()
 {
     // 3 indices per face
-    std::vector<std::uint16_t> Indices(3 * mWaves->TriangleCount()); 
-    assert(mWaves->VertexCount() < 0x0000ffff);
+    std::vector<std::uint32_t> Indices(3 * mWaves->TriangleCount());
 
     int M = mWaves->RowCount();
     int N = mWaves->ColumnCount();
@@ -1348,9 +1766,24 @@ void D3D12::BuildWaveGeometry()
         }
     }
 
+    // The wave vertex buffer is rewritten every frame, so it can't be split into chunks;
+    // just pick the narrowest index format that addresses the whole grid.
+    const bool Use16BitIndices = mWaves->VertexCount() <= (int)MeshLoader::MaxChunkVertexCount;
+    std::vector<std::uint16_t> Indices16;
+    if (Use16BitIndices)
+    {
+        Indices16.resize(Indices.size());
+        for (size_t i = 0; i < Indices.size(); ++i)
+        {
+            Indices16[i] = static_cast<std::uint16_t>(Indices[i]);
+        }
+    }
+
+    const void* IndexData = Use16BitIndices ? (const void*)Indices16.data() : (const void*)Indices.data();
+
     // Set dynamically
     UINT VbByteSize = mWaves->VertexCount() * sizeof(Vertex);
-    UINT IbByteSize = (UINT)Indices.size() * sizeof(std::uint16_t);
+    UINT IbByteSize = (UINT)Indices.size() * (Use16BitIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t));
 
     auto Geo = std::make_unique<MeshGeometry>();
     Geo->Name = "WaterGeo";
@@ -1359,14 +1792,14 @@ void D3D12::BuildWaveGeometry()
     Geo->VertexBufferGPU = nullptr;
 
     ThrowIfFailed(D3DCreateBlob(IbByteSize, &Geo->IndexBufferCPU));
-    CopyMemory(Geo->IndexBufferCPU->GetBufferPointer(), Indices.data(), IbByteSize);
+    CopyMemory(Geo->IndexBufferCPU->GetBufferPointer(), IndexData, IbByteSize);
 
     Geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(),
-        mCommandList.Get(), Indices.data(), IbByteSize, Geo->IndexBufferUploader);
+        mCommandList.Get(), IndexData, IbByteSize, Geo->IndexBufferUploader);
 
     Geo->VertexByteStride = sizeof(Vertex);
     Geo->VertexBufferByteSize = VbByteSize;
-    Geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+    Geo->IndexFormat = Use16BitIndices ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
     Geo->IndexBufferByteSize = IbByteSize;
 
     SubmeshGeometry SubMesh;
@@ -1374,6 +1807,12 @@ void D3D12::BuildWaveGeometry()
     SubMesh.StartIndexLocation = 0;
     SubMesh.BaseVertexLocation = 0;
 
+    // The vertices move every frame, so bound the rest grid plus room for the waves.
+    const float WaveHeightBound = 2.0f;
+    SubMesh.Bounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    SubMesh.Bounds.Extents = XMFLOAT3(0.5f * mWaves->Width(), WaveHeightBound, 0.5f * mWaves->Depth());
+    BoundingSphere::CreateFromBoundingBox(SubMesh.SphereBounds, SubMesh.Bounds);
+
     Geo->DrawArgs["Grid"] = SubMesh;
     mGeometries["WaterGeo"] = std::move(Geo);
 }
@@ -1487,83 +1926,28 @@ void D3D12::BuildRoomGeometry()
     geo->DrawArgs["floor"] = floorSubmesh;
     geo->DrawArgs["wall"] = wallSubmesh;
     geo->DrawArgs["mirror"] = mirrorSubmesh;
+    geo->ComputeSubmeshBounds();
 
     mGeometries[geo->Name] = std::move(geo);
 }
 
 void D3D12::BuildSkullGeometry()
 {
-    // 파일을 읽기 모드로 연다.
-    std::ifstream fin("Models/skull.txt");
+    auto geo = std::make_unique<MeshGeometry>();
+    geo->Name = "skullGeo";
 
-    if (!fin)
+    // 텍스트 모델은 처음 한 번만 파싱하고, 이후에는 바이너리 캐시(.wem)를 그대로 읽는다.
+    if (!MeshLoader::LoadCachedMesh(L"Models/skull.txt", L"Models/skull.wem", "skull", *geo))
     {
-        MessageBox(mhMainWnd, L"Modles/skull.tex not found", 0, 0);
+        MessageBox(mhMainWnd, L"Models/skull.txt not found", 0, 0);
         return;
     }
 
-    UINT vcount = 0;
-    UINT tcount = 0;
-    std::string ignore;
-
-    // 공백 앞까지가 하나의 토큰. 공백은 포함되지 않음.
-    fin >> ignore >> vcount; // ignore("VertexCount:"), vcount(31076)
-    fin >> ignore >> tcount; // ignore("TriangleCount"), tcount(60339)
-    fin >> ignore >> ignore >> ignore >> ignore; // ignore("VertexList", "(pos,", "normal)", "{") 결과적으로 "{" 가 마지막으로 남음.
-
-    std::vector<Vertex> vertices(vcount);
-    for (UINT i = 0; i < vcount; ++i)
-    {
-        //0.592978 1.92413 - 2.62486 0.572276 0.816877 0.0721907
-        fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z; 
-        fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-
-        // Skull model 이 texture coordinates가 없어서 0으로 설정.
-        vertices[i].TexC = { 0.f, 0.f };
-    }
-
-    //3줄 더 버려야함
-    //}
-    //TriangleList
-    //{
-    fin >> ignore;
-    fin >> ignore;
-    fin >> ignore;
-    
-    std::vector<std::int32_t> indices(3 * tcount);
-    for (UINT i = 0; i < tcount; ++i)
-    {
-        fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-    }
-
-    fin.close();
-
-    // Pack indices into one index buffer.
-    const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-    const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
-
-    auto geo = std::make_unique<MeshGeometry>();
-    geo->Name = "skullGeo";
-
-    ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-    CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-    ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-    memcpy(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-    geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-    geo->VertexByteStride = sizeof(Vertex);
-    geo->VertexBufferByteSize = vbByteSize;
-
-    geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-    geo->IndexFormat = DXGI_FORMAT_R32_UINT;
-    geo->IndexBufferByteSize = ibByteSize;
+    geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
+        geo->VertexBufferCPU->GetBufferPointer(), geo->VertexBufferByteSize, geo->VertexBufferUploader);
 
-    SubmeshGeometry subMesh;
-    subMesh.BaseVertexLocation = 0;
-    subMesh.StartIndexLocation = 0;
-    subMesh.IndexCount = (UINT)indices.size();
+    geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(md3dDevice.Get(), mCommandList.Get(),
+        geo->IndexBufferCPU->GetBufferPointer(), geo->IndexBufferByteSize, geo->IndexBufferUploader);
 
-    geo->DrawArgs["skull"] = subMesh;
     mGeometries[geo->Name] = std::move(geo);
 }
@@ -8,6 +8,14 @@
 #include "Material.h"
 #include "GameTimer.h"
 #include "Waves.h"
+#include "FenceWaiter.h"
+#include "DirtyList.h"
+#include "FrustumCulling.h"
+#include "DrawSort.h"
+#include "DrawStateCache.h"
+#include "HeadlessBenchmarkDesc.h"
+#include "RenderItem.h"
+#include "FrameStages.h"
 
 #pragma comment(lib,"d3dcompiler.lib")
 #pragma comment(lib, "d3d12.lib")
@@ -15,36 +23,6 @@
 
 class FTextureManager;
 
-struct RenderItem
-{
-public:
-	DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
-	DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
-
-	int NumFramesDirty = NUM_FRAME_RESOURCES;
-	
-	UINT ObjectCBIndex = -1;
-
-	Material* Mat = nullptr;
-	MeshGeometry* Geo = nullptr;
-
-	D3D12_PRIMITIVE_TOPOLOGY PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-
-	UINT IndexCount = 0;
-	UINT StartIndexLocation = 0;
-	UINT BaseVertexLocation = 0;
-};
-
-enum class RenderLayer : int
-{
-	Opaque = 0,
-	Mirrors,
-	Reflected,
-	Transparent,
-	Shadow,
-	Count,
-};
-
 class D3D12
 {
 public:
@@ -66,6 +44,16 @@ public:
 	bool Initialize();
 	int Run();
 
+	// Runs the per-frame CPU update stages against a synthetic scene with system-memory
+	// frame resources; no window or device is created.  Prints mean/p50/p99 per stage.
+	int RunHeadlessBenchmark(const HeadlessBenchmarkDesc& Desc);
+
+	void SetMaxFrameLatency(std::uint32_t MaxFrameLatency) { mMaxFrameLatency = MaxFrameLatency; }
+
+	// Sets the depth of the frame-resource ring.  Before Initialize this only records the
+	// value; afterwards it drains the GPU, rebuilds the ring and re-dirties every constant.
+	void SetFrameResourceCount(int Count);
+
 	LRESULT CALLBACK MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 protected:
@@ -123,6 +111,10 @@ protected:
 
 	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
 	UINT64 mCurrentFence = 0;
+	FenceWaiter mFenceWaiter;
+
+	// Most frames the CPU may queue ahead of the GPU; 0 leaves only the frame resource limit.
+	std::uint32_t mMaxFrameLatency = 0;
 	
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCommandQueue;
 	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mDirectCmdListAlloc;
@@ -158,6 +150,7 @@ private:
 	void UpdateMainPassCBs(const GameTimer& gt);
 	void UpdateMaterialCBs(const GameTimer& gt);
 	void UpdateWaves(const GameTimer& gt);
+	void UpdateTerrainLods();
 	void UpdateReflectedPassCB(const GameTimer& gt);
 
 	void LoadTextures();
@@ -169,7 +162,14 @@ private:
 	void BuildFrameResources();
 	void BuildMaterials();
 	void BuildRenderItems();
-	void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& RenderItems);
+	void BuildInstancedRenderItems();
+	void CullRenderItems();
+	void SortRenderItems();
+	void UpdateInstanceBuffer();
+	void SetPassState(ID3D12GraphicsCommandList* cmdList);
+	DrawStateStats RecordDrawChunk(int Chunk, int ChunkCount);
+	DrawStateStats DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& RenderItems, size_t Begin, size_t End);
+	DrawStateStats DrawInstancedRenderItems(ID3D12GraphicsCommandList* cmdList);
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 6> GetStaticSamplers();
 
@@ -208,12 +208,45 @@ private:
 	// Render items divided by PSO
 	std::vector<RenderItem*> mRitemLayer[(int)RenderLayer::Count];
 
+	// Render items and materials whose constants some frame resource hasn't received yet.
+	DirtyList<RenderItem> mDirtyRitems;
+	DirtyList<Material> mDirtyMaterials;
+
+	// World-space bounds of every render item, indexed by ObjectCBIndex, and the result of
+	// this frame's culling.
+	SphereCullSet mCullSet;
+	std::vector<std::uint8_t> mRitemVisible;
+	std::vector<RenderItem*> mVisibleRitems[(int)RenderLayer::Count];
+
+	// Instanced render items and the world bounds of all their instances.
+	std::vector<std::unique_ptr<InstancedRenderItem>> mInstancedRitems;
+	SphereCullSet mInstanceCullSet;
+	std::vector<std::uint8_t> mInstanceVisible;
+
+	// Per-frame scratch for SortRenderItems.
+	DrawSortScratch mDrawSortScratch;
+
+	// Binds recorded and elided by DrawRenderItems in the last frame.
+	DrawStateStats mDrawStateStats;
+
+	// Worker command lists per frame resource, and how many the last frame recorded.
+	int mRecordWorkerCount = 1;
+	int mDrawChunkCount = 0;
+
 	PassConstants mMainPassCB;
 	PassConstants ReflectedPassCB;
 	UINT PassCbvOffset = 0;
 
+	// Terrain tiles, one render item per tile, whose LOD and stitch mask UpdateTerrainLods
+	// picks from the eye position every frame.
+	GeometryGenerator::TerrainData mTerrain;
+	std::vector<RenderItem*> mTerrainRitems;
+	std::vector<std::uint32_t> mTerrainLods;
+	std::vector<std::uint32_t> mTerrainStitchMasks;
+
 	RenderItem* WavesRenderItem = nullptr;
 	std::unique_ptr<Waves> mWaves;
+	std::vector<std::pair<int, int>> mWavesDirtyRows;
 
 private:
 	DirectX::XMFLOAT3 mEyePos = { 0.f, 0.f, 0.f };
@@ -2,6 +2,42 @@
 #include <Windows.h>
 #include "d3dUtil.h"
 #include "d3dApp.h"
+#include "MeshLoader.h"
+#include "CommandLineOptions.h"
+#include <shellapi.h>
+
+namespace
+{
+	// Command-line tokens after the executable name, quoted the usual Windows way.
+	std::vector<std::wstring> GetArguments()
+	{
+		std::vector<std::wstring> Args;
+		int Count = 0;
+		if (LPWSTR* Argv = CommandLineToArgvW(GetCommandLineW(), &Count))
+		{
+			Args.assign(Argv + (Count > 0 ? 1 : 0), Argv + Count);
+			LocalFree(Argv);
+		}
+		return Args;
+	}
+
+	std::string ToUtf8(const std::wstring& Text)
+	{
+		const int Size = WideCharToMultiByte(CP_UTF8, 0, Text.c_str(), (int)Text.size(), nullptr, 0, nullptr, nullptr);
+		std::string Result(Size, '\0');
+		WideCharToMultiByte(CP_UTF8, 0, Text.c_str(), (int)Text.size(), &Result[0], Size, nullptr, nullptr);
+		return Result;
+	}
+
+	void AttachParentConsole()
+	{
+		FILE* Console = nullptr;
+		if (AttachConsole(ATTACH_PARENT_PROCESS))
+		{
+			freopen_s(&Console, "CONOUT$", "w", stdout);
+		}
+	}
+}
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, int showCmd)
 {
@@ -10,9 +46,58 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, in
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 #endif
 
+	const std::vector<std::wstring> Args = GetArguments();
+
+	// "-convert model.txt model.wem submesh" builds the binary mesh cache offline, e.g. for
+	// shipping Models/*.wem, and exits without creating a window.
+	if (!Args.empty() && Args[0] == L"-convert")
+	{
+		AttachParentConsole();
+		if (Args.size() != 4)
+		{
+			printf("usage: -convert model.txt model.wem submesh\n");
+			return 1;
+		}
+
+		const bool Converted = MeshLoader::ConvertTextMesh(Args[1], Args[2], ToUtf8(Args[3]));
+		printf("%s %s\n", Converted ? "Wrote" : "Failed to convert to", ToUtf8(Args[2]).c_str());
+		return Converted ? 0 : 1;
+	}
+
 	try
 	{
+		std::vector<std::string> Tokens;
+		for (const std::wstring& Arg : Args)
+		{
+			Tokens.push_back(ToUtf8(Arg));
+		}
+		const CommandLineOptions Options(Tokens);
+
+		// "-benchmark [frames=N] [items=N] [instances=N] [materials=N] [waves=N] [trace=file.json] [frameresources=N]"
+		// runs the CPU frame pipeline headless and prints the stage timings to the parent console.
+		if (Options.HasFlag("-benchmark"))
+		{
+			AttachParentConsole();
+
+			HeadlessBenchmarkDesc Desc;
+			Desc.ReadOptions(Options);
+
+			D3D12 Benchmark(hInstance);
+			return Benchmark.RunHeadlessBenchmark(Desc);
+		}
+
+		// "latency=N" caps how many frames the CPU may queue ahead of the GPU.
+		// "frameresources=N" sets the depth of the frame-resource ring (F8 cycles it at runtime).
+		Options.CheckKeys({ "latency", "frameresources" });
+		int MaxFrameLatency = 0;
+		int FrameResourceCount = NUM_FRAME_RESOURCES;
+		Options.Read("latency", 0, MaxFrameLatency);
+		Options.Read("frameresources", 1, FrameResourceCount);
+
 		D3D12 Renderer(hInstance);
+		Renderer.SetMaxFrameLatency((std::uint32_t)MaxFrameLatency);
+		Renderer.SetFrameResourceCount(FrameResourceCount);
+
 		if (!Renderer.Initialize())
 			return 0;
 
@@ -23,4 +108,11 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance, PSTR cmdLine, in
 		MessageBox(nullptr, e.ToString().c_str(), L"HR Failed", MB_OK);
 		return 0;
 	}
+	catch (std::exception& e)
+	{
+		// Bad command-line options land here too; the console, if any, is already attached.
+		printf("%s\n", e.what());
+		MessageBoxA(nullptr, e.what(), "Error", MB_OK);
+		return 1;
+	}
 }
\ No newline at end of file